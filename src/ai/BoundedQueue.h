@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QtGlobal>
+#include <deque>
+#include <utility>
+
+// Blocking FIFO with a fixed capacity, linking the stages of the indexing pipeline.
+//
+// push() blocks while the queue is full (back-pressure: a fast producer cannot run arbitrarily
+// far ahead), pop() blocks while it is empty. close() ends the stream: consumers drain what is
+// left and then pop() returns false. abort() ends it immediately, dropping queued items and
+// waking every blocked producer and consumer.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity) : capacity_(qMax(1, capacity)) {}
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // False when the queue was closed or aborted (the item is dropped)
+    bool push(T item) {
+        QMutexLocker lock(&mutex_);
+        while (!closed_ && int(items_.size()) >= capacity_) notFull_.wait(&mutex_);
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        highWater_ = qMax(highWater_, int(items_.size()));
+        notEmpty_.wakeOne();
+        return true;
+    }
+
+    // False once the queue is closed and drained, or aborted
+    bool pop(T* out) {
+        QMutexLocker lock(&mutex_);
+        while (items_.empty() && !closed_) notEmpty_.wait(&mutex_);
+        if (items_.empty()) return false;
+        *out = std::move(items_.front());
+        items_.pop_front();
+        notFull_.wakeOne();
+        return true;
+    }
+
+    void close() {
+        QMutexLocker lock(&mutex_);
+        closed_ = true;
+        notEmpty_.wakeAll();
+        notFull_.wakeAll();
+    }
+
+    void abort() {
+        QMutexLocker lock(&mutex_);
+        closed_ = true;
+        items_.clear();
+        notEmpty_.wakeAll();
+        notFull_.wakeAll();
+    }
+
+    int size() const { QMutexLocker lock(&mutex_); return int(items_.size()); }
+    int capacity() const { return capacity_; }
+    // Largest depth observed since construction
+    int highWater() const { QMutexLocker lock(&mutex_); return highWater_; }
+
+private:
+    const int capacity_;
+    mutable QMutex mutex_;
+    QWaitCondition notEmpty_;
+    QWaitCondition notFull_;
+    std::deque<T> items_;
+    int highWater_ {0};
+    bool closed_ {false};
+};
@@ -0,0 +1,156 @@
+#include "ai/ChunkJournal.h"
+
+#include <QObject>
+#include <QSaveFile>
+#include <QtGlobal>
+#include <cstring>
+
+namespace {
+constexpr quint32 kJournalVersion = 2; // v2: keys include the provider
+constexpr qint64 kHeaderSize = 16;
+constexpr qint64 kDimOffset = 8;
+
+QByteArray header(int dim) {
+    QByteArray h(int(kHeaderSize), '\0');
+    std::memcpy(h.data(), "GCHJ", 4);
+    const quint32 version = kJournalVersion;
+    const qint32 d = dim;
+    std::memcpy(h.data() + 4, &version, sizeof version);
+    std::memcpy(h.data() + kDimOffset, &d, sizeof d);
+    return h;
+}
+}
+
+ChunkJournal::~ChunkJournal() { close(); }
+
+bool ChunkJournal::open(const QString& path, QString* err) {
+    close();
+    path_ = path;
+    file_.setFileName(path);
+    if (!file_.open(QIODevice::ReadWrite)) {
+        if (err) *err = QObject::tr("Falha ao abrir diário de chunks '%1': %2").arg(path, file_.errorString());
+        return false;
+    }
+    const qint64 size = file_.size();
+    bool valid = false;
+    if (size >= kHeaderSize) {
+        const QByteArray h = file_.read(kHeaderSize);
+        quint32 version = 0;
+        qint32 dim = 0;
+        std::memcpy(&version, h.constData() + 4, sizeof version);
+        std::memcpy(&dim, h.constData() + kDimOffset, sizeof dim);
+        valid = h.startsWith("GCHJ") && version == kJournalVersion && dim >= 0;
+        if (valid) dim_ = dim;
+    }
+    if (!valid) {
+        // New file, or unreadable: start over
+        dim_ = 0;
+        if (!file_.resize(0) || !file_.seek(0) || file_.write(header(0)) != kHeaderSize) {
+            if (err) *err = QObject::tr("Falha ao gravar diário de chunks '%1': %2").arg(path, file_.errorString());
+            close();
+            return false;
+        }
+        return true;
+    }
+    if (dim_ > 0) {
+        const qint64 records = (size - kHeaderSize) / recordSize();
+        const qint64 used = kHeaderSize + records * recordSize();
+        if (used < size) file_.resize(used); // torn tail of an interrupted append
+        if (records > 0) map_ = file_.map(0, used);
+        if (map_) {
+            loadedRecords_ = records;
+            offsets_.reserve(int(records));
+            for (qint64 r = 0; r < records; ++r) {
+                const qint64 off = kHeaderSize + r * recordSize();
+                offsets_.insert(QByteArray(reinterpret_cast<const char*>(map_ + off), kKeySize), off + kKeySize);
+            }
+        }
+    }
+    file_.seek(file_.size());
+    return true;
+}
+
+void ChunkJournal::close() {
+    if (map_) { file_.unmap(const_cast<uchar*>(map_)); map_ = nullptr; }
+    offsets_.clear();
+    if (file_.isOpen()) file_.close();
+    dim_ = 0;
+    loadedRecords_ = 0;
+    appended_ = 0;
+}
+
+QVector<float> ChunkJournal::lookup(const QByteArray& key) const {
+    const auto it = offsets_.constFind(key);
+    if (it == offsets_.constEnd()) return {};
+    QVector<float> v(dim_);
+    std::memcpy(v.data(), map_ + it.value(), size_t(dim_) * sizeof(float));
+    return v;
+}
+
+bool ChunkJournal::append(const QByteArray& key, const float* v, int dim, QString* err) {
+    if (!file_.isOpen() || key.size() != kKeySize || dim <= 0) {
+        if (err) *err = QObject::tr("Diário de chunks não está aberto.");
+        return false;
+    }
+    if (dim_ == 0) {
+        // First vector fixes the dimension recorded in the header
+        const qint32 d = dim;
+        if (!file_.seek(kDimOffset) || file_.write(reinterpret_cast<const char*>(&d), sizeof d) != qint64(sizeof d)
+            || !file_.seek(file_.size())) {
+            if (err) *err = QObject::tr("Falha ao gravar diário de chunks '%1': %2").arg(path_, file_.errorString());
+            return false;
+        }
+        dim_ = dim;
+    } else if (dim != dim_) {
+        if (err) *err = QObject::tr("Dimensão %1 difere da do diário de chunks (%2).").arg(dim).arg(dim_);
+        return false;
+    }
+    const qint64 bytes = qint64(dim) * qint64(sizeof(float));
+    if (file_.write(key) != kKeySize || file_.write(reinterpret_cast<const char*>(v), bytes) != bytes) {
+        if (err) *err = QObject::tr("Falha ao gravar diário de chunks '%1': %2").arg(path_, file_.errorString());
+        return false;
+    }
+    ++appended_;
+    return true;
+}
+
+bool ChunkJournal::flush() {
+    return file_.isOpen() && file_.flush();
+}
+
+bool ChunkJournal::compact(const QSet<QByteArray>& keep, QString* err) {
+    if (!file_.isOpen()) return false;
+    file_.flush();
+    const int dim = dim_;
+    const qint64 rec = recordSize();
+    if (map_) { file_.unmap(const_cast<uchar*>(map_)); map_ = nullptr; }
+    offsets_.clear();
+    QSaveFile out(path_);
+    bool ok = out.open(QIODevice::WriteOnly) && out.write(header(dim)) == kHeaderSize;
+    if (ok && dim > 0) {
+        QSet<QByteArray> written;
+        file_.seek(kHeaderSize);
+        const qint64 batch = 256;
+        for (;;) {
+            const QByteArray block = file_.read(batch * rec);
+            if (block.size() < rec) break;
+            for (qint64 off = 0; off + rec <= block.size(); off += rec) {
+                const QByteArray k = block.mid(int(off), kKeySize);
+                if (!keep.contains(k) || written.contains(k)) continue;
+                written.insert(k);
+                if (out.write(block.constData() + off, rec) != rec) { ok = false; break; }
+            }
+            if (!ok) break;
+        }
+    }
+    if (!ok) {
+        if (err) *err = QObject::tr("Falha ao compactar diário de chunks '%1': %2").arg(path_, out.errorString());
+        out.cancelWriting();
+    }
+    close();
+    if (ok && !out.commit()) {
+        if (err) *err = QObject::tr("Falha ao compactar diário de chunks '%1': %2").arg(path_, out.errorString());
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+// Append-only journal of embedded chunks of one document, addressed by content (the
+// EmbeddingCache::key of the chunk text).
+//
+// The indexer appends every freshly embedded chunk and flushes after each written batch, so the
+// journal doubles as the checkpoint of an interrupted or failed run: the next run looks chunks up
+// here and only sends the provider what is missing. It is kept after a successful run too, which
+// makes re-indexing an edited document cost only the chunks whose text changed.
+//
+// File layout (little-endian): 16-byte header "GCHJ", u32 version, i32 dim, u32 reserved, then
+// fixed-size records [20-byte key][dim floats]. A torn last record is dropped on open.
+class ChunkJournal {
+public:
+    static constexpr int kKeySize = 20;
+
+    ChunkJournal() = default;
+    ~ChunkJournal();
+    ChunkJournal(const ChunkJournal&) = delete;
+    ChunkJournal& operator=(const ChunkJournal&) = delete;
+
+    // Maps the records already on disk and opens the file for appending (creating it if needed)
+    bool open(const QString& path, QString* err = nullptr);
+    void close();
+    bool isOpen() const { return file_.isOpen(); }
+
+    // Vector stored for key when open() found it, empty otherwise. Lookups only see the records
+    // present at open(), so they are safe from any thread while another one appends.
+    QVector<float> lookup(const QByteArray& key) const;
+    int loadedCount() const { return int(offsets_.size()); } // distinct keys
+    // Records in the file, duplicates included (a chunk text repeated in one run is appended twice)
+    qint64 recordCount() const { return loadedRecords_ + appended_; }
+    int dim() const { return dim_; }
+
+    bool append(const QByteArray& key, const float* v, int dim, QString* err = nullptr);
+    int appendedCount() const { return appended_; }
+    // Pushes appended records to the OS (the checkpoint); cheap enough to call per batch
+    bool flush();
+
+    // Rewrites the journal with the records whose key is in keep (drops text no longer present).
+    // Closes the journal.
+    bool compact(const QSet<QByteArray>& keep, QString* err = nullptr);
+
+private:
+    qint64 recordSize() const { return kKeySize + qint64(dim_) * qint64(sizeof(float)); }
+
+    QString path_;
+    QFile file_;
+    const uchar* map_ {nullptr};
+    QHash<QByteArray, qint64> offsets_; // key -> offset of its vector in map_
+    int dim_ {0};
+    qint64 loadedRecords_ {0};
+    int appended_ {0};
+};
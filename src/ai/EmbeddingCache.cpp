@@ -0,0 +1,262 @@
+#include "ai/EmbeddingCache.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSaveFile>
+#include <QtGlobal>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr quint32 kCacheVersion = 1;
+constexpr qint64 kHeaderSize = 8;
+constexpr qint32 kMaxDim = 65536;
+
+QByteArray header() {
+    QByteArray h(int(kHeaderSize), '\0');
+    std::memcpy(h.data(), "GECH", 4);
+    const quint32 version = kCacheVersion;
+    std::memcpy(h.data() + 4, &version, sizeof version);
+    return h;
+}
+}
+
+std::shared_ptr<EmbeddingCache> EmbeddingCache::open(const QString& dir, qint64 maxBytes) {
+    if (maxBytes <= 0 || dir.isEmpty()) return nullptr;
+    // Instances stay loaded for the life of the process: opening one scans the record headers
+    static QMutex registryMutex;
+    static QHash<QString, std::shared_ptr<EmbeddingCache>> registry;
+    const QString abs = QDir(dir).absolutePath();
+    QMutexLocker lock(&registryMutex);
+    if (auto shared = registry.value(abs)) {
+        shared->setMaxBytes(maxBytes);
+        return shared;
+    }
+    std::shared_ptr<EmbeddingCache> cache(new EmbeddingCache(abs, maxBytes));
+    if (!cache->load()) return nullptr;
+    registry.insert(abs, cache);
+    return cache;
+}
+
+QByteArray EmbeddingCache::key(const QString& provider, const QString& model, QStringView text) {
+    // Same normalization as EmbeddingProvider::embedBatch (\s+ -> ' ', trimmed): texts that
+    // produce the same request share a key
+    QString norm;
+    norm.reserve(text.size());
+    bool pendingSpace = false;
+    for (const QChar c : text) {
+        if (c.isSpace()) { pendingSpace = !norm.isEmpty(); continue; }
+        if (pendingSpace) { norm += QLatin1Char(' '); pendingSpace = false; }
+        norm += c;
+    }
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    h.addData(provider.toUtf8());
+    h.addData(QByteArray(1, '\0'));
+    h.addData(model.toUtf8());
+    h.addData(QByteArray(1, '\0'));
+    h.addData(norm.toUtf8());
+    return h.result();
+}
+
+EmbeddingCache::EmbeddingCache(const QString& dir, qint64 maxBytes)
+    : dir_(dir), maxBytes_(maxBytes) {}
+
+EmbeddingCache::~EmbeddingCache() {
+    QMutexLocker lock(&mutex_);
+    data_.flush();
+    touch_.flush();
+}
+
+bool EmbeddingCache::load() {
+    QDir().mkpath(dir_);
+    data_.setFileName(QDir(dir_).filePath(QStringLiteral("cache.gec")));
+    touch_.setFileName(QDir(dir_).filePath(QStringLiteral("cache.touch")));
+    if (!data_.open(QIODevice::ReadWrite) || !touch_.open(QIODevice::ReadWrite)) {
+        qWarning() << "[EmbeddingCache] cannot open" << dir_ << data_.errorString() << touch_.errorString();
+        return false;
+    }
+    const qint64 fileSize = data_.size();
+    const QByteArray h = data_.read(kHeaderSize);
+    if (fileSize < kHeaderSize || h != header()) {
+        // New or unreadable cache: start empty
+        data_.resize(0);
+        data_.seek(0);
+        data_.write(header());
+        touch_.resize(0);
+        size_ = kHeaderSize;
+        touchSize_ = 0;
+        return true;
+    }
+    // Scan the record headers; a torn last record is cut off
+    qint64 off = kHeaderSize;
+    while (off + kKeySize + 4 <= fileSize) {
+        data_.seek(off);
+        const QByteArray head = data_.read(kKeySize + 4);
+        if (head.size() != kKeySize + 4) break;
+        qint32 dim = 0;
+        std::memcpy(&dim, head.constData() + kKeySize, sizeof dim);
+        if (dim <= 0 || dim > kMaxDim || off + recordBytes(dim) > fileSize) break;
+        entries_.insert(head.left(kKeySize), Entry{ off, dim, ++tick_ });
+        off += recordBytes(dim);
+    }
+    if (off < fileSize) data_.resize(off);
+    size_ = off;
+    // Replay the hits recorded since the last eviction, oldest first
+    const QByteArray touched = touch_.readAll();
+    const int n = touched.size() / kKeySize;
+    for (int i = 0; i < n; ++i) {
+        auto it = entries_.find(touched.mid(i * kKeySize, kKeySize));
+        if (it != entries_.end()) it->tick = ++tick_;
+    }
+    if (touched.size() != n * kKeySize) touch_.resize(qint64(n) * kKeySize);
+    touchSize_ = qint64(n) * kKeySize;
+    touch_.seek(touchSize_);
+    data_.seek(size_);
+    qInfo() << "[EmbeddingCache] loaded" << entries_.size() << "entries," << size_ << "bytes from" << dir_;
+    if (n > kTouchCompactFactor * qMax(1, int(entries_.size()))) compactTouchLocked();
+    if (size_ + touchSize_ > maxBytes_) evictLocked();
+    return true;
+}
+
+bool EmbeddingCache::lookup(const QByteArray& key, QVector<float>* out) {
+    QMutexLocker lock(&mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return false;
+    const qint64 bytes = qint64(it->dim) * qint64(sizeof(float));
+    QVector<float> v(it->dim);
+    if (!data_.seek(it->offset + kKeySize + 4)
+        || data_.read(reinterpret_cast<char*>(v.data()), bytes) != bytes) {
+        entries_.erase(it);
+        data_.seek(size_);
+        return false;
+    }
+    data_.seek(size_);
+    it->tick = ++tick_;
+    *out = std::move(v);
+    if (touch_.write(key) == kKeySize) touchSize_ += kKeySize;
+    // A hot working set would otherwise grow the log without bound between evictions
+    if (touchSize_ / kKeySize > kTouchCompactFactor * qMax(1, int(entries_.size()))) compactTouchLocked();
+    if (size_ + touchSize_ > maxBytes_) evictLocked();
+    return true;
+}
+
+void EmbeddingCache::insert(const QByteArray& key, const QVector<float>& v) {
+    if (key.size() != kKeySize || v.isEmpty() || v.size() > kMaxDim) return;
+    QMutexLocker lock(&mutex_);
+    if (entries_.contains(key)) return;
+    const qint32 dim = qint32(v.size());
+    const qint64 bytes = qint64(dim) * qint64(sizeof(float));
+    data_.seek(size_);
+    if (data_.write(key) != kKeySize
+        || data_.write(reinterpret_cast<const char*>(&dim), sizeof dim) != qint64(sizeof dim)
+        || data_.write(reinterpret_cast<const char*>(v.constData()), bytes) != bytes) {
+        // Leave the file as it was; a partial record would be cut off on the next load anyway
+        data_.resize(size_);
+        data_.seek(size_);
+        return;
+    }
+    entries_.insert(key, Entry{ size_, dim, ++tick_ });
+    size_ += recordBytes(dim);
+    if (size_ + touchSize_ > maxBytes_) evictLocked();
+}
+
+void EmbeddingCache::flush() {
+    QMutexLocker lock(&mutex_);
+    data_.flush();
+    touch_.flush();
+}
+
+int EmbeddingCache::count() const {
+    QMutexLocker lock(&mutex_);
+    return int(entries_.size());
+}
+
+qint64 EmbeddingCache::sizeBytes() const {
+    QMutexLocker lock(&mutex_);
+    return size_ + touchSize_;
+}
+
+void EmbeddingCache::setMaxBytes(qint64 maxBytes) {
+    QMutexLocker lock(&mutex_);
+    maxBytes_ = maxBytes;
+    if (size_ + touchSize_ > maxBytes_) evictLocked();
+}
+
+void EmbeddingCache::evictLocked() {
+    // Most recently used first, kept up to 3/4 of the cap so eviction does not run on every insert
+    QVector<QPair<QByteArray, Entry>> order;
+    order.reserve(entries_.size());
+    for (auto it = entries_.cbegin(); it != entries_.cend(); ++it) order.append({ it.key(), it.value() });
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.second.tick > b.second.tick; });
+    const qint64 budget = maxBytes_ / 4 * 3;
+    qint64 kept = kHeaderSize;
+    int keep = 0;
+    while (keep < order.size() && kept + recordBytes(order[keep].second.dim) <= budget) kept += recordBytes(order[keep++].second.dim);
+    order.resize(keep);
+    // Rewrite oldest first, so positions encode recency for the next load
+    std::reverse(order.begin(), order.end());
+    data_.flush();
+    QSaveFile out(data_.fileName());
+    bool ok = out.open(QIODevice::WriteOnly) && out.write(header()) == kHeaderSize;
+    QHash<QByteArray, Entry> rewritten;
+    rewritten.reserve(order.size());
+    qint64 off = kHeaderSize;
+    quint64 tick = 0;
+    for (const auto& e : order) {
+        if (!ok) break;
+        const qint64 rec = recordBytes(e.second.dim);
+        data_.seek(e.second.offset);
+        const QByteArray bytes = data_.read(rec);
+        ok = bytes.size() == rec && out.write(bytes) == rec;
+        rewritten.insert(e.first, Entry{ off, e.second.dim, ++tick });
+        off += rec;
+    }
+    if (!ok) {
+        qWarning() << "[EmbeddingCache] eviction failed:" << out.errorString();
+        out.cancelWriting();
+        data_.seek(size_);
+        return;
+    }
+    data_.close();
+    ok = out.commit();
+    data_.open(QIODevice::ReadWrite);
+    if (!ok) {
+        qWarning() << "[EmbeddingCache] eviction failed:" << out.errorString();
+        data_.seek(size_);
+        return;
+    }
+    qInfo() << "[EmbeddingCache] evicted" << (entries_.size() - rewritten.size()) << "entries," << (size_ - off) << "bytes";
+    entries_ = std::move(rewritten);
+    tick_ = tick;
+    size_ = off;
+    touch_.resize(0);
+    touch_.seek(0);
+    touchSize_ = 0;
+    data_.seek(size_);
+}
+
+void EmbeddingCache::compactTouchLocked() {
+    // Replaying one key per entry, oldest first, restores the current order on the next load.
+    // Losing the log only loses recency, so it is rewritten in place.
+    QVector<QPair<quint64, QByteArray>> order;
+    order.reserve(entries_.size());
+    for (auto it = entries_.cbegin(); it != entries_.cend(); ++it) order.append({ it.value().tick, it.key() });
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    QByteArray keys;
+    keys.reserve(int(order.size()) * kKeySize);
+    for (const auto& e : order) keys += e.second;
+    touch_.flush();
+    const qint64 before = touchSize_;
+    if (!touch_.resize(0) || !touch_.seek(0) || touch_.write(keys) != keys.size()) {
+        qWarning() << "[EmbeddingCache] touch log compaction failed:" << touch_.errorString();
+        touch_.resize(0);
+        touch_.seek(0);
+        touchSize_ = 0;
+        return;
+    }
+    touchSize_ = keys.size();
+    qInfo() << "[EmbeddingCache] touch log compacted" << before << "->" << touchSize_ << "bytes";
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <memory>
+
+// On-disk embedding cache shared by every document and by query embedding, keyed by
+// sha1(provider, model, normalized text). Lives under <emb/db_path>/embedding_cache.
+//
+// Records are appended to cache.gec ([20-byte key][i32 dim][dim floats]); hits are appended to
+// cache.touch so recency survives restarts. Once the touch log holds more than
+// kTouchCompactFactor keys per entry, it is rewritten with one key per entry in recency order.
+// When both files together outgrow maxBytes, the data file is rewritten with the most recently
+// used entries up to 3/4 of the cap (LRU eviction) and the touch log is emptied.
+//
+// One instance per directory is shared through open() and kept for the life of the process;
+// every method is thread-safe.
+class EmbeddingCache {
+public:
+    static constexpr int kKeySize = 20;
+    static constexpr int kTouchCompactFactor = 4;
+
+    // Shared instance for dir; maxBytes <= 0 disables the cache (returns nullptr)
+    static std::shared_ptr<EmbeddingCache> open(const QString& dir, qint64 maxBytes);
+    // Key of text as sent by EmbeddingProvider (whitespace runs collapsed, trimmed)
+    static QByteArray key(const QString& provider, const QString& model, QStringView text);
+
+    ~EmbeddingCache();
+    EmbeddingCache(const EmbeddingCache&) = delete;
+    EmbeddingCache& operator=(const EmbeddingCache&) = delete;
+
+    bool lookup(const QByteArray& key, QVector<float>* out);
+    void insert(const QByteArray& key, const QVector<float>& v);
+    // Pushes pending appends (records and touches) to the OS
+    void flush();
+
+    int count() const;
+    qint64 sizeBytes() const; // data file + touch log
+    void setMaxBytes(qint64 maxBytes);
+
+private:
+    struct Entry { qint64 offset {0}; qint32 dim {0}; quint64 tick {0}; };
+
+    explicit EmbeddingCache(const QString& dir, qint64 maxBytes);
+    bool load();
+    void evictLocked();
+    // Rewrites the touch log with the key of every entry, least recently used first
+    void compactTouchLocked();
+    static qint64 recordBytes(qint32 dim) { return kKeySize + 4 + qint64(dim) * qint64(sizeof(float)); }
+
+    QString dir_;
+    qint64 maxBytes_ {0};
+    mutable QMutex mutex_;
+    QFile data_;
+    QFile touch_;
+    QHash<QByteArray, Entry> entries_;
+    quint64 tick_ {0};
+    qint64 size_ {0};      // of the data file
+    qint64 touchSize_ {0}; // of the touch log
+};
@@ -1,18 +1,88 @@
 #include "ai/EmbeddingIndexer.h"
+#include "ai/ParallelPageExtractor.h"
+#include "ai/BoundedQueue.h"
+#include "ai/ChunkJournal.h"
+#include "ai/EmbeddingCache.h"
+#include "ai/FullTextIndex.h"
+#include "ai/PageTextCache.h"
+#include "ai/TextChunker.h"
 
 #include <QFileInfo>
 #include <QDir>
 #include <QCryptographicHash>
-#include <QProcess>
-#include <QPdfDocument>
-#include <QJsonArray>
-#include <QJsonObject>
-#include <QJsonDocument>
-#include <QStandardPaths>
-#include <QUuid>
 #include <QThread>
 #include <QDebug>
 #include <QMutexLocker>
+#include <QMap>
+#include <QSet>
+#include <atomic>
+#include <numeric>
+#include <utility>
+
+namespace {
+// Admission control for the embedding workers of EmbeddingIndexer::run().
+//
+// Caps the requests in flight at an adaptive limit: halved when the provider throttles (at most
+// once per round of requests, so a burst of 429s from one round counts as one signal) and raised
+// by one after `limit` clean responses. A worker also may not start a batch more than `window`
+// batches past the writer, which bounds the out-of-order results the writer holds.
+class RequestGate {
+public:
+    RequestGate(int maxInFlight, int window)
+        : max_(qMax(1, maxInFlight)), limit_(max_), window_(qMax(1, window)) {}
+
+    // Blocks until a slot is free and seq is inside the window; false once closed
+    bool acquire(qint64 seq, int* ticket) {
+        QMutexLocker lock(&mutex_);
+        while (!closed_ && (inFlight_ >= limit_ || seq >= written_ + window_)) changed_.wait(&mutex_);
+        if (closed_) return false;
+        ++inFlight_;
+        *ticket = round_;
+        return true;
+    }
+
+    void release(int ticket, bool throttled) {
+        QMutexLocker lock(&mutex_);
+        --inFlight_;
+        if (throttled) {
+            // Requests started before the last decrease report stale news
+            if (ticket == round_) { limit_ = qMax(1, limit_ / 2); ++round_; clean_ = 0; }
+        } else if (limit_ < max_ && ++clean_ >= limit_) {
+            ++limit_;
+            clean_ = 0;
+        }
+        changed_.wakeAll();
+    }
+
+    // The writer has written every batch below seq
+    void advance(qint64 seq) {
+        QMutexLocker lock(&mutex_);
+        written_ = seq;
+        changed_.wakeAll();
+    }
+
+    void close() {
+        QMutexLocker lock(&mutex_);
+        closed_ = true;
+        changed_.wakeAll();
+    }
+
+    int limit() const { QMutexLocker lock(&mutex_); return limit_; }
+    int inFlight() const { QMutexLocker lock(&mutex_); return inFlight_; }
+
+private:
+    const int max_;
+    int limit_;
+    const int window_;
+    mutable QMutex mutex_;
+    QWaitCondition changed_;
+    int inFlight_ {0};
+    int clean_ {0};  // successes since the limit last changed
+    int round_ {0};  // bumped on every decrease
+    qint64 written_ {0};
+    bool closed_ {false};
+};
+}
 
 EmbeddingIndexer::EmbeddingIndexer(const Params& p, QObject* parent)
     : QObject(parent), p_(p) {}
@@ -35,139 +105,53 @@ void EmbeddingIndexer::waitIfPaused() {
     }
 }
 
-void EmbeddingIndexer::forEachChunks(const QString& text, int chunkSize, int overlap,
-                       const std::function<bool(QStringView, int)>& consume) {
-    // Minimal normalization: CR -> LF
-    QStringView fullView(text);
-    // parameter validation similar to chunkText
-    int cs = chunkSize;
-    if (cs <= 0) { emit warn(tr("chunkSize inválido (%1). Usando 1000.").arg(cs)); cs = 1000; }
-    int ov = overlap;
-    if (ov < 0) { emit warn(tr("overlap negativo (%1). Usando 100.").arg(ov)); ov = 100; }
-    if (ov >= cs) {
-        int newOv = qMax(0, cs / 4);
-        emit warn(tr("overlap (%1) >= chunkSize (%2). Ajustando overlap para %3.").arg(ov).arg(cs).arg(newOv));
-        ov = newOv;
-    }
-
-    // Work with indices over the original string to avoid large allocations
-    const int n = text.size();
-    if (n == 0) return;
-    int i = 0;
-    int localIdx = 0;
-    while (i < n) {
-        const int take = qMax(1, qMin(cs, n - i));
-        int j = i + take;
-        // Trim leading/trailing whitespace for the current chunk via indices
-        int start = i;
-        int end = j; // exclusive
-        // skip CR -> treat as LF replacement when creating view
-        while (start < end && text.at(start).isSpace()) ++start;
-        while (end > start && text.at(end - 1).isSpace()) --end;
-        if (end > start) {
-            QStringView v(fullView.mid(start, end - start));
-            if (!consume(v, localIdx)) {
-                // consumer requested to stop early
-                break;
-            }
-        }
-        // Emit metric sparsely to avoid flooding (every 1000 chunks)
-        if (((localIdx + 1) % 1000) == 0) {
-            emit metric(QStringLiteral("chunk"), QString::number(localIdx + 1));
-        }
-        int nextI = j - ov;
-        if (nextI <= i) nextI = i + take;
-        i = nextI;
-        ++localIdx;
-    }
-    // Final metric with total chunks processed for this call
-    emit metric(QStringLiteral("chunk_total"), QString::number(localIdx));
-}
-
-QStringList EmbeddingIndexer::extractPagesText() {
-    QStringList pages;
-    QPdfDocument doc;
-    auto st = doc.load(p_.pdfPath);
-    if (st != static_cast<QPdfDocument::Error>(0)) {
-        emit warn(tr("Falha ao abrir PDF para contagem de páginas."));
-        return pages;
-    }
-    const int pageCount = doc.pageCount();
-    emit metric(QStringLiteral("pages"), QString::number(pageCount));
-
-    const bool hasPdfToText = !QStandardPaths::findExecutable("pdftotext").isEmpty();
-    const bool hasPdfToPpm = !QStandardPaths::findExecutable("pdftoppm").isEmpty();
-    const bool hasTesseract = !QStandardPaths::findExecutable("tesseract").isEmpty();
-
-    if (!hasPdfToText) {
-        emit warn(tr("Ferramenta 'pdftotext' não encontrada. Instale o pacote 'poppler-utils' para extração de texto mais rápida."));
-    }
-    if (!hasTesseract) {
-        emit warn(tr("Ferramenta 'tesseract' não encontrada. Instale 'tesseract-ocr' para fallback via OCR."));
-    }
-
-    // Preferir pdftotext; fallback para pdftoppm+tesseract; por fim páginas vazias
-    for (int i = 1; i <= pageCount; ++i) {
-        if (QThread::currentThread()->isInterruptionRequested()) break;
-        QString pageText;
-        if (hasPdfToText) {
-            QProcess proc;
-            QStringList args; args << "-q" << "-layout" << "-eol" << "unix" << "-f" << QString::number(i) << "-l" << QString::number(i) << p_.pdfPath << "-";
-            proc.start("pdftotext", args);
-            if (proc.waitForStarted(2000)) {
-                proc.waitForFinished(20000);
-                pageText = QString::fromUtf8(proc.readAllStandardOutput());
-            }
-        }
-        if (pageText.trimmed().isEmpty() && hasPdfToPpm && hasTesseract) {
-            // Fallback: renderiza a página como PNG e roda OCR
-            const QString tmpDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-            QDir().mkpath(tmpDir);
-            const QString base = QUuid::createUuid().toString(QUuid::WithoutBraces);
-            const QString outPngBase = QDir(tmpDir).filePath(base);
-            // pdftoppm -f i -l i -r 200 -png pdf outPngBase
-            QProcess ppm;
-            QStringList a; a << "-f" << QString::number(i) << "-l" << QString::number(i) << "-r" << "200" << "-png" << p_.pdfPath << outPngBase;
-            ppm.start("pdftoppm", a);
-            if (ppm.waitForStarted(2000)) {
-                ppm.waitForFinished(30000);
-                const QString imgPath = outPngBase + "-" + QString::number(i) + ".png";
-                if (QFileInfo::exists(imgPath)) {
-                    QProcess ocr;
-                    QStringList ta; ta << imgPath << "stdout" << "-l" << "por+eng" << "--psm" << "6";
-                    ocr.start("tesseract", ta);
-                    if (ocr.waitForStarted(2000)) {
-                        ocr.waitForFinished(30000);
-                        pageText = QString::fromUtf8(ocr.readAllStandardOutput());
-                    }
-                    QFile::remove(imgPath);
-                }
-            }
-        }
-        if (pageText.isEmpty()) {
-            if (!hasPdfToText && !(hasPdfToPpm && hasTesseract)) {
-                emit warn(tr("Sem ferramentas de extração instaladas. Instale 'poppler-utils' (pdftotext) e/ou 'tesseract-ocr'."));
-            }
-        }
-        pages << pageText;
-    }
-    return pages;
-}
-
-
 QString EmbeddingIndexer::sha1(const QString& s) const {
     QCryptographicHash h(QCryptographicHash::Sha1);
     h.addData(s.toUtf8());
     return QString::fromLatin1(h.result().toHex());
 }
 
+void EmbeddingIndexer::emitPipelineMetrics(const PipelineCounters& c, qint64 elapsedMs, int pageDepth,
+                                           int batchDepth, int writeDepth, bool done) {
+    const double secs = qMax<qint64>(1, elapsedMs) / 1000.0;
+    auto rate = [secs](qint64 n) { return QString::number(double(n) / secs, 'f', 1); };
+    emit metric(QStringLiteral("extract_pages_per_s"), rate(c.pages));
+    emit metric(QStringLiteral("chunk_per_s"), rate(c.chunks));
+    emit metric(QStringLiteral("embed_chunks_per_s"), rate(c.embedded));
+    emit metric(QStringLiteral("write_rows_per_s"), rate(c.rows));
+    // Periodic samples report the current depth, the final call the high-water mark
+    const QString suffix = done ? QStringLiteral("_max") : QString();
+    emit metric(QStringLiteral("queue_pages") + suffix, QString::number(pageDepth));
+    emit metric(QStringLiteral("queue_batches") + suffix, QString::number(batchDepth));
+    emit metric(QStringLiteral("queue_write") + suffix, QString::number(writeDepth));
+}
+
 void EmbeddingIndexer::run() {
     QElapsedTimer total; total.start();
     emit stage(tr("Lendo PDF"));
     waitIfPaused();
-    const QStringList pages = extractPagesText();
-    const int pageCount = pages.size();
-    if (pageCount == 0) { emit error(tr("Sem páginas extraídas.")); emit finished(false, tr("Falha na extração de texto")); return; }
+    // Set when a stage fails or the run is interrupted; polled by the extraction and embed workers
+    std::atomic<bool> stop {false};
+    ParallelPageExtractor::Options xopt;
+    xopt.workers = p_.extractWorkers;
+    xopt.ocrWorkers = p_.ocrWorkers;
+    xopt.cancelled = [&stop]() { return stop.load(); };
+    ParallelPageExtractor extractor(p_.pdfPath, xopt);
+    QString extractErr;
+    const int pageCount = extractor.pageCount(&extractErr);
+    if (pageCount <= 0) {
+        emit warn(tr("Falha ao abrir PDF para contagem de páginas."));
+        emit error(tr("Sem páginas extraídas."));
+        emit finished(false, tr("Falha na extração de texto"));
+        return;
+    }
+    emit metric(QStringLiteral("pages"), QString::number(pageCount));
+    emit metric(QStringLiteral("extract_workers"), QString::number(extractor.workerCount()));
+    if (PageTextExtractor::hasOcr()) {
+        emit metric(QStringLiteral("ocr_workers"), QString::number(extractor.ocrWorkerCount()));
+    } else {
+        emit warn(tr("Ferramenta 'tesseract' não encontrada. Instale 'tesseract-ocr' para fallback via OCR."));
+    }
     qInfo() << "[EmbeddingIndexer] total pages to process=" << pageCount;
 
     // Preparar arquivos de saída (escrita incremental)
@@ -179,190 +163,540 @@ void EmbeddingIndexer::run() {
     fileBaseName.replace(':', '_');
     fileBaseName.replace('/', '_'); // e.g., sentence-transformers model IDs
     const QString base = QDir(p_.dbDir).filePath(fileBaseName);
-    const QString binPath = base + ".bin";
-    const QString idsPath = base + ".ids.json";
-    const QString metaPath = base + ".meta.json";
-    qInfo() << "[EmbeddingIndexer] output paths" << "bin=" << binPath << "ids=" << idsPath << "meta=" << metaPath;
+    const QString containerPath = base + ".gidx";
+    const QString hnswPath = base + ".hnsw";
+    const QString q8Path = base + ".q8";
+    const QString journalPath = base + ".chunks";
+    qInfo() << "[EmbeddingIndexer] output path" << containerPath;
 
-    QFile fb(binPath);
-    if (!fb.open(QIODevice::WriteOnly)) {
-        const QString em = tr("Falha ao abrir binário '%1' para escrita: %2").arg(binPath, fb.errorString());
-        emit error(em);
-        qCritical() << em;
-        emit finished(false, tr("Falha ao abrir binário"));
-        return;
+    // Vectors are streamed into a single GIDX container (vectors + norms + row table + strings);
+    // it replaces the .bin/.ids.json/.meta.json trio once finish() renames it into place
+    VectorIndex::ContainerWriter out;
+    {
+        QString em;
+        if (!out.open(containerPath, &em)) {
+            emit error(em);
+            qCritical() << em;
+            emit finished(false, tr("Falha ao abrir índice"));
+            return;
+        }
     }
-    // Header temporário: magic + count + dim(0)
-    fb.write("VEC1", 4);
-    int countInt = 0; // streaming mode: will be updated at the end with globalChunkIdx
-    int dimInt = 0; // desconhecido até a 1ª resposta
-    qint64 posCount = fb.pos();
-    fb.write(reinterpret_cast<const char*>(&countInt), sizeof(int));
-    qint64 posDim = fb.pos();
-    fb.write(reinterpret_cast<const char*>(&dimInt), sizeof(int));
+    const QString absPdfPath = QFileInfo(p_.pdfPath).absoluteFilePath();
 
-    QFile fids(idsPath);
-    if (!fids.open(QIODevice::WriteOnly)) {
-        const QString em = tr("Falha ao abrir ids '%1' para escrita: %2").arg(idsPath, fids.errorString());
-        emit error(em);
-        qCritical() << em;
-        fb.close(); QFile::remove(binPath);
-        emit finished(false, tr("Falha ao abrir ids"));
-        return;
+    // Chunks embedded by earlier runs (finished, interrupted or failed) are reused by content
+    ChunkJournal journal;
+    {
+        QString jerr;
+        if (!journal.open(journalPath, &jerr)) emit warn(jerr);
+        else if (journal.loadedCount() > 0) qInfo() << "[EmbeddingIndexer] chunk journal" << journalPath << "records=" << journal.loadedCount();
+        emit metric(QStringLiteral("cache_chunks"), QString::number(journal.loadedCount()));
     }
-    fids.write("["); bool firstId = true;
-
-    QFile fmeta(metaPath);
-    if (!fmeta.open(QIODevice::WriteOnly)) {
-        const QString em = tr("Falha ao abrir metadados '%1' para escrita: %2").arg(metaPath, fmeta.errorString());
-        emit error(em);
-        qCritical() << em;
-        fb.close(); fids.close(); QFile::remove(binPath); QFile::remove(idsPath);
-        emit finished(false, tr("Falha ao abrir meta"));
-        return;
+    // Then the embedding cache shared with other documents and with queries
+    const std::shared_ptr<EmbeddingCache> shared = EmbeddingCache::open(QDir(p_.dbDir).filePath(QStringLiteral("embedding_cache")), p_.cacheMaxBytes);
+    // Dimension of the reused vectors. A model replaced under the same name makes the journal and
+    // the shared cache entries of that name useless, so whenever either can supply vectors one
+    // short request checks the model's dimension up front: a stale journal is discarded, cache
+    // hits of another dimension count as misses, and those chunks are embedded again. When the
+    // provider cannot be reached here, the first fresh batch is checked against the journal
+    // instead (and a mismatch then fails the run).
+    int cachedDim = journal.loadedCount() > 0 ? journal.dim() : 0;
+    if (cachedDim > 0 || shared) {
+        try {
+            const QList<QVector<float>> probe = EmbeddingProvider(p_.providerCfg).embedBatch({ QStringLiteral("dimension check") });
+            const int modelDim = probe.isEmpty() ? 0 : int(probe.first().size());
+            if (cachedDim > 0 && modelDim > 0 && modelDim != cachedDim) {
+                emit warn(tr("Os vetores do diário de chunks (dimensão %1) não correspondem aos do modelo (dimensão %2). O diário foi descartado e todos os chunks serão recalculados.")
+                              .arg(cachedDim).arg(modelDim));
+                journal.close();
+                QFile::remove(journalPath);
+                QString jerr;
+                if (!journal.open(journalPath, &jerr)) emit warn(jerr);
+            }
+            if (modelDim > 0) cachedDim = modelDim;
+        } catch (const std::exception& ex) {
+            qWarning() << "[EmbeddingIndexer] dimension check failed:" << ex.what();
+        }
     }
-    fmeta.write("["); bool firstMeta = true;
+    std::atomic<bool> staleJournal {false};
 
+    // Pipeline: extraction (worker pool) -> chunking -> embedding (request workers) -> writer.
+    // Stages run concurrently and hand work over bounded queues, so the network is busy while
+    // pages are still being read, and memory does not grow with the size of the book.
     emit stage(tr("Gerando embeddings"));
-    EmbeddingProvider prov(p_.providerCfg);
-    const int bs = qMax(1, p_.batchSize);
-    qint64 processed = 0; // number of chunks processed
-    int globalChunkIdx = 0;
-    int pagesProcessed = 0;
-    for (int i=0;i<pageCount;++i) {
-        waitIfPaused();
-        if (QThread::currentThread()->isInterruptionRequested()) { emit warn(tr("Interrompido")); break; }
-        emit metric(QStringLiteral("page"), QString::number(i+1));
-        QStringList batchTexts; batchTexts.reserve(bs);
-        QList<QPair<int,int>> batchLocs; batchLocs.reserve(bs);
+    BoundedQueue<PageItem> pageQueue(kPageQueueCapacity);
+    BoundedQueue<ChunkBatch> batchQueue(kBatchQueueCapacity);
+    BoundedQueue<VectorBatch> writeQueue(kWriteQueueCapacity);
+    PipelineCounters counters;
+    auto abortPipeline = [&]() {
+        stop = true;
+        pageQueue.abort();
+        batchQueue.abort();
+        writeQueue.abort();
+    };
 
-        auto processBatch = [&](bool finalFlush=false) -> bool {
-            if (batchTexts.isEmpty()) return true;
-            waitIfPaused();
-            // Embedding do lote
-            QList<QVector<float>> vecs;
-            // Log batch details prior to external API call
-            {
-                const int totalChars = std::accumulate(batchTexts.begin(), batchTexts.end(), 0, [](int s, const QString& t){ return s + t.size(); });
-                qInfo() << "[EmbeddingIndexer] embedding batch start"
-                        << "provider=" << p_.providerCfg.provider
-                        << "model=" << p_.providerCfg.model
-                        << "baseUrl=" << p_.providerCfg.baseUrl
-                        << "page=" << (i+1)
-                        << "batch_size=" << batchTexts.size()
-                        << "chars_total=" << totalChars;
+    // Text of an earlier extraction of this same file (by the indexer or the viewer) replaces
+    // QtPdf, pdftotext and OCR. A cache the viewer built without OCR is only reused when it has
+    // no blank page left for OCR to read.
+    const QString pagesCachePath = PageTextCache::pathFor(p_.dbDir, p_.pdfPath);
+    const bool ocr = xopt.ocr && PageTextExtractor::hasOcr();
+    PageTextCache pagesCache;
+    bool pagesCached = false;
+    {
+        QString cerr;
+        if (pagesCache.load(pagesCachePath, p_.pdfPath, &cerr) && pagesCache.pageCount() == pageCount) {
+            bool blankLeft = false;
+            for (int pg = 1; pg <= pageCount && !blankLeft; ++pg)
+                blankLeft = pagesCache.source(pg) == PageTextExtractor::Source::None;
+            pagesCached = pagesCache.ocrApplied() || !ocr || !blankLeft;
+        } else if (!cerr.isEmpty()) {
+            emit warn(cerr);
+        }
+        if (!pagesCached) pagesCache.reset(pageCount, ocr);
+        emit metric(QStringLiteral("pages_cached"), QString::number(pagesCached ? pageCount : 0));
+    }
+    QString pagesCacheErr;
+    // Inverted index for the plain-text search, built from the same complete text
+    const QString ftsPath = FullTextIndex::pathFor(p_.dbDir, p_.pdfPath);
+    QString ftsErr;
+    std::atomic<qint64> ftsMs {-1};
+    std::atomic<int> ftsTerms {0};
+
+    QElapsedTimer extractTimer; extractTimer.start();
+    std::atomic<qint64> extractMs {0};
+    QThread* extractThread = QThread::create([&]() {
+        auto deliver = [&](int page, const QString& text, PageTextExtractor::Source src) {
+            if (src == PageTextExtractor::Source::QtPdf) ++counters.fromQtPdf;
+            else if (src == PageTextExtractor::Source::PdfToText) ++counters.fromPdfToText;
+            else if (src == PageTextExtractor::Source::Ocr) ++counters.fromOcr;
+            ++counters.pages;
+            return pageQueue.push(PageItem{ page, text });
+        };
+        bool complete = false;
+        if (pagesCached) {
+            int pg = 1;
+            for (; pg <= pageCount && !stop; ++pg)
+                if (!deliver(pg, pagesCache.text(pg), pagesCache.source(pg))) break;
+            complete = pg > pageCount;
+        } else {
+            const int delivered = extractor.run([&](int page, const QString& text, PageTextExtractor::Source src) {
+                pagesCache.setPage(page, text, src);
+                return deliver(page, text, src);
+            }, &extractErr);
+            // Only a complete extraction is kept; the viewer and later runs read it back
+            complete = delivered == pageCount;
+            if (complete) pagesCache.save(pagesCachePath, p_.pdfPath, &pagesCacheErr);
+        }
+        extractMs = extractTimer.elapsed();
+        pageQueue.close();
+        // Off the pipeline's critical path: chunking and embedding go on meanwhile. Text reused
+        // from the cache keeps an index that is still current.
+        if (complete && !stop && (!pagesCached || !FullTextIndex::isCurrent(ftsPath, p_.pdfPath))) {
+            QElapsedTimer ftsTimer; ftsTimer.start();
+            FullTextIndex fts;
+            fts.build(pagesCache.texts());
+            if (fts.save(ftsPath, p_.pdfPath, &ftsErr)) {
+                ftsMs = ftsTimer.elapsed();
+                ftsTerms = fts.termCount();
             }
-            try { vecs = prov.embedBatch(batchTexts); }
-            catch (const std::exception& ex) {
-                const QString em = tr("Falha em embedBatch (page=%1, batch=%2): %3").arg(i+1).arg(batchTexts.size()).arg(QString::fromUtf8(ex.what()));
-                emit error(em);
-                qCritical() << em;
-                return false;
+        }
+    });
+
+    const int bs = qMax(1, p_.batchSize);
+    const int charBudget = qMax(0, p_.batchMaxChars);
+    TextChunker::Params cp;
+    cp.strategy = p_.chunkStrategy;
+    cp.unit = p_.chunkUnit;
+    cp.size = p_.chunkSize;
+    cp.overlap = p_.chunkOverlap;
+    cp.spanPages = p_.chunkSpanPages;
+    QStringList chunkWarnings;
+    TextChunker chunker(cp, &chunkWarnings);
+    for (const QString& w : chunkWarnings) emit warn(w);
+    QThread* chunkThread = QThread::create([&]() {
+        // Batches span page boundaries: a request is sent once batchSize chunks (or batchMaxChars
+        // characters) are collected, not at the end of every page, so short pages do not turn
+        // into requests with one or two inputs. Each chunk carries its own page.
+        // Chunks found in the journal or the shared cache ride along with their vector and do not
+        // count toward the request size; a batch made only of them never reaches the provider.
+        qint64 seq = 0;
+        ChunkBatch batch;
+        int batchChars = 0;
+        auto flush = [&]() {
+            batch.seq = seq++;
+            batchChars = 0;
+            return batchQueue.push(std::exchange(batch, ChunkBatch{}));
+        };
+        bool open = true;
+        const TextChunker::Consumer consume = [&](const TextChunker::Chunk& chunk) -> bool {
+            const QStringView v(chunk.text);
+            const QByteArray key = EmbeddingCache::key(p_.providerCfg.provider, p_.providerCfg.model, v);
+            QVector<float> cached = journal.lookup(key);
+            VectorSource source = VectorSource::Journal;
+            if (cached.isEmpty()) {
+                source = shared && shared->lookup(key, &cached) && (cachedDim == 0 || cached.size() == cachedDim)
+                             ? VectorSource::Cache : VectorSource::Provider;
+                if (source == VectorSource::Provider) cached.clear();
             }
-            qInfo() << "[EmbeddingIndexer] embedding batch ok"
-                    << "vectors=" << vecs.size()
-                    << "dim=" << (vecs.isEmpty() ? 0 : vecs.first().size());
-            // Ensure files are open before writing
-            if (!fb.isOpen() || !fids.isOpen() || !fmeta.isOpen()) {
-                const QString em = tr("Arquivos de saída não estão abertos para escrita (fb=%1, fids=%2, fmeta=%3).")
-                                      .arg(fb.isOpen()).arg(fids.isOpen()).arg(fmeta.isOpen());
-                emit error(em);
-                qCritical() << em;
+            const bool hit = source != VectorSource::Provider;
+            // A chunk that would overflow the character budget starts the next batch
+            if (!hit && charBudget > 0 && batch.misses > 0 && batchChars + int(v.size()) > charBudget && !(open = flush()))
                 return false;
+            batch.texts << (hit ? QString() : chunk.text);
+            batch.pages << chunk.page;
+            batch.chunks << chunk.index;
+            batch.spans << ChunkSpan{ chunk.startOffset, chunk.endPage, chunk.endOffset };
+            batch.keys << key;
+            batch.cached << cached;
+            batch.sources << source;
+            ++counters.chunks;
+            if (source == VectorSource::Journal) {
+                ++counters.cacheHits;
+            } else if (source == VectorSource::Cache) {
+                ++counters.sharedHits;
+            } else {
+                ++batch.misses;
+                batchChars += int(v.size());
             }
-            // Inicializar dim na 1ª vez
-            if (dimInt == 0 && !vecs.isEmpty()) {
-                dimInt = vecs.first().size();
-                qint64 cur = fb.pos(); fb.seek(posDim); fb.write(reinterpret_cast<const char*>(&dimInt), sizeof(int)); fb.seek(cur);
+            if (batch.misses < bs && batch.texts.size() < kMaxBatchItems * bs) return true;
+            return open = flush();
+        };
+        // A chunk may span pages, so the chunker holds the one in progress until it is complete
+        PageItem item;
+        while (open && pageQueue.pop(&item)) {
+            if (!chunker.addPage(item.page, item.text, consume)) break;
+        }
+        if (open && !stop) chunker.finish(consume);
+        if (open && !batch.texts.isEmpty()) flush();
+        batchQueue.close();
+    });
+
+    // Up to maxInFlight requests run at once, one provider per worker thread. The gate lowers the
+    // limit when the provider throttles and keeps workers within a window of the writer.
+    const int embedWorkers = qMax(1, p_.maxInFlight);
+    RequestGate gate(embedWorkers, qMax(kWriteQueueCapacity, 4 * embedWorkers));
+    QMutex errMutex; // guards embedErr and failedPage
+    QString embedErr;
+    int failedPage = 0;
+    std::atomic<qint64> throttledCount {0};
+    auto failEmbed = [&](const QString& m, int page) {
+        {
+            QMutexLocker lock(&errMutex);
+            if (!embedErr.isEmpty()) return;
+            embedErr = m;
+            failedPage = page;
+        }
+        gate.close();
+        abortPipeline();
+    };
+
+    // Persistir vetores + linha da tabela (id, página, chunk, arquivo, modelo, provedor).
+    // Batches arrive in completion order; rows are written strictly by seq, so chunk ids are the
+    // same as with a single request in flight. Freshly embedded chunks also go to the journal,
+    // flushed after every batch so an interrupted run can pick up from there.
+    QString writeErr;
+    QString journalErr; // journaling is best effort: on failure the run continues without it
+    QSet<QByteArray> writtenKeys;
+    std::atomic<int> writtenPage {0};
+    QThread* writeThread = QThread::create([&]() {
+        QMap<qint64, VectorBatch> pending;
+        qint64 nextSeq = 0;
+        VectorBatch batch;
+        while (writeQueue.pop(&batch)) {
+            pending.insert(batch.seq, std::move(batch));
+            while (pending.contains(nextSeq)) {
+                const VectorBatch ready = pending.take(nextSeq);
+                for (int k = 0; k < ready.vectors.size(); ++k) {
+                    const QVector<float>& v = ready.vectors[k];
+                    VectorIndex::ContainerWriter::RowMeta meta;
+                    meta.id = int(counters.rows.load());
+                    meta.page = ready.pages.value(k);
+                    meta.chunk = ready.chunks.value(k);
+                    const ChunkSpan span = ready.spans.value(k);
+                    meta.startOffset = span.startOffset;
+                    meta.endPage = span.endPage;
+                    meta.endOffset = span.endOffset;
+                    meta.file = absPdfPath;
+                    meta.model = p_.providerCfg.model;
+                    meta.provider = p_.providerCfg.provider;
+                    if (!out.append(v.constData(), int(v.size()), meta, &writeErr)) {
+                        gate.close();
+                        abortPipeline();
+                        return;
+                    }
+                    ++counters.rows;
+                    const QByteArray& key = ready.keys.at(k);
+                    const VectorSource source = ready.sources.at(k);
+                    writtenKeys.insert(key);
+                    if (source != VectorSource::Journal && journalErr.isEmpty() && journal.isOpen()
+                        && !journal.append(key, v.constData(), int(v.size()), &journalErr)) {
+                        qWarning() << "[EmbeddingIndexer]" << journalErr;
+                    }
+                    if (source == VectorSource::Provider && shared) shared->insert(key, v);
+                }
+                if (journalErr.isEmpty()) journal.flush();
+                if (shared) shared->flush();
+                writtenPage = ready.pages.isEmpty() ? writtenPage.load() : ready.pages.last();
+                gate.advance(++nextSeq);
             }
-            // Persistir vetores/ids/meta
-            for (int k=0;k<vecs.size();++k) {
-                const QVector<float>& v = vecs[k];
-                if (fb.write(reinterpret_cast<const char*>(v.data()), sizeof(float)*v.size()) <= 0) {
-                    const QString em = tr("Falha ao escrever vetor no arquivo binário '%1': %2").arg(binPath, fb.errorString());
-                    emit error(em);
-                    qCritical() << em;
-                    return false;
+        }
+    });
+
+    auto embedWorker = [&]() {
+        EmbeddingProvider prov(p_.providerCfg);
+        ChunkBatch batch;
+        while (batchQueue.pop(&batch)) {
+            waitIfPaused();
+            if (stop) return;
+            // Only the chunks missing from the journal go to the provider
+            QStringList request;
+            request.reserve(batch.misses);
+            for (int k = 0; k < batch.texts.size(); ++k)
+                if (batch.sources.at(k) == VectorSource::Provider) request << batch.texts.at(k);
+            QList<QVector<float>> vecs;
+            if (!request.isEmpty()) {
+                // Log batch details prior to external API call
+                {
+                    const int totalChars = std::accumulate(request.begin(), request.end(), 0, [](int s, const QString& t){ return s + t.size(); });
+                    qInfo() << "[EmbeddingIndexer] embedding batch start"
+                            << "provider=" << p_.providerCfg.provider
+                            << "model=" << p_.providerCfg.model
+                            << "baseUrl=" << p_.providerCfg.baseUrl
+                            << "pages=" << batch.firstPage() << "-" << batch.lastPage()
+                            << "seq=" << batch.seq
+                            << "batch_size=" << request.size()
+                            << "cached=" << (batch.texts.size() - request.size())
+                            << "chars_total=" << totalChars;
+                }
+                for (int attempt = 0;; ++attempt) {
+                    int ticket = 0;
+                    if (!gate.acquire(batch.seq, &ticket)) return; // pipeline stopped
+                    try {
+                        vecs = prov.embedBatch(request);
+                        gate.release(ticket, false);
+                        break;
+                    } catch (const EmbeddingError& ex) {
+                        gate.release(ticket, ex.isThrottled());
+                        if (!ex.isThrottled() || attempt >= kMaxThrottleRetries) {
+                            failEmbed(tr("Falha em embedBatch (page=%1, batch=%2): %3").arg(batch.firstPage()).arg(request.size()).arg(QString::fromUtf8(ex.what())), batch.firstPage());
+                            return;
+                        }
+                        // Exponential back-off unless the server said how long to wait
+                        const qint64 delayMs = ex.retryAfterMs() >= 0 ? qint64(ex.retryAfterMs())
+                                                                      : qMin<qint64>(30000, qint64(1000) << attempt);
+                        if (++throttledCount == 1) {
+                            emit warn(tr("Provedor limitou as requisições (HTTP %1). Reduzindo a concorrência e tentando novamente.").arg(ex.status()));
+                        }
+                        qWarning() << "[EmbeddingIndexer] throttled" << "status=" << ex.status() << "seq=" << batch.seq
+                                   << "retry_in_ms=" << delayMs << "limit=" << gate.limit();
+                        QElapsedTimer backoff; backoff.start();
+                        while (!stop && backoff.elapsed() < delayMs) QThread::msleep(50);
+                        if (stop) return;
+                    } catch (const std::exception& ex) {
+                        gate.release(ticket, false);
+                        failEmbed(tr("Falha em embedBatch (page=%1, batch=%2): %3").arg(batch.firstPage()).arg(request.size()).arg(QString::fromUtf8(ex.what())), batch.firstPage());
+                        return;
+                    }
                 }
-                if (!firstId) fids.write(","); firstId = false;
-                if (fids.write("\"") <= 0 || fids.write(QString::number(globalChunkIdx).toUtf8()) <= 0 || fids.write("\"") <= 0) {
-                    const QString em = tr("Falha ao escrever id no arquivo '%1': %2").arg(idsPath, fids.errorString());
-                    emit error(em);
-                    qCritical() << em;
-                    return false;
+                if (vecs.size() != request.size()) {
+                    failEmbed(tr("embedBatch retornou %1 vetores para %2 textos (page=%3)").arg(vecs.size()).arg(request.size()).arg(batch.firstPage()), batch.firstPage());
+                    return;
                 }
-                const auto& loc = batchLocs[k];
-                QJsonObject o; o.insert("file", QFileInfo(p_.pdfPath).absoluteFilePath()); o.insert("page", loc.first); o.insert("chunk", loc.second); o.insert("model", p_.providerCfg.model); o.insert("provider", p_.providerCfg.provider);
-                if (!firstMeta) fmeta.write(","); firstMeta = false;
-                if (fmeta.write(QJsonDocument(o).toJson(QJsonDocument::Compact)) <= 0) {
-                    const QString em = tr("Falha ao escrever metadados no arquivo '%1': %2").arg(metaPath, fmeta.errorString());
-                    emit error(em);
-                    qCritical() << em;
-                    return false;
+                if (cachedDim > 0 && vecs.first().size() != cachedDim) {
+                    // The model behind this name changed: the journal cannot be mixed with it
+                    staleJournal = true;
+                    failEmbed(tr("Os vetores reaproveitados (dimensão %1) não correspondem aos do modelo (dimensão %2). O diário de chunks foi descartado; execute a indexação novamente.")
+                                  .arg(cachedDim).arg(vecs.first().size()), batch.firstPage());
+                    return;
                 }
-                ++globalChunkIdx;
+                qInfo() << "[EmbeddingIndexer] embedding batch ok"
+                        << "seq=" << batch.seq
+                        << "vectors=" << vecs.size()
+                        << "dim=" << (vecs.isEmpty() ? 0 : vecs.first().size());
+                counters.embedded += vecs.size();
+                ++counters.requests;
             }
-            processed += batchTexts.size();
-            const int pctDoc = int((double(i + 1) / double(pageCount)) * 100.0);
-            emit progress(pctDoc, tr("embedding batch size=%1 (página %2)").arg(batchTexts.size()).arg(i+1));
-            if (p_.pauseMsBetweenBatches > 0) {
+            // Merge fresh vectors back between the cached ones, in batch order
+            VectorBatch done{ batch.seq, {}, std::move(batch.pages), std::move(batch.chunks), std::move(batch.spans), std::move(batch.keys), std::move(batch.sources) };
+            done.vectors.reserve(batch.cached.size());
+            int next = 0;
+            for (int k = 0; k < batch.cached.size(); ++k)
+                done.vectors.append(done.sources.at(k) == VectorSource::Provider ? vecs.at(next++) : std::move(batch.cached[k]));
+            if (!writeQueue.push(std::move(done))) return; // writer failed
+            if (!request.isEmpty() && p_.pauseMsBetweenBatches > 0) {
                 QThread::msleep(static_cast<unsigned long>(p_.pauseMsBetweenBatches));
             }
-            batchTexts.clear(); batchLocs.clear();
-            return true;
-        };
+        }
+    };
+    QVector<QThread*> embedThreads;
+    for (int w = 0; w < embedWorkers; ++w) embedThreads.append(QThread::create(embedWorker));
+    emit metric(QStringLiteral("embed_workers"), QString::number(embedWorkers));
 
-        bool aborted = false;
-        int chunkIdx = 0;
-        forEachChunks(pages[i], p_.chunkSize, p_.chunkOverlap, [&](QStringView v, int localIdx) -> bool {
-            waitIfPaused();
-            // Convert view to QString only for the provider input
-            batchTexts << v.toString();
-            batchLocs << QPair<int,int>(i+1, localIdx);
-            ++chunkIdx;
-            if (batchTexts.size() == bs) {
-                if (!processBatch()) {
-                    // Abort cleanly: close files and stop processing
-                    fb.close(); fids.close(); fmeta.close();
-                    const QString wm = tr("Abortando processamento: falha ao gerar embeddings (página %1). Fechando arquivos.").arg(i+1);
-                    emit warn(wm);
-                    qWarning() << wm;
-                    emit finished(false, tr("Falha ao gerar embeddings"));
-                    aborted = true;
-                    return false; // stop forEachChunks
-                }
+    extractThread->start();
+    chunkThread->start();
+    writeThread->start();
+    for (QThread* t : embedThreads) t->start();
+
+    // This thread only watches: interruption, progress and periodic metrics
+    bool interrupted = false;
+    int lastPage = 0;
+    qint64 lastRows = -1;
+    QElapsedTimer statsTimer; statsTimer.start();
+    for (QThread* t : embedThreads) {
+        while (!t->wait(kMonitorIntervalMs)) {
+            if (!interrupted && QThread::currentThread()->isInterruptionRequested()) {
+                interrupted = true;
+                emit warn(tr("Interrompido"));
+                // Requests already sent finish and are written; nothing new is started
+                stop = true;
+                gate.close();
+                pageQueue.abort();
+                batchQueue.abort();
+            }
+            const int page = writtenPage.load();
+            if (page != lastPage) { lastPage = page; emit metric(QStringLiteral("page"), QString::number(page)); }
+            const qint64 rows = counters.rows.load();
+            if (rows != lastRows) {
+                lastRows = rows;
+                const int pctDoc = int((double(page) / double(pageCount)) * 100.0);
+                emit progress(pctDoc, tr("embeddings: %1 chunks (página %2) • requisições: %3/%4 • filas: páginas %5, lotes %6, escrita %7")
+                                          .arg(rows).arg(page).arg(gate.inFlight()).arg(gate.limit())
+                                          .arg(pageQueue.size()).arg(batchQueue.size()).arg(writeQueue.size()));
+            }
+            if (statsTimer.elapsed() >= kStatsIntervalMs) {
+                emitPipelineMetrics(counters, total.elapsed(), pageQueue.size(), batchQueue.size(), writeQueue.size());
+                emit metric(QStringLiteral("embed_inflight_limit"), QString::number(gate.limit()));
+                statsTimer.restart();
             }
-            return true; // continue
-        });
-        if (aborted) return; // exit run()
-        // flush remaining
-        if (!processBatch(true)) {
-            fb.close(); fids.close(); fmeta.close();
-            const QString wm = tr("Abortando processamento no flush final da página %1. Fechando arquivos.").arg(i+1);
-            emit warn(wm);
-            qWarning() << wm;
-            emit finished(false, tr("Falha ao gerar embeddings"));
-            return; // exit run()
         }
-        ++pagesProcessed;
     }
 
-    // Finalizar arquivos
-    if (fids.isOpen()) { if (fids.write("]") <= 0) { const QString wm = tr("Falha ao finalizar ids '%1': %2").arg(idsPath, fids.errorString()); emit warn(wm); qWarning() << wm; } fids.close(); }
-    if (fmeta.isOpen()) { if (fmeta.write("]") <= 0) { const QString wm = tr("Falha ao finalizar meta '%1': %2").arg(metaPath, fmeta.errorString()); emit warn(wm); qWarning() << wm; } fmeta.close(); }
-    // Garantir que count e dim estejam corretos
-    if (fb.isOpen()) {
-        fb.seek(posCount); countInt = globalChunkIdx; fb.write(reinterpret_cast<const char*>(&countInt), sizeof(int));
-        if (dimInt == 0) { dimInt = 1; }
-        fb.seek(posDim); fb.write(reinterpret_cast<const char*>(&dimInt), sizeof(int));
-        fb.close();
-    } else {
-        const QString wm = tr("Arquivo binário '%1' fechou antes da atualização do cabeçalho.").arg(binPath);
+    // Every embed worker is done: on success/interruption the writer drains what was embedded
+    // (after an interruption only the contiguous prefix lands; later batches wait for a gap)
+    if (!embedErr.isEmpty()) abortPipeline();
+    else writeQueue.close();
+    for (QThread* t : embedThreads) delete t;
+    for (QThread* t : { extractThread, chunkThread, writeThread }) { t->wait(); delete t; }
+    emit metric(QStringLiteral("chunk_total"), QString::number(counters.chunks.load()));
+    emit metric(QStringLiteral("embed_requests"), QString::number(counters.requests.load()));
+    emit metric(QStringLiteral("cache_hits"), QString::number(counters.cacheHits.load()));
+    emit metric(QStringLiteral("shared_cache_hits"), QString::number(counters.sharedHits.load()));
+    emit metric(QStringLiteral("cache_appended"), QString::number(journal.appendedCount()));
+    if (staleJournal || !journalErr.isEmpty()) {
+        if (!journalErr.isEmpty()) emit warn(tr("Diário de chunks descartado: %1").arg(journalErr));
+        journal.close();
+        QFile::remove(journalPath);
+    }
+    emit metric(QStringLiteral("embed_throttled"), QString::number(throttledCount.load()));
+    emit metric(QStringLiteral("embed_inflight_limit"), QString::number(gate.limit()));
+    emitPipelineMetrics(counters, total.elapsed(), pageQueue.highWater(), batchQueue.highWater(), writeQueue.highWater(), true);
+    emit metric(QStringLiteral("extract_ms"), QString::number(extractMs.load()));
+    emit metric(QStringLiteral("pages_qtpdf"), QString::number(counters.fromQtPdf.load()));
+    emit metric(QStringLiteral("pages_pdftotext"), QString::number(counters.fromPdfToText.load()));
+    emit metric(QStringLiteral("pages_ocr"), QString::number(counters.fromOcr.load()));
+    if (!extractErr.isEmpty() && !interrupted && embedErr.isEmpty() && writeErr.isEmpty()) emit warn(extractErr);
+    if (!pagesCacheErr.isEmpty()) emit warn(pagesCacheErr);
+    if (ftsMs >= 0) {
+        emit metric(QStringLiteral("fts_terms"), QString::number(ftsTerms.load()));
+        emit metric(QStringLiteral("fts_ms"), QString::number(ftsMs.load()));
+    }
+    if (!ftsErr.isEmpty()) emit warn(ftsErr);
+    if (counters.fromQtPdf + counters.fromPdfToText + counters.fromOcr == 0 && !PageTextExtractor::hasPdfToText() && !PageTextExtractor::hasOcr()) {
+        emit warn(tr("Nenhum texto extraído. Instale 'poppler-utils' (pdftotext) e/ou 'tesseract-ocr' para PDFs sem camada de texto."));
+    }
+    if (!embedErr.isEmpty() || !writeErr.isEmpty()) {
+        // Abort cleanly: close and remove the partial container
+        out.abort();
+        const QString em = embedErr.isEmpty() ? writeErr : embedErr;
+        emit error(em);
+        qCritical() << em;
+        const QString wm = tr("Abortando processamento: falha ao gerar embeddings (página %1). Fechando arquivos.").arg(embedErr.isEmpty() ? writtenPage.load() : failedPage);
         emit warn(wm);
         qWarning() << wm;
+        if (journal.isOpen() && journal.loadedCount() + journal.appendedCount() > 0) {
+            emit warn(tr("%1 chunks já calculados ficam no diário e serão reaproveitados na próxima indexação.")
+                          .arg(journal.loadedCount() + journal.appendedCount()));
+        }
+        emit finished(false, tr("Falha ao gerar embeddings"));
+        return;
+    }
+    if (interrupted) {
+        // Only a complete run replaces the index: the previous container (and its graph/codes)
+        // stays in use, and the journal keeps what was embedded for the next run to resume from
+        out.abort();
+        if (journal.isOpen()) {
+            const qint64 kept = journal.loadedCount() + journal.appendedCount();
+            if (kept > 0) emit warn(tr("%1 chunks já calculados ficam no diário e serão reaproveitados na próxima indexação.").arg(kept));
+            journal.close();
+        }
+        emit finished(false, tr("Indexação interrompida"));
+        return;
+    }
+    const qint64 processed = counters.rows.load();
+
+    // Finalizar o contêiner (normas, tabela de linhas, strings e diretório)
+    if (processed == 0) { out.abort(); emit warn(tr("Nenhum vetor persistido.")); emit finished(false, tr("Nada produzido")); return; }
+    {
+        QString werr;
+        if (!out.finish(&werr)) {
+            emit error(werr);
+            qCritical() << werr;
+            emit finished(false, tr("Falha ao gravar índice"));
+            return;
+        }
+    }
+    // The container supersedes an older three-file index for the same document/model, and the
+    // graph/codes of the previous container
+    for (const char* ext : { ".bin", ".ids.json", ".meta.json" }) QFile::remove(base + QLatin1String(ext));
+    QFile::remove(hnswPath);
+    QFile::remove(q8Path);
+    // Drop journal entries for text no longer in the document once they make up a sizeable
+    // share of the file
+    if (journal.isOpen()) {
+        const qint64 stale = journal.recordCount() - writtenKeys.size();
+        if (stale > writtenKeys.size() / 4) {
+            QString jerr;
+            if (!journal.compact(writtenKeys, &jerr)) emit warn(jerr);
+            else qInfo() << "[EmbeddingIndexer] chunk journal compacted" << "dropped=" << stale;
+        }
+        journal.close();
     }
 
-    if (processed == 0) { emit warn(tr("Nenhum vetor persistido.")); emit finished(false, tr("Nada produzido")); return; }
+    if (p_.indexType == QLatin1String("hnsw")) {
+        // Failure here is not fatal: searches fall back to the exact scan over the container
+        emit stage(tr("Construindo índice HNSW"));
+        QElapsedTimer hnswTimer; hnswTimer.start();
+        VectorIndex vi;
+        QString herr;
+        if (!vi.loadContainer(containerPath, &herr)) {
+            emit warn(herr);
+        } else {
+            HnswIndex graph;
+            graph.reset(p_.metric, p_.hnsw);
+            graph.addRows(vi, [this](int done, int total) {
+                emit progress(total > 0 ? int(qint64(done) * 100 / total) : 100, tr("HNSW: %1/%2 vetores").arg(done).arg(total));
+                return true;
+            });
+            if (!graph.save(hnswPath, &herr)) emit warn(herr);
+            emit metric(QStringLiteral("hnsw_build_ms"), QString::number(hnswTimer.elapsed()));
+        }
+    } else if (p_.indexType == QLatin1String("sq8")) {
+        emit stage(tr("Quantizando vetores (int8)"));
+        VectorIndex vi;
+        QString qerr;
+        if (!vi.loadContainer(containerPath, &qerr)) {
+            emit warn(qerr);
+        } else {
+            QuantizedIndex q8;
+            q8.build(vi);
+            if (!q8.save(q8Path, &qerr)) emit warn(qerr);
+            const qint64 floatBytes = qint64(vi.count()) * vi.dim() * qint64(sizeof(float));
+            emit metric(QStringLiteral("sq8_bytes"), QString::number(q8.byteSize()));
+            emit metric(QStringLiteral("sq8_ratio"), QString::number(q8.byteSize() > 0 ? double(floatBytes) / double(q8.byteSize()) : 0.0, 'f', 2));
+            // Recall@10 against the exact scan on a sample of the indexed rows
+            emit metric(QStringLiteral("sq8_recall_at_10_codes"), QString::number(q8.estimateRecall(vi, p_.metric, 10, 64, 1), 'f', 3));
+            emit metric(QStringLiteral("sq8_recall_at_10_rerank"), QString::number(q8.estimateRecall(vi, p_.metric, 10, 64, p_.sq8RerankFactor), 'f', 3));
+        }
+    }
 
     emit stage(tr("Concluído"));
     emit metric(QStringLiteral("total_time_ms"), QString::number(total.elapsed()));
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QObject>
+#include <QByteArray>
 #include <QString>
 #include <QStringList>
 #include <QStringView>
@@ -8,10 +9,14 @@
 #include <QElapsedTimer>
 #include <QMutex>
 #include <QWaitCondition>
+#include <atomic>
 #include <functional>
 
 #include "ai/EmbeddingProvider.h"
 #include "ai/VectorIndex.h"
+#include "ai/HnswIndex.h"
+#include "ai/QuantizedIndex.h"
+#include "ai/TextChunker.h"
 
 class EmbeddingIndexer : public QObject {
     Q_OBJECT
@@ -22,9 +27,27 @@ public:
         EmbeddingProvider::Config providerCfg;
         int chunkSize {1000};
         int chunkOverlap {200};
-        int batchSize {16};
+        // How pages are cut into chunks (see TextChunker); size/overlap are in chunkUnit
+        TextChunker::Strategy chunkStrategy {TextChunker::Strategy::Structure};
+        TextChunker::Unit chunkUnit {TextChunker::Unit::Chars};
+        bool chunkSpanPages {true};
+        int batchSize {16};      // chunks per embedding request; batches span page boundaries
+        int batchMaxChars {0};   // also cap the characters per request (0 = count only)
         int pagesPerStage {-1}; // <=0 means all pages
         int pauseMsBetweenBatches {0}; // simple throttle to avoid resource exhaustion
+        int extractWorkers {0}; // parallel page text extraction, 0 = QThread::idealThreadCount()
+        int ocrWorkers {0};     // pages OCRed at once (scanned pages), 0 = QThread::idealThreadCount()
+        // Embedding requests in flight at once; lowered while the provider answers HTTP 429
+        int maxInFlight {4};
+        // Cap of the embedding cache shared with other documents and queries
+        // (<dbDir>/embedding_cache); 0 disables it
+        qint64 cacheMaxBytes {qint64(512) << 20};
+        // Search structure built next to the vectors: "flat" (exact scan only), "sq8"
+        // (int8 codes + exact rerank) or "hnsw"
+        QString indexType {QStringLiteral("flat")};
+        VectorIndex::Metric metric {VectorIndex::Metric::Cosine}; // metric the HNSW graph is built for
+        HnswIndex::Params hnsw;
+        int sq8RerankFactor {4}; // candidates per result rescored exactly (recall metric only)
     };
 
     explicit EmbeddingIndexer(const Params& p, QObject* parent = nullptr);
@@ -44,9 +67,65 @@ public slots:
     void requestResume();
 
 private:
-    QStringList extractPagesText(); // tries pdftotext page-by-page; fallback returns empty pages
-    void forEachChunks(const QString& text, int chunkSize, int overlap,
-                       const std::function<bool(QStringView, int)>& consume);
+    // Items passed between the pipeline stages of run() (extract -> chunk -> embed -> write)
+    struct PageItem { int page {0}; QString text; };
+    // Where an item's vector comes from
+    enum class VectorSource : char { Provider, Journal, Cache };
+    // Where a chunk ends, besides its start page (start offset, end page, end offset)
+    struct ChunkSpan { int startOffset {0}; int endPage {0}; int endOffset {0}; };
+    // seq numbers batches in document order; embeddings may complete out of it. A batch may
+    // span pages: pages[k]/chunks[k] locate item k (chunks: index among the chunks starting on
+    // its page) and spans[k] its extent, keys[k] is its EmbeddingCache key and cached[k] the
+    // vector found for it (empty: must be embedded)
+    struct ChunkBatch {
+        qint64 seq {0};
+        QStringList texts; // empty for cached items
+        QVector<int> pages;
+        QVector<int> chunks;
+        QVector<ChunkSpan> spans;
+        QVector<QByteArray> keys;
+        QList<QVector<float>> cached;
+        QVector<VectorSource> sources;
+        int misses {0};
+        int firstPage() const { return pages.isEmpty() ? 0 : pages.first(); }
+        int lastPage() const { return pages.isEmpty() ? 0 : pages.last(); }
+    };
+    struct VectorBatch {
+        qint64 seq {0};
+        QList<QVector<float>> vectors;
+        QVector<int> pages;
+        QVector<int> chunks;
+        QVector<ChunkSpan> spans;
+        QVector<QByteArray> keys;
+        QVector<VectorSource> sources;
+    };
+    // Items that left each stage so far (updated by the stage threads)
+    struct PipelineCounters {
+        std::atomic<qint64> pages {0};
+        std::atomic<qint64> chunks {0};
+        std::atomic<qint64> embedded {0};
+        std::atomic<qint64> requests {0}; // embedding batches sent successfully
+        std::atomic<qint64> cacheHits {0}; // chunks reused from the journal
+        std::atomic<qint64> sharedHits {0}; // chunks found in the shared embedding cache
+        std::atomic<qint64> rows {0};
+        std::atomic<qint64> fromQtPdf {0};
+        std::atomic<qint64> fromPdfToText {0};
+        std::atomic<qint64> fromOcr {0};
+    };
+    // Queue capacities: bound the pages/batches in flight between stages
+    static constexpr int kPageQueueCapacity = 32;
+    static constexpr int kBatchQueueCapacity = 8;
+    static constexpr int kWriteQueueCapacity = 8;
+    static constexpr qint64 kStatsIntervalMs = 1000;
+    static constexpr int kMonitorIntervalMs = 200;
+    // Cap on a batch's size, in multiples of batchSize, when most of its chunks are cached
+    static constexpr int kMaxBatchItems = 4;
+    // Retries of one batch throttled by the provider (HTTP 429/503) before the run fails
+    static constexpr int kMaxThrottleRetries = 8;
+
+    // Per-stage throughput (items/s since start) and queue depths as metric() signals
+    void emitPipelineMetrics(const PipelineCounters& c, qint64 elapsedMs, int pageDepth, int batchDepth,
+                             int writeDepth, bool done = false);
     QString sha1(const QString& s) const;
     void waitIfPaused();
 
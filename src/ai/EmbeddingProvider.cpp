@@ -9,11 +9,26 @@
 #include <QJsonArray>
 #include <QUrl>
 #include <QUrlQuery>
+#include <QDateTime>
 #include <QThread>
 #include <QDebug>
 #include <numeric>
 #include <QRegularExpression>
 
+// Server back-off hint in ms: Retry-After (seconds or HTTP date) or OpenAI's retry-after-ms; -1 if absent
+static int retryAfterMs(const QNetworkReply* rep) {
+    bool ok = false;
+    const int ms = rep->rawHeader("retry-after-ms").trimmed().toInt(&ok);
+    if (ok && ms >= 0) return ms;
+    const QByteArray ra = rep->rawHeader("Retry-After").trimmed();
+    if (ra.isEmpty()) return -1;
+    const int secs = ra.toInt(&ok);
+    if (ok) return secs >= 0 ? secs * 1000 : -1;
+    const QDateTime at = QDateTime::fromString(QString::fromLatin1(ra), Qt::RFC2822Date);
+    if (!at.isValid()) return -1;
+    return int(qBound<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(at), 10 * 60 * 1000));
+}
+
 static QList<QVector<float>> toVectors(const QJsonArray& arr) {
     QList<QVector<float>> out;
     out.reserve(arr.size());
@@ -68,6 +83,7 @@ QList<QVector<float>> EmbeddingProvider::embedRetrievalEf(const QStringList& tex
         loop.exec();
 
         const int status = rep->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        const int retryMs = retryAfterMs(rep);
         const QByteArray resp = rep->readAll();
         const QString errStr = rep->errorString();
         const auto netErr = rep->error();
@@ -82,7 +98,7 @@ QList<QVector<float>> EmbeddingProvider::embedRetrievalEf(const QStringList& tex
                                      .arg(url.toString())
                                      .arg(bodySnippet);
             qCritical() << "[EmbeddingProvider]" << full;
-            throw std::runtime_error(full.toStdString());
+            throw EmbeddingError(full, status, retryMs);
         }
 
         const QJsonDocument doc = QJsonDocument::fromJson(resp);
@@ -122,7 +138,7 @@ QList<QVector<float>> EmbeddingProvider::embedBatch(const QStringList& texts) {
         const QString base = cfg_.baseUrl.isEmpty() ? QStringLiteral("http://localhost:8080") : cfg_.baseUrl;
         return embedRetrievalEf(normTexts, base);
     }
-    throw std::runtime_error("Unsupported provider");
+    throw EmbeddingError(QStringLiteral("Unsupported provider"), 0);
 }
 
 QList<QVector<float>> EmbeddingProvider::embedOpenAICompatible(const QStringList& texts, const QString& urlBase) {
@@ -156,6 +172,7 @@ QList<QVector<float>> EmbeddingProvider::embedOpenAICompatible(const QStringList
 
     // Read response and status
     const int status = rep->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const int retryMs = retryAfterMs(rep);
     const QByteArray resp = rep->readAll();
     const QString errStr = rep->errorString();
     const auto netErr = rep->error();
@@ -187,7 +204,7 @@ QList<QVector<float>> EmbeddingProvider::embedOpenAICompatible(const QStringList
                                  .arg(url.toString())
                                  .arg(details);
         qCritical() << "[EmbeddingProvider]" << full;
-        throw std::runtime_error(full.toStdString());
+        throw EmbeddingError(full, status, retryMs);
     }
 
     const QJsonDocument doc = QJsonDocument::fromJson(resp);
@@ -222,6 +239,7 @@ QList<QVector<float>> EmbeddingProvider::embedOllama(const QStringList& texts) {
         QObject::connect(rep, &QNetworkReply::finished, &loop, &QEventLoop::quit);
         loop.exec();
         const int status = rep->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        const int retryMs = retryAfterMs(rep);
         const QByteArray resp = rep->readAll();
         const QString errStr = rep->errorString();
         const auto netErr = rep->error();
@@ -235,7 +253,7 @@ QList<QVector<float>> EmbeddingProvider::embedOllama(const QStringList& texts) {
                                      .arg(url.toString())
                                      .arg(bodySnippet);
             qCritical() << "[EmbeddingProvider]" << full;
-            throw std::runtime_error(full.toStdString());
+            throw EmbeddingError(full, status, retryMs);
         }
         
         const QJsonDocument doc = QJsonDocument::fromJson(resp);
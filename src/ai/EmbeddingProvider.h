@@ -4,6 +4,24 @@
 #include <QString>
 #include <QStringList>
 #include <QVector>
+#include <stdexcept>
+
+// Failure reported by EmbeddingProvider::embedBatch(). status is the HTTP status (0 for transport
+// errors) and retryAfterMs the server's Retry-After hint (-1 when absent), so callers can tell a
+// rate limit from a hard failure and back off.
+class EmbeddingError : public std::runtime_error {
+public:
+    EmbeddingError(const QString& message, int status, int retryAfterMs = -1)
+        : std::runtime_error(message.toStdString()), status_(status), retryAfterMs_(retryAfterMs) {}
+    int status() const { return status_; }
+    int retryAfterMs() const { return retryAfterMs_; }
+    // 429 Too Many Requests, or 503 from an overloaded server: worth retrying more slowly
+    bool isThrottled() const { return status_ == 429 || status_ == 503; }
+
+private:
+    int status_ {0};
+    int retryAfterMs_ {-1};
+};
 
 // Simple provider interface for generating embeddings from text batches.
 class EmbeddingProvider : public QObject {
@@ -18,7 +36,8 @@ public:
 
     explicit EmbeddingProvider(const Config& cfg, QObject* parent = nullptr);
 
-    // Returns NxD embeddings. Throws on error (via exceptions) with a descriptive message.
+    // Returns NxD embeddings. Throws EmbeddingError with a descriptive message on failure.
+    // Each call uses its own network manager, so separate instances may run on separate threads.
     QList<QVector<float>> embedBatch(const QStringList& texts);
 
 private:
@@ -0,0 +1,406 @@
+#include "ai/FullTextIndex.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QSaveFile>
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace {
+constexpr quint32 kIndexVersion = 1;
+constexpr int kHeaderSize = 32;
+constexpr int kCompressionLevel = 1;
+// Longer runs (hashes, base64 blobs) are indexed by their prefix
+constexpr int kMaxTermLength = 64;
+// BM25 parameters (the usual defaults)
+constexpr double kK1 = 1.2;
+constexpr double kB = 0.75;
+
+struct Stamp { qint64 size {-1}; qint64 mtimeMs {0}; };
+
+Stamp stampOf(const QString& pdfPath) {
+    const QFileInfo fi(pdfPath);
+    if (!fi.exists()) return Stamp{};
+    return Stamp{ fi.size(), fi.lastModified().toMSecsSinceEpoch() };
+}
+
+template <typename T> void put(QByteArray* out, T v) {
+    out->append(reinterpret_cast<const char*>(&v), int(sizeof v));
+}
+
+template <typename T> bool get(const QByteArray& in, int* pos, T* v) {
+    if (*pos + int(sizeof *v) > in.size()) return false;
+    std::memcpy(v, in.constData() + *pos, sizeof *v);
+    *pos += int(sizeof *v);
+    return true;
+}
+
+template <typename T> void putArray(QByteArray* out, const QVector<T>& v) {
+    out->append(reinterpret_cast<const char*>(v.constData()), int(v.size() * sizeof(T)));
+}
+
+template <typename T> bool getArray(const QByteArray& in, int* pos, int count, QVector<T>* v) {
+    if (count < 0 || qint64(count) * qint64(sizeof(T)) > qint64(in.size() - *pos)) return false;
+    v->resize(count);
+    std::memcpy(v->data(), in.constData() + *pos, size_t(count) * sizeof(T));
+    *pos += int(count * sizeof(T));
+    return true;
+}
+
+// Folded form of a code point: NFKD without combining marks, case-folded. ASCII is handled
+// inline; other code points are normalized once per tokenizer run.
+class Folder {
+public:
+    void append(char32_t u, QString* term) {
+        if (u < 0x80) {
+            term->append(QChar(char16_t(u >= 'A' && u <= 'Z' ? u + ('a' - 'A') : u)));
+            return;
+        }
+        auto it = cache_.constFind(u);
+        if (it == cache_.constEnd()) {
+            const QString decomposed = QString::fromUcs4(&u, 1).normalized(QString::NormalizationForm_KD);
+            QString folded;
+            for (const QChar c : decomposed)
+                if (c.isLetterOrNumber() || c.isSurrogate()) folded.append(c.toCaseFolded());
+            it = cache_.insert(u, folded);
+        }
+        term->append(*it);
+    }
+
+private:
+    QHash<char32_t, QString> cache_;
+};
+
+// Calls fn(start, end, term) for each word of text; marks continue the word they follow
+void forEachToken(QStringView text, Folder& folder, const std::function<void(int, int, const QString&)>& fn) {
+    QString term;
+    int start = -1;
+    const int n = int(text.size());
+    auto flush = [&](int end) {
+        if (!term.isEmpty()) fn(start, end, term.left(kMaxTermLength));
+        start = -1;
+    };
+    for (int i = 0; i < n;) {
+        char32_t u = text.at(i).unicode();
+        int len = 1;
+        if (text.at(i).isHighSurrogate() && i + 1 < n && text.at(i + 1).isLowSurrogate()) {
+            u = QChar::surrogateToUcs4(text.at(i), text.at(i + 1));
+            len = 2;
+        }
+        const bool mark = QChar::isMark(u);
+        if (QChar::isLetterOrNumber(u) || (mark && start >= 0)) {
+            if (start < 0) {
+                start = i;
+                term.clear();
+            }
+            if (!mark) folder.append(u, &term);
+        } else if (start >= 0) {
+            flush(i);
+        }
+        i += len;
+    }
+    if (start >= 0) flush(n);
+}
+}
+
+QString FullTextIndex::pathFor(const QString& dbDir, const QString& pdfPath) {
+    const QByteArray hash = QCryptographicHash::hash(QFileInfo(pdfPath).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(dbDir).filePath(QStringLiteral("fts_%1.fts").arg(QString::fromLatin1(hash)));
+}
+
+bool FullTextIndex::isCurrent(const QString& path, const QString& pdfPath) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    const QByteArray head = f.read(kHeaderSize);
+    int pos = 4;
+    quint32 version = 0;
+    qint64 size = 0, mtimeMs = 0;
+    if (head.size() != kHeaderSize || std::memcmp(head.constData(), "GFTS", 4) != 0
+        || !get(head, &pos, &version) || !get(head, &pos, &size) || !get(head, &pos, &mtimeMs)) return false;
+    const Stamp now = stampOf(pdfPath);
+    return version == kIndexVersion && size == now.size && mtimeMs == now.mtimeMs;
+}
+
+QStringList FullTextIndex::terms(QStringView text) {
+    QStringList out;
+    Folder folder;
+    forEachToken(text, folder, [&out](int, int, const QString& term) { out << term; });
+    return out;
+}
+
+void FullTextIndex::build(const QStringList& pages) {
+    *this = FullTextIndex();
+    // Occurrences per term, in page then ordinal order (pages are scanned in order)
+    struct Pending { qint32 page; Occurrence occ; };
+    QVector<QVector<Pending>> byTerm;
+    Folder folder;
+    pageLengths_.reserve(pages.size());
+    for (int p = 0; p < pages.size(); ++p) {
+        quint32 ordinal = 0;
+        forEachToken(pages.at(p), folder, [&](int start, int end, const QString& term) {
+            auto it = termIds_.constFind(term);
+            int id = 0;
+            if (it == termIds_.constEnd()) {
+                id = int(byTerm.size());
+                termIds_.insert(term, id);
+                termTexts_ << term;
+                byTerm.append(QVector<Pending>());
+            } else {
+                id = *it;
+            }
+            byTerm[id].append(Pending{ qint32(p + 1), Occurrence{ ordinal++, quint32(start), quint32(end - start) } });
+        });
+        pageLengths_ << qint32(ordinal);
+    }
+    terms_.reserve(byTerm.size());
+    for (QVector<Pending>& list : byTerm) {
+        Term t;
+        t.first = quint32(postings_.size());
+        for (const Pending& pe : list) {
+            if (t.count == 0 || postings_.last().page != pe.page) {
+                postings_.append(Posting{ pe.page, quint32(occurrences_.size()), 0 });
+                ++t.count;
+            }
+            ++postings_.last().count;
+            occurrences_.append(pe.occ);
+        }
+        terms_.append(t);
+        list = QVector<Pending>(); // release as we go
+    }
+    updateAverageLength();
+}
+
+bool FullTextIndex::load(const QString& path, const QString& pdfPath, QString* err) {
+    *this = FullTextIndex();
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false; // not built yet: not an error
+    const QByteArray head = f.read(kHeaderSize);
+    int pos = 4;
+    quint32 version = 0, termCount = 0;
+    qint64 size = 0, mtimeMs = 0;
+    qint32 pages = 0;
+    if (head.size() != kHeaderSize || std::memcmp(head.constData(), "GFTS", 4) != 0
+        || !get(head, &pos, &version) || !get(head, &pos, &size) || !get(head, &pos, &mtimeMs)
+        || !get(head, &pos, &pages) || !get(head, &pos, &termCount) || pages < 0) {
+        if (err) *err = QObject::tr("Índice de texto inválido: %1").arg(path);
+        return false;
+    }
+    const Stamp now = stampOf(pdfPath);
+    if (version != kIndexVersion || size != now.size || mtimeMs != now.mtimeMs) return false; // stale
+    const QByteArray payload = qUncompress(f.readAll());
+    auto corrupt = [&]() {
+        *this = FullTextIndex();
+        if (err) *err = QObject::tr("Índice de texto corrompido: %1").arg(path);
+        return false;
+    };
+    pos = 0;
+    if (!getArray(payload, &pos, pages, &pageLengths_)) return corrupt();
+    terms_.reserve(int(termCount));
+    termTexts_.reserve(int(termCount));
+    termIds_.reserve(int(termCount));
+    for (quint32 i = 0; i < termCount; ++i) {
+        quint16 len = 0;
+        Term t;
+        if (!get(payload, &pos, &len) || len > payload.size() - pos) return corrupt();
+        const QString term = QString::fromUtf8(payload.constData() + pos, len);
+        pos += len;
+        if (!get(payload, &pos, &t.first) || !get(payload, &pos, &t.count)) return corrupt();
+        termIds_.insert(term, int(i));
+        termTexts_ << term;
+        terms_.append(t);
+    }
+    qint32 postingCount = 0, occurrenceCount = 0;
+    if (!get(payload, &pos, &postingCount) || !getArray(payload, &pos, postingCount, &postings_)
+        || !get(payload, &pos, &occurrenceCount) || !getArray(payload, &pos, occurrenceCount, &occurrences_)) return corrupt();
+    // Every range must stay inside its array, so search() can index without checks
+    for (const Term& t : terms_)
+        if (quint64(t.first) + t.count > quint64(postings_.size())) return corrupt();
+    for (const Posting& p : postings_)
+        if (p.page < 1 || p.page > pages || quint64(p.first) + p.count > quint64(occurrences_.size())) return corrupt();
+    updateAverageLength();
+    return true;
+}
+
+bool FullTextIndex::save(const QString& path, const QString& pdfPath, QString* err) const {
+    static_assert(sizeof(Posting) == 12 && sizeof(Occurrence) == 12, "posting arrays are written as is");
+    const Stamp stamp = stampOf(pdfPath);
+    if (stamp.size < 0) {
+        if (err) *err = QObject::tr("PDF não encontrado: %1").arg(pdfPath);
+        return false;
+    }
+    QByteArray payload;
+    putArray(&payload, pageLengths_);
+    for (int i = 0; i < terms_.size(); ++i) {
+        const QByteArray utf8 = termTexts_.at(i).toUtf8();
+        put(&payload, quint16(utf8.size()));
+        payload.append(utf8);
+        put(&payload, terms_.at(i).first);
+        put(&payload, terms_.at(i).count);
+    }
+    put(&payload, qint32(postings_.size()));
+    putArray(&payload, postings_);
+    put(&payload, qint32(occurrences_.size()));
+    putArray(&payload, occurrences_);
+    QByteArray head;
+    head.append("GFTS", 4);
+    put(&head, kIndexVersion);
+    put(&head, stamp.size);
+    put(&head, stamp.mtimeMs);
+    put(&head, qint32(pageLengths_.size()));
+    put(&head, quint32(terms_.size()));
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile out(path);
+    const QByteArray body = qCompress(payload, kCompressionLevel);
+    if (!out.open(QIODevice::WriteOnly) || out.write(head) != head.size() || out.write(body) != body.size()
+        || !out.commit()) {
+        if (err) *err = QObject::tr("Falha ao gravar índice de texto '%1': %2").arg(path, out.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool FullTextIndex::matchPage(const QString& query, int page, const QString& text, Hit* hit) {
+    // A one-page index: same terms, same all-words and phrase checks, same spans
+    FullTextIndex one;
+    one.build(QStringList{ text });
+    const QList<Hit> hits = one.search(query, 1);
+    if (hits.isEmpty()) return false;
+    *hit = hits.first();
+    hit->page = page;
+    return true;
+}
+
+void FullTextIndex::updateAverageLength() {
+    qint64 total = 0;
+    for (qint32 n : pageLengths_) total += n;
+    avgLength_ = pageLengths_.isEmpty() ? 1.0 : qMax(1.0, double(total) / pageLengths_.size());
+}
+
+const FullTextIndex::Posting* FullTextIndex::posting(int term, int page) const {
+    const Term& t = terms_.at(term);
+    const Posting* first = postings_.constData() + t.first;
+    const Posting* last = first + t.count;
+    const Posting* it = std::lower_bound(first, last, page, [](const Posting& p, int pg) { return p.page < pg; });
+    return (it != last && it->page == page) ? it : nullptr;
+}
+
+QVector<FullTextIndex::Span> FullTextIndex::phraseSpans(const QVector<const Posting*>& postings, bool firstOnly) const {
+    QVector<Span> spans;
+    const Occurrence* base = occurrences_.constData();
+    const Posting* head = postings.first();
+    for (quint32 i = 0; i < head->count; ++i) {
+        const Occurrence& o = base[head->first + i];
+        const Occurrence* lastWord = &o;
+        bool match = true;
+        for (int k = 1; k < postings.size() && match; ++k) {
+            const Occurrence* first = base + postings.at(k)->first;
+            const Occurrence* last = first + postings.at(k)->count;
+            const quint32 want = o.ordinal + quint32(k);
+            const Occurrence* it = std::lower_bound(first, last, want, [](const Occurrence& x, quint32 ord) { return x.ordinal < ord; });
+            match = it != last && it->ordinal == want;
+            if (match) lastWord = it;
+        }
+        if (!match) continue;
+        spans.append(Span{ int(o.start), int(lastWord->start + lastWord->length) });
+        if (firstOnly) break;
+    }
+    return spans;
+}
+
+QList<FullTextIndex::Hit> FullTextIndex::search(const QString& query, int maxPages) const {
+    QList<Hit> hits;
+    if (isEmpty() || maxPages <= 0) return hits;
+    // Quoted segments (odd parts) are phrases; every other word is a group of its own
+    QVector<QVector<int>> groups;
+    QVector<int> sequence; // all query terms, in order
+    const QStringList parts = query.split(QLatin1Char('"'));
+    for (int i = 0; i < parts.size(); ++i) {
+        QVector<int> ids;
+        for (const QString& term : terms(parts.at(i))) {
+            const auto it = termIds_.constFind(term);
+            if (it == termIds_.constEnd()) return hits; // a word no page has
+            ids << *it;
+        }
+        sequence += ids;
+        if (ids.isEmpty()) continue;
+        if (i % 2 == 1) groups << ids;
+        else for (int id : ids) groups << QVector<int>{ id };
+    }
+    if (groups.isEmpty()) return hits;
+    QVector<int> distinct = sequence;
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    QVector<double> idf;
+    const double n = pageCount();
+    for (int id : distinct) {
+        const double df = terms_.at(id).count;
+        idf << std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+    }
+    // Candidates are the pages of the rarest term, looked up in the postings of the others;
+    // spans are only collected for the pages that make the cut
+    const int rarest = *std::min_element(distinct.cbegin(), distinct.cend(), [this](int a, int b) {
+        return terms_.at(a).count < terms_.at(b).count;
+    });
+    auto postingsOf = [&](const QVector<int>& ids, const QVector<const Posting*>& onPage) {
+        QVector<const Posting*> out;
+        for (int id : ids) out << onPage.at(int(std::lower_bound(distinct.cbegin(), distinct.cend(), id) - distinct.cbegin()));
+        return out;
+    };
+    const Term& rt = terms_.at(rarest);
+    QVector<const Posting*> onPage(distinct.size());
+    for (quint32 r = 0; r < rt.count; ++r) {
+        const int page = postings_.at(int(rt.first + r)).page;
+        bool all = true;
+        for (int i = 0; i < distinct.size() && all; ++i) {
+            onPage[i] = posting(distinct.at(i), page);
+            all = onPage.at(i) != nullptr;
+        }
+        for (int g = 0; g < groups.size() && all; ++g)
+            all = groups.at(g).size() == 1 || !phraseSpans(postingsOf(groups.at(g), onPage), true).isEmpty();
+        if (!all) continue;
+        Hit h;
+        h.page = page;
+        const double dl = pageLengths_.at(page - 1);
+        for (int i = 0; i < distinct.size(); ++i) {
+            const double tf = onPage.at(i)->count;
+            h.score += idf.at(i) * tf * (kK1 + 1.0) / (tf + kK1 * (1.0 - kB + kB * dl / avgLength_));
+        }
+        // The whole query as typed, word after word, ranks above the words scattered on the page
+        if (sequence.size() > 1 && groups.size() > 1 && !phraseSpans(postingsOf(sequence, onPage), true).isEmpty())
+            h.score *= 2.0;
+        hits.append(h);
+    }
+    const int keep = qMin(maxPages, int(hits.size()));
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(), [](const Hit& a, const Hit& b) {
+        return a.score != b.score ? a.score > b.score : a.page < b.page;
+    });
+    hits.erase(hits.begin() + keep, hits.end());
+    for (Hit& h : hits) {
+        for (int i = 0; i < distinct.size(); ++i) onPage[i] = posting(distinct.at(i), h.page);
+        for (const QVector<int>& g : groups) {
+            if (g.size() > 1) {
+                h.spans += phraseSpans(postingsOf(g, onPage), false);
+                continue;
+            }
+            const Posting* p = onPage.at(int(std::lower_bound(distinct.cbegin(), distinct.cend(), g.first()) - distinct.cbegin()));
+            for (quint32 i = 0; i < p->count; ++i) {
+                const Occurrence& o = occurrences_.at(int(p->first + i));
+                h.spans.append(Span{ int(o.start), int(o.start + o.length) });
+            }
+        }
+        std::sort(h.spans.begin(), h.spans.end(), [](const Span& a, const Span& b) {
+            return a.start != b.start ? a.start < b.start : a.end > b.end;
+        });
+        h.spans.erase(std::unique(h.spans.begin(), h.spans.end(), [](const Span& a, const Span& b) {
+            return a.start == b.start;
+        }), h.spans.end());
+    }
+    return hits;
+}
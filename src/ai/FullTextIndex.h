@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+
+// Inverted index over the page text of one document, for the plain-text search: each term maps to
+// the pages containing it and, per page, the position (token ordinal) and character span of every
+// occurrence. Persisted as <emb/db_path>/fts_<sha1(path)>.fts, next to the page-text cache and the
+// embeddings, and valid for the exact PDF it was built from (size and mtime in the header).
+//
+// Terms are runs of letters/digits, NFKD-decomposed with combining marks dropped and case-folded,
+// so "Ação", "acao" and "AÇÃO" are the same term, and ligatures ("ﬁ") match their letters.
+//
+// Queries: every word must occur on the page; words between double quotes must occur as a phrase
+// (consecutive terms, in order). Pages are ranked by BM25 (pages as documents), with the score
+// doubled when the whole query also occurs as a phrase. Hits carry the character spans of the
+// matched words / phrases in the page text, so they can be highlighted or quoted.
+//
+// File layout (little-endian): 32-byte header "GFTS", u32 version, i64 PDF size, i64 PDF mtime,
+// i32 page count, u32 term count; then a qCompress'ed payload: i32 token count per page, per term
+// [u16 byte length][UTF-8 term][u32 first posting][u32 posting count], then the posting array
+// (i32 page, u32 first occurrence, u32 occurrence count) and the occurrence array (u32 ordinal,
+// u32 start, u32 length).
+class FullTextIndex {
+public:
+    struct Span {
+        int start {0};
+        int end {0}; // exclusive
+    };
+    struct Hit {
+        int page {0}; // 1-based
+        double score {0.0};
+        QVector<Span> spans; // into the text of page, in order
+    };
+
+    // Index file of pdfPath under dbDir
+    static QString pathFor(const QString& dbDir, const QString& pdfPath);
+    // Header of path matches pdfPath as it is now (no payload read)
+    static bool isCurrent(const QString& path, const QString& pdfPath);
+    // Folded terms of text, in order (the query side of the tokenizer)
+    static QStringList terms(QStringView text);
+
+    // Indexes pages (page 1 first), replacing the current content
+    void build(const QStringList& pages);
+    // Reads path when it was built from pdfPath as it is now; false when missing, stale or corrupt
+    bool load(const QString& path, const QString& pdfPath, QString* err = nullptr);
+    // Writes the index atomically, stamped with pdfPath's current size and mtime
+    bool save(const QString& path, const QString& pdfPath, QString* err = nullptr) const;
+
+    // Best pages for query, up to maxPages, highest score first
+    QList<Hit> search(const QString& query, int maxPages) const;
+    // Matches query against the text of one page with the tokenizer and rules of search(), for
+    // scanning pages before the index exists. hit gets page and spans; its score is only
+    // meaningful relative to the page itself.
+    static bool matchPage(const QString& query, int page, const QString& text, Hit* hit);
+
+    bool isEmpty() const { return pageLengths_.isEmpty(); }
+    int pageCount() const { return pageLengths_.size(); }
+    int termCount() const { return terms_.size(); }
+
+private:
+    struct Term {
+        quint32 first {0}; // into postings_
+        quint32 count {0};
+    };
+    struct Posting {
+        qint32 page {0};
+        quint32 first {0}; // into occurrences_
+        quint32 count {0};
+    };
+    struct Occurrence {
+        quint32 ordinal {0}; // token index in the page
+        quint32 start {0};
+        quint32 length {0};
+    };
+
+    const Posting* posting(int term, int page) const;
+    // Spans where the terms of the given postings (one page, phrase order) occur in sequence;
+    // firstOnly stops at the first one (existence check)
+    QVector<Span> phraseSpans(const QVector<const Posting*>& postings, bool firstOnly) const;
+    void updateAverageLength();
+
+    QHash<QString, int> termIds_;
+    QStringList termTexts_; // by term id, for save()
+    QVector<Term> terms_;
+    QVector<Posting> postings_;       // grouped by term, by page within a term
+    QVector<Occurrence> occurrences_; // grouped by posting, by ordinal within a posting
+    QVector<qint32> pageLengths_;     // tokens per page
+    double avgLength_ {1.0};
+};
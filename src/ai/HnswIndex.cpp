@@ -0,0 +1,358 @@
+#include "ai/HnswIndex.h"
+#include "ai/VectorKernels.h"
+
+#include <QObject>
+#include <QFile>
+#include <QSaveFile>
+#include <QMutexLocker>
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+namespace {
+constexpr int kHeaderInts = 8; // metric, M, efConstruction, count, dim, maxLevel, entry + reserved
+constexpr int kMaxLevel = 32;
+
+// Min-heap order (top = closest); ties by lower row so results are deterministic
+struct CloserOnTop {
+    template <typename C> bool operator()(const C& a, const C& b) const {
+        return a.dist > b.dist || (a.dist == b.dist && a.id > b.id);
+    }
+};
+// Max-heap order (top = farthest)
+struct FartherOnTop {
+    template <typename C> bool operator()(const C& a, const C& b) const {
+        return a.dist < b.dist || (a.dist == b.dist && a.id < b.id);
+    }
+};
+
+inline quint64 splitmix64(quint64 x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+}
+
+void HnswIndex::Visited::begin(int n) {
+    if (marks.size() < size_t(n)) marks.resize(size_t(n), 0);
+    if (++epoch == 0) { std::fill(marks.begin(), marks.end(), 0); epoch = 1; }
+}
+
+void HnswIndex::reset(VectorIndex::Metric metric, const Params& p) {
+    metric_ = metric;
+    params_ = p;
+    params_.M = qBound(2, params_.M, 128);
+    params_.efConstruction = qMax(params_.M, params_.efConstruction);
+    params_.efSearch = qMax(1, params_.efSearch);
+    count_ = 0; dim_ = 0; maxLevel_ = -1; entry_ = -1; fingerprint_ = 0;
+    levels_.clear(); links0_.clear(); upper_.clear();
+}
+
+float HnswIndex::distance(const VectorIndex& v, const float* q, float nq, int id) const {
+    const float* r = v.row(id).data;
+    switch (metric_) {
+    case VectorIndex::Metric::Cosine: {
+        const float nv = v.norm(id);
+        const float dp = VectorKernels::dot(q, r, dim_);
+        return (nq > 0 && nv > 0) ? 1.0f - dp / (nq * nv) : 1.0f;
+    }
+    case VectorIndex::Metric::Dot:
+        return -VectorKernels::dot(q, r, dim_);
+    case VectorIndex::Metric::L2:
+    default:
+        return VectorKernels::squaredL2(q, r, dim_);
+    }
+}
+
+float HnswIndex::scoreFromDistance(float dist) const {
+    switch (metric_) {
+    case VectorIndex::Metric::Cosine: return 1.0f - dist;
+    case VectorIndex::Metric::Dot: return -dist;
+    case VectorIndex::Metric::L2:
+    default: return -std::sqrt(qMax(0.0f, dist)); // same convention as VectorIndex::topK
+    }
+}
+
+int HnswIndex::randomLevel(int id) const {
+    // Level ~ floor(-ln(U) / ln(M)), with U derived from the row number (reproducible builds)
+    const double u = double((splitmix64(quint64(id)) >> 11) + 1) * (1.0 / 9007199254740992.0);
+    const double mL = 1.0 / std::log(double(params_.M));
+    return qMin(kMaxLevel, int(-std::log(u) * mL));
+}
+
+qint32* HnswIndex::links(int id, int level) {
+    if (level == 0) return links0_.data() + size_t(id) * size_t(1 + 2 * params_.M);
+    return upper_[size_t(id)].data() + size_t(level - 1) * size_t(1 + params_.M);
+}
+
+const qint32* HnswIndex::links(int id, int level) const {
+    if (level == 0) return links0_.data() + size_t(id) * size_t(1 + 2 * params_.M);
+    return upper_[size_t(id)].data() + size_t(level - 1) * size_t(1 + params_.M);
+}
+
+HnswIndex::Cand HnswIndex::greedy(const VectorIndex& v, const float* q, float nq, Cand cur, int level) const {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        const qint32* l = links(cur.id, level);
+        for (int j = 1; j <= l[0]; ++j) {
+            const float d = distance(v, q, nq, l[j]);
+            if (d < cur.dist || (d == cur.dist && l[j] < cur.id)) { cur = Cand{d, l[j]}; changed = true; }
+        }
+    }
+    return cur;
+}
+
+std::vector<HnswIndex::Cand> HnswIndex::searchLayer(const VectorIndex& v, const float* q, float nq,
+                                                    const Cand& entry, int ef, int level, Visited* vis) const {
+    std::priority_queue<Cand, std::vector<Cand>, CloserOnTop> candidates;
+    std::priority_queue<Cand, std::vector<Cand>, FartherOnTop> result;
+    vis->mark(entry.id);
+    candidates.push(entry);
+    result.push(entry);
+    while (!candidates.empty()) {
+        const Cand c = candidates.top();
+        if (c.dist > result.top().dist && int(result.size()) >= ef) break;
+        candidates.pop();
+        const qint32* l = links(c.id, level);
+        for (int j = 1; j <= l[0]; ++j) {
+            const int nb = l[j];
+            if (vis->test(nb)) continue;
+            vis->mark(nb);
+            const float d = distance(v, q, nq, nb);
+            if (int(result.size()) < ef || d < result.top().dist) {
+                candidates.push(Cand{d, nb});
+                result.push(Cand{d, nb});
+                if (int(result.size()) > ef) result.pop();
+            }
+        }
+    }
+    std::vector<Cand> out(result.size());
+    for (size_t i = out.size(); i > 0; --i) { out[i - 1] = result.top(); result.pop(); }
+    return out; // closest first
+}
+
+std::vector<HnswIndex::Cand> HnswIndex::selectNeighbors(const VectorIndex& v, const std::vector<Cand>& sorted, int m) const {
+    if (int(sorted.size()) <= m) return sorted;
+    // Diversity heuristic: keep a candidate only if it is closer to the base node than to
+    // every neighbour already kept (avoids clustering all links in one direction)
+    std::vector<Cand> kept;
+    kept.reserve(size_t(m));
+    for (const Cand& c : sorted) {
+        if (int(kept.size()) >= m) break;
+        const float* cv = v.row(c.id).data;
+        const float nc = v.norm(c.id);
+        bool good = true;
+        for (const Cand& r : kept) {
+            if (distance(v, cv, nc, r.id) < c.dist) { good = false; break; }
+        }
+        if (good) kept.push_back(c);
+    }
+    return kept;
+}
+
+void HnswIndex::connect(const VectorIndex& v, int from, int to, float dist, int level) {
+    qint32* l = links(from, level);
+    const int cap = maxLinks(level);
+    if (l[0] < cap) { l[++l[0]] = to; return; }
+    // Full: re-select among the current links plus the new one
+    const float* fv = v.row(from).data;
+    const float nf = v.norm(from);
+    std::vector<Cand> cands;
+    cands.reserve(size_t(cap + 1));
+    cands.push_back(Cand{dist, to});
+    for (int j = 1; j <= l[0]; ++j) cands.push_back(Cand{distance(v, fv, nf, l[j]), l[j]});
+    std::sort(cands.begin(), cands.end(), [](const Cand& a, const Cand& b) {
+        return a.dist < b.dist || (a.dist == b.dist && a.id < b.id);
+    });
+    const std::vector<Cand> sel = selectNeighbors(v, cands, cap);
+    l[0] = qint32(sel.size());
+    for (size_t j = 0; j < sel.size(); ++j) l[j + 1] = sel[j].id;
+}
+
+void HnswIndex::insert(const VectorIndex& v, int id) {
+    const float* q = v.row(id).data;
+    const float nq = v.norm(id);
+    const int level = randomLevel(id);
+    levels_.push_back(level);
+    links0_.resize(links0_.size() + size_t(1 + 2 * params_.M), 0);
+    upper_.emplace_back(size_t(level) * size_t(1 + params_.M), 0);
+    count_ = id + 1;
+    if (entry_ < 0) { entry_ = id; maxLevel_ = level; return; }
+
+    Cand cur{distance(v, q, nq, entry_), entry_};
+    for (int l = maxLevel_; l > level; --l) cur = greedy(v, q, nq, cur, l);
+    for (int l = qMin(level, maxLevel_); l >= 0; --l) {
+        buildVisited_.begin(count_);
+        const std::vector<Cand> w = searchLayer(v, q, nq, cur, params_.efConstruction, l, &buildVisited_);
+        const std::vector<Cand> nbrs = selectNeighbors(v, w, params_.M);
+        qint32* own = links(id, l);
+        own[0] = qint32(nbrs.size());
+        for (size_t j = 0; j < nbrs.size(); ++j) own[j + 1] = nbrs[j].id;
+        for (const Cand& nb : nbrs) connect(v, nb.id, id, nb.dist, l);
+        cur = w.front();
+    }
+    if (level > maxLevel_) { maxLevel_ = level; entry_ = id; }
+}
+
+int HnswIndex::addRows(const VectorIndex& vectors, const std::function<bool(int, int)>& progress) {
+    const int total = vectors.count();
+    if (total <= count_) return 0;
+    if (count_ == 0) dim_ = vectors.dim();
+    if (vectors.dim() != dim_) return 0;
+    const int first = count_;
+    levels_.reserve(size_t(total));
+    links0_.reserve(size_t(total) * size_t(1 + 2 * params_.M));
+    upper_.reserve(size_t(total));
+    for (int id = first; id < total; ++id) {
+        insert(vectors, id);
+        if (progress && ((id - first) % 1024 == 1023) && !progress(id + 1, total)) break;
+    }
+    if (progress) progress(count_, total);
+    fingerprint_ = count_ == total ? vectors.fingerprint() : 0;
+    return count_ - first;
+}
+
+QList<VectorIndex::Hit> HnswIndex::search(const VectorIndex& vectors, const QVector<float>& query, int k,
+                                          float minScore, int efSearch) const {
+    QList<VectorIndex::Hit> hits;
+    if (entry_ < 0 || k <= 0 || query.size() != dim_ || vectors.count() < count_ || vectors.dim() != dim_) return hits;
+    const float* q = query.constData();
+    const float nq = std::sqrt(VectorKernels::squaredNorm(q, dim_));
+    Cand cur{distance(vectors, q, nq, entry_), entry_};
+    for (int l = maxLevel_; l > 0; --l) cur = greedy(vectors, q, nq, cur, l);
+    const int ef = qMax(k, efSearch > 0 ? efSearch : params_.efSearch);
+    Visited* vis = acquireVisited();
+    vis->begin(count_);
+    const std::vector<Cand> w = searchLayer(vectors, q, nq, cur, ef, 0, vis);
+    releaseVisited(vis);
+    // w is closest first; scoreFromDistance is monotonic, so hits come out best first
+    for (const Cand& c : w) {
+        const float score = scoreFromDistance(c.dist);
+        if (!(score >= minScore)) continue;
+        hits.append(VectorIndex::Hit{c.id, score});
+        if (hits.size() >= k) break;
+    }
+    return hits;
+}
+
+HnswIndex::Visited* HnswIndex::acquireVisited() const {
+    QMutexLocker lock(&visitedMutex_);
+    if (visitedPool_.empty()) return new Visited();
+    Visited* v = visitedPool_.back().release();
+    visitedPool_.pop_back();
+    return v;
+}
+
+void HnswIndex::releaseVisited(Visited* vis) const {
+    QMutexLocker lock(&visitedMutex_);
+    visitedPool_.emplace_back(vis);
+}
+
+bool HnswIndex::isCompatible(const VectorIndex& vectors, VectorIndex::Metric metric, int M) const {
+    return count_ > 0 && metric_ == metric && params_.M == M && dim_ == vectors.dim() && count_ == vectors.count()
+        && fingerprint_ != 0 && fingerprint_ == vectors.fingerprint();
+}
+
+bool HnswIndex::save(const QString& path, QString* err) const {
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (err) *err = QObject::tr("Falha ao abrir índice HNSW '%1' para escrita: %2").arg(path, f.errorString());
+        return false;
+    }
+    const qint32 header[kHeaderInts] = { qint32(metric_), params_.M, params_.efConstruction, count_, dim_,
+                                         maxLevel_, entry_, 0 };
+    bool ok = f.write("HNS2", 4) == 4;
+    ok = ok && f.write(reinterpret_cast<const char*>(header), sizeof(header)) == qint64(sizeof(header));
+    ok = ok && f.write(reinterpret_cast<const char*>(&fingerprint_), sizeof(fingerprint_)) == qint64(sizeof(fingerprint_));
+    const qint64 levelBytes = qint64(levels_.size() * sizeof(qint32));
+    ok = ok && f.write(reinterpret_cast<const char*>(levels_.data()), levelBytes) == levelBytes;
+    const qint64 l0Bytes = qint64(links0_.size() * sizeof(qint32));
+    ok = ok && f.write(reinterpret_cast<const char*>(links0_.data()), l0Bytes) == l0Bytes;
+    for (const auto& up : upper_) {
+        if (!ok) break;
+        if (up.empty()) continue;
+        const qint64 bytes = qint64(up.size() * sizeof(qint32));
+        ok = f.write(reinterpret_cast<const char*>(up.data()), bytes) == bytes;
+    }
+    if (!ok || !f.commit()) {
+        if (err) *err = QObject::tr("Falha ao gravar índice HNSW '%1': %2").arg(path, f.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool HnswIndex::load(const QString& path, QString* err) {
+    auto invalid = [this, err, &path]() {
+        reset(metric_, params_);
+        if (err) *err = QObject::tr("Índice HNSW inválido: %1").arg(path);
+        return false;
+    };
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (err) *err = QObject::tr("Falha ao abrir índice HNSW '%1'").arg(path);
+        return false;
+    }
+    char magic[4];
+    qint32 h[kHeaderInts];
+    quint64 fingerprint = 0;
+    // HNS1 graphs carry no fingerprint and cannot be matched to a container: rebuilt by the indexer
+    if (f.read(magic, 4) != 4 || std::strncmp(magic, "HNS2", 4) != 0) return invalid();
+    if (f.read(reinterpret_cast<char*>(h), sizeof(h)) != qint64(sizeof(h))) return invalid();
+    if (f.read(reinterpret_cast<char*>(&fingerprint), sizeof(fingerprint)) != qint64(sizeof(fingerprint))) return invalid();
+    if (h[0] < 0 || h[0] > int(VectorIndex::Metric::L2) || h[1] < 2 || h[1] > 128 || h[3] < 0 || h[4] < 0
+        || h[5] < -1 || h[5] > kMaxLevel || h[6] < -1 || h[6] >= qMax(1, h[3])) return invalid();
+    Params p = params_;
+    p.M = h[1];
+    p.efConstruction = h[2];
+    reset(VectorIndex::Metric(h[0]), p);
+    const int n = h[3];
+    const size_t stride0 = size_t(1 + 2 * p.M);
+    const qint64 minBytes = 4 + qint64(sizeof(h)) + qint64(sizeof(fingerprint)) + qint64(n) * qint64(sizeof(qint32)) * qint64(1 + stride0);
+    if (f.size() < minBytes) return invalid();
+
+    levels_.resize(size_t(n));
+    links0_.resize(size_t(n) * stride0);
+    const qint64 levelBytes = qint64(levels_.size() * sizeof(qint32));
+    const qint64 l0Bytes = qint64(links0_.size() * sizeof(qint32));
+    if (f.read(reinterpret_cast<char*>(levels_.data()), levelBytes) != levelBytes) return invalid();
+    if (f.read(reinterpret_cast<char*>(links0_.data()), l0Bytes) != l0Bytes) return invalid();
+    upper_.resize(size_t(n));
+    for (int i = 0; i < n; ++i) {
+        const int lv = levels_[size_t(i)];
+        if (lv < 0 || lv > h[5]) return invalid();
+        if (lv == 0) continue;
+        auto& up = upper_[size_t(i)];
+        up.resize(size_t(lv) * size_t(1 + p.M));
+        const qint64 bytes = qint64(up.size() * sizeof(qint32));
+        if (f.read(reinterpret_cast<char*>(up.data()), bytes) != bytes) return invalid();
+    }
+    if (f.pos() != f.size()) return invalid();
+    // Validate every link once so queries never index out of range on a damaged file: neighbours
+    // are rows of the graph, and a neighbour on layer l has links on layer l (level >= l)
+    auto checkBlock = [this, n](const qint32* l, int cap, int level) {
+        if (l[0] < 0 || l[0] > cap) return false;
+        for (int j = 1; j <= l[0]; ++j) {
+            if (l[j] < 0 || l[j] >= n || levels_[size_t(l[j])] < level) return false;
+        }
+        return true;
+    };
+    for (int i = 0; i < n; ++i) {
+        if (!checkBlock(links0_.data() + size_t(i) * stride0, 2 * p.M, 0)) return invalid();
+        for (int l = 1; l <= levels_[size_t(i)]; ++l) {
+            if (!checkBlock(upper_[size_t(i)].data() + size_t(l - 1) * size_t(1 + p.M), p.M, l)) return invalid();
+        }
+    }
+    // The descent starts at the entry on the top layer
+    if ((n > 0) != (h[6] >= 0)) return invalid();
+    if (n > 0 && levels_[size_t(h[6])] != h[5]) return invalid();
+    count_ = n;
+    dim_ = h[4];
+    maxLevel_ = h[5];
+    entry_ = h[6];
+    fingerprint_ = fingerprint;
+    return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "ai/VectorIndex.h"
+
+// Approximate nearest-neighbour index (HNSW, Malkov & Yashunin) over the rows of a VectorIndex.
+//
+// The graph only stores neighbour lists (row numbers): vectors and norms stay in the ".gidx"
+// container (VECS and NRMS sections), so one (mapped) VectorIndex serves both the exact scan
+// and the graph search. Rows are
+// inserted incrementally with addRows(), which lets the graph follow an index that grows.
+// Node levels come from a hash of the row number, so building twice gives the same graph.
+//
+// File format (".hnsw", little-endian): magic "HNS2" + metric + M + efConstruction + count + dim
+// + maxLevel + entry + reserved (int32 each) + fingerprint (uint64, VectorIndex::fingerprint()
+// of the rows the graph was built from), then levels (int32[count]), the layer-0 link block
+// (count * (1 + 2M) int32: size followed by neighbours) and, for each node with level > 0,
+// its upper links (level * (1 + M) int32).
+class HnswIndex {
+public:
+    struct Params {
+        int M {16};               // links per node on upper layers (2*M on layer 0)
+        int efConstruction {200}; // candidate list size while inserting
+        int efSearch {64};        // candidate list size while querying: recall vs latency
+    };
+
+    HnswIndex() = default;
+    HnswIndex(const HnswIndex&) = delete;
+    HnswIndex& operator=(const HnswIndex&) = delete;
+
+    // Drops the graph and fixes metric/parameters for the next insertions
+    void reset(VectorIndex::Metric metric, const Params& p);
+    // Inserts rows [count(), vectors.count()). progress(done, total) may return false to stop
+    // early; rows inserted so far stay valid. Returns the number of rows inserted.
+    int addRows(const VectorIndex& vectors, const std::function<bool(int, int)>& progress = {});
+
+    // Up to k hits ordered by score (desc), scored like VectorIndex::topK(); rows below
+    // minScore are dropped. efSearch <= 0 uses params().efSearch. Safe to call concurrently.
+    QList<VectorIndex::Hit> search(const VectorIndex& vectors, const QVector<float>& query, int k,
+                                   float minScore = -std::numeric_limits<float>::infinity(),
+                                   int efSearch = 0) const;
+
+    bool save(const QString& path, QString* err = nullptr) const;
+    bool load(const QString& path, QString* err = nullptr);
+
+    // True when the graph covers exactly the rows of vectors (same count and fingerprint) with
+    // the given metric and M. Computes vectors.fingerprint(): check once per loaded index.
+    bool isCompatible(const VectorIndex& vectors, VectorIndex::Metric metric, int M) const;
+
+    int count() const { return count_; }
+    int dim() const { return dim_; }
+    bool isEmpty() const { return count_ == 0; }
+    VectorIndex::Metric metric() const { return metric_; }
+    const Params& params() const { return params_; }
+    void setEfSearch(int ef) { params_.efSearch = qMax(1, ef); }
+
+private:
+    struct Cand { float dist; int id; };
+    // Visited marks with an epoch counter, so clearing between searches is O(1)
+    struct Visited {
+        std::vector<quint32> marks;
+        quint32 epoch {0};
+        void begin(int n);
+        bool test(int i) const { return marks[size_t(i)] == epoch; }
+        void mark(int i) { marks[size_t(i)] = epoch; }
+    };
+
+    float distance(const VectorIndex& v, const float* q, float nq, int id) const;
+    float scoreFromDistance(float dist) const;
+    int randomLevel(int id) const;
+    int maxLinks(int level) const { return level == 0 ? 2 * params_.M : params_.M; }
+    qint32* links(int id, int level);
+    const qint32* links(int id, int level) const;
+    Cand greedy(const VectorIndex& v, const float* q, float nq, Cand cur, int level) const;
+    std::vector<Cand> searchLayer(const VectorIndex& v, const float* q, float nq, const Cand& entry,
+                                  int ef, int level, Visited* vis) const;
+    std::vector<Cand> selectNeighbors(const VectorIndex& v, const std::vector<Cand>& sorted, int m) const;
+    void connect(const VectorIndex& v, int from, int to, float dist, int level);
+    void insert(const VectorIndex& v, int id);
+    Visited* acquireVisited() const;
+    void releaseVisited(Visited* vis) const;
+
+    VectorIndex::Metric metric_ {VectorIndex::Metric::Cosine};
+    Params params_;
+    int count_ {0};
+    int dim_ {0};
+    int maxLevel_ {-1};
+    int entry_ {-1};
+    quint64 fingerprint_ {0}; // of the vectors covered by the graph; 0 after a partial addRows()
+    std::vector<qint32> levels_;
+    std::vector<qint32> links0_;              // count * (1 + 2M)
+    std::vector<std::vector<qint32>> upper_;  // per node: level * (1 + M)
+
+    Visited buildVisited_;
+    mutable QMutex visitedMutex_;
+    mutable std::vector<std::unique_ptr<Visited>> visitedPool_;
+};
@@ -0,0 +1,131 @@
+#include "ai/PageTextCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QSaveFile>
+#include <QtGlobal>
+#include <cstring>
+
+namespace {
+constexpr quint32 kCacheVersion = 1;
+constexpr int kHeaderSize = 32;
+constexpr quint32 kFlagOcr = 1;
+// zlib level: text compresses ~3x at level 1 already, and level 1 keeps saving a large book fast
+constexpr int kCompressionLevel = 1;
+
+struct Stamp { qint64 size {-1}; qint64 mtimeMs {0}; };
+
+Stamp stampOf(const QString& pdfPath) {
+    const QFileInfo fi(pdfPath);
+    if (!fi.exists()) return Stamp{};
+    return Stamp{ fi.size(), fi.lastModified().toMSecsSinceEpoch() };
+}
+
+template <typename T> void put(QByteArray* out, T v) {
+    out->append(reinterpret_cast<const char*>(&v), int(sizeof v));
+}
+
+template <typename T> bool get(const QByteArray& in, int* pos, T* v) {
+    if (*pos + int(sizeof *v) > in.size()) return false;
+    std::memcpy(v, in.constData() + *pos, sizeof *v);
+    *pos += int(sizeof *v);
+    return true;
+}
+}
+
+QString PageTextCache::pathFor(const QString& dbDir, const QString& pdfPath) {
+    const QByteArray hash = QCryptographicHash::hash(QFileInfo(pdfPath).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(dbDir).filePath(QStringLiteral("pages_%1.ptc").arg(QString::fromLatin1(hash)));
+}
+
+bool PageTextCache::load(const QString& path, const QString& pdfPath, QString* err) {
+    texts_.clear();
+    sources_.clear();
+    ocrApplied_ = false;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false; // no cache yet: not an error
+    const QByteArray head = f.read(kHeaderSize);
+    int pos = 4;
+    quint32 version = 0, flags = 0;
+    qint64 size = 0, mtimeMs = 0;
+    qint32 pages = 0;
+    if (head.size() != kHeaderSize || std::memcmp(head.constData(), "GPTC", 4) != 0
+        || !get(head, &pos, &version) || !get(head, &pos, &size) || !get(head, &pos, &mtimeMs)
+        || !get(head, &pos, &pages) || !get(head, &pos, &flags) || pages < 0) {
+        if (err) *err = QObject::tr("Cache de texto inválido: %1").arg(path);
+        return false;
+    }
+    const Stamp now = stampOf(pdfPath);
+    if (version != kCacheVersion || size != now.size || mtimeMs != now.mtimeMs) return false; // stale
+    const QByteArray payload = qUncompress(f.readAll());
+    QStringList texts;
+    QVector<Source> sources;
+    texts.reserve(pages);
+    sources.reserve(pages);
+    pos = 0;
+    for (qint32 i = 0; i < pages; ++i) {
+        quint8 src = 0;
+        qint32 len = 0;
+        if (!get(payload, &pos, &src) || !get(payload, &pos, &len) || len < 0 || len > payload.size() - pos
+            || src > quint8(Source::Ocr)) {
+            if (err) *err = QObject::tr("Cache de texto corrompido: %1").arg(path);
+            return false;
+        }
+        texts << QString::fromUtf8(payload.constData() + pos, len);
+        sources << Source(src);
+        pos += len;
+    }
+    texts_ = std::move(texts);
+    sources_ = std::move(sources);
+    ocrApplied_ = (flags & kFlagOcr) != 0;
+    return true;
+}
+
+bool PageTextCache::save(const QString& path, const QString& pdfPath, QString* err) const {
+    const Stamp stamp = stampOf(pdfPath);
+    if (stamp.size < 0) {
+        if (err) *err = QObject::tr("PDF não encontrado: %1").arg(pdfPath);
+        return false;
+    }
+    QByteArray payload;
+    for (int i = 0; i < texts_.size(); ++i) {
+        const QByteArray utf8 = texts_.at(i).toUtf8();
+        put(&payload, quint8(sources_.value(i, Source::None)));
+        put(&payload, qint32(utf8.size()));
+        payload.append(utf8);
+    }
+    QByteArray head;
+    head.append("GPTC", 4);
+    put(&head, kCacheVersion);
+    put(&head, stamp.size);
+    put(&head, stamp.mtimeMs);
+    put(&head, qint32(texts_.size()));
+    put(&head, ocrApplied_ ? kFlagOcr : quint32(0));
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile out(path);
+    const QByteArray body = qCompress(payload, kCompressionLevel);
+    if (!out.open(QIODevice::WriteOnly) || out.write(head) != head.size() || out.write(body) != body.size()
+        || !out.commit()) {
+        if (err) *err = QObject::tr("Falha ao gravar cache de texto '%1': %2").arg(path, out.errorString());
+        return false;
+    }
+    return true;
+}
+
+void PageTextCache::reset(int pageCount, bool ocrApplied) {
+    texts_.clear();
+    sources_.clear();
+    for (int i = 0; i < pageCount; ++i) texts_ << QString();
+    sources_.fill(Source::None, qMax(0, pageCount));
+    ocrApplied_ = ocrApplied;
+}
+
+void PageTextCache::setPage(int page, const QString& text, Source source) {
+    if (page < 1 || page > texts_.size()) return;
+    texts_[page - 1] = text;
+    sources_[page - 1] = source;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "ai/PageTextExtractor.h"
+
+// Extracted text of every page of one document, persisted as <emb/db_path>/pages_<sha1(path)>.ptc
+// so reopening a book (or re-indexing it) does not run QtPdf, pdftotext or OCR again.
+//
+// The file is only valid for the exact PDF it was built from: its size and modification time are
+// stored in the header and load() rejects the cache when they differ. The indexer writes it after
+// a complete extraction (OCR included); the viewer writes it when it extracted the text itself,
+// without OCR, which the ocrApplied() flag records so the indexer still OCRs the blank pages.
+//
+// File layout (little-endian): 32-byte header "GPTC", u32 version, i64 PDF size, i64 PDF mtime
+// (ms since epoch), i32 page count, u32 flags; then a qCompress'ed payload of one record per page,
+// [u8 source][i32 byte length][UTF-8 text].
+class PageTextCache {
+public:
+    using Source = PageTextExtractor::Source;
+
+    // Cache file of pdfPath under dbDir
+    static QString pathFor(const QString& dbDir, const QString& pdfPath);
+
+    // Reads path when it was built from pdfPath as it is now; false when missing, stale or corrupt
+    bool load(const QString& path, const QString& pdfPath, QString* err = nullptr);
+    // Writes the pages atomically, stamped with pdfPath's current size and mtime
+    bool save(const QString& path, const QString& pdfPath, QString* err = nullptr) const;
+
+    // Starts over with pageCount blank pages
+    void reset(int pageCount, bool ocrApplied);
+    // 1-based page
+    void setPage(int page, const QString& text, Source source);
+
+    int pageCount() const { return texts_.size(); }
+    const QStringList& texts() const { return texts_; }
+    QString text(int page) const { return texts_.value(page - 1); }
+    Source source(int page) const { return sources_.value(page - 1, Source::None); }
+    // Blank pages went through OCR when the cache was built
+    bool ocrApplied() const { return ocrApplied_; }
+
+private:
+    QStringList texts_;
+    QVector<Source> sources_;
+    bool ocrApplied_ {false};
+};
@@ -0,0 +1,182 @@
+#include "ai/PageTextExtractor.h"
+
+#include <QObject>
+#include <QBuffer>
+#include <QImage>
+#include <QPdfDocument>
+#include <QPdfSelection>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QtGlobal>
+
+namespace {
+// Longest run of text-less pages handed to a single pdftotext call (bounds the buffered output)
+constexpr int kMaxFallbackRun = 64;
+// Longest side of a page rendered for OCR, in pixels (posters and maps would not fit in memory)
+constexpr int kMaxOcrSide = 8000;
+
+bool isBlank(const QString& s) {
+    for (const QChar c : s) if (!c.isSpace()) return false;
+    return true;
+}
+}
+
+PageTextExtractor::PageTextExtractor() : externalFallback_(hasPdfToText()) {}
+
+PageTextExtractor::~PageTextExtractor() = default;
+
+bool PageTextExtractor::hasPdfToText() {
+    static const bool has = !QStandardPaths::findExecutable(QStringLiteral("pdftotext")).isEmpty();
+    return has;
+}
+
+bool PageTextExtractor::open(const QString& pdfPath, QString* err) {
+    owned_ = std::make_unique<QPdfDocument>();
+    doc_ = nullptr;
+    path_ = pdfPath;
+    if (owned_->load(pdfPath) != static_cast<QPdfDocument::Error>(0)) {
+        owned_.reset();
+        if (err) *err = QObject::tr("Falha ao abrir PDF '%1'.").arg(pdfPath);
+        return false;
+    }
+    doc_ = owned_.get();
+    return true;
+}
+
+bool PageTextExtractor::attach(QPdfDocument* doc, const QString& pdfPath) {
+    owned_.reset();
+    doc_ = doc;
+    path_ = pdfPath;
+    return doc_ != nullptr && doc_->pageCount() > 0;
+}
+
+int PageTextExtractor::pageCount() const {
+    return doc_ ? doc_->pageCount() : 0;
+}
+
+QString PageTextExtractor::qtPdfText(int page) const {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
+    if (!doc_ || page < 1 || page > doc_->pageCount()) return QString();
+    QString t = doc_->getAllText(page - 1).text();
+    // PDFium ends lines with CR LF; keep LF like pdftotext -eol unix
+    t.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+    t.replace(QChar('\r'), QChar('\n'));
+    return t;
+#else
+    Q_UNUSED(page);
+    return QString();
+#endif
+}
+
+QString PageTextExtractor::pageText(int page, Source* source) {
+    QString t = qtPdfText(page);
+    Source src = isBlank(t) ? Source::None : Source::QtPdf;
+    if (src == Source::None && externalFallback_) {
+        t = pdfToTextRange(path_, page, page).value(0);
+        if (!isBlank(t)) src = Source::PdfToText;
+    }
+    if (src == Source::None && ocrFallback_) {
+        t = ocrText(page);
+        if (!isBlank(t)) src = Source::Ocr;
+    }
+    if (source) *source = src;
+    return t;
+}
+
+int PageTextExtractor::forEachPage(int first, int last,
+                                   const std::function<bool(int, const QString&, Source)>& consume) {
+    first = qMax(1, first);
+    last = qMin(last, pageCount());
+    int delivered = 0;
+    // Last resort for pages no backend could read
+    auto deliver = [&](int pg, QString t, Source src) {
+        if (src == Source::None && ocrFallback_) {
+            t = ocrText(pg);
+            if (!isBlank(t)) src = Source::Ocr;
+        }
+        if (!consume(pg, t, src)) return false;
+        ++delivered;
+        return true;
+    };
+    int page = first;
+    QString text = page <= last ? qtPdfText(page) : QString();
+    while (page <= last) {
+        if (!externalFallback_ || !isBlank(text)) {
+            if (!deliver(page, text, isBlank(text) ? Source::None : Source::QtPdf)) return delivered;
+            if (++page <= last) text = qtPdfText(page);
+            continue;
+        }
+        // Run of pages without a usable text layer: one pdftotext process for the whole run
+        int runEnd = page;
+        QString after; // QtPdf text of the page right after the run, read while measuring it
+        bool haveAfter = false;
+        while (runEnd < last && runEnd - page + 1 < kMaxFallbackRun) {
+            after = qtPdfText(runEnd + 1);
+            if (!isBlank(after)) { haveAfter = true; break; }
+            ++runEnd;
+        }
+        const QStringList ext = pdfToTextRange(path_, page, runEnd);
+        for (int pg = page; pg <= runEnd; ++pg) {
+            const QString t = ext.value(pg - page);
+            if (!deliver(pg, t, isBlank(t) ? Source::None : Source::PdfToText)) return delivered;
+        }
+        page = runEnd + 1;
+        if (page <= last) text = haveAfter ? after : qtPdfText(page);
+    }
+    return delivered;
+}
+
+QStringList PageTextExtractor::pdfToTextRange(const QString& pdfPath, int first, int last, int timeoutMs) {
+    QStringList pages;
+    if (last < first || pdfPath.isEmpty() || !hasPdfToText()) return pages;
+    QProcess proc;
+    const QStringList args{ "-q", "-layout", "-eol", "unix", "-f", QString::number(first), "-l", QString::number(last), pdfPath, "-" };
+    proc.start(QStringLiteral("pdftotext"), args);
+    if (!proc.waitForStarted(2000)) return pages;
+    proc.waitForFinished(timeoutMs);
+    // pdftotext terminates every page with a form feed
+    pages = QString::fromUtf8(proc.readAllStandardOutput()).split(QChar('\f'));
+    const int n = last - first + 1;
+    while (pages.size() > n) pages.removeLast();
+    while (pages.size() < n) pages.append(QString());
+    return pages;
+}
+
+bool PageTextExtractor::hasOcr() {
+    static const bool has = !QStandardPaths::findExecutable(QStringLiteral("tesseract")).isEmpty();
+    return has;
+}
+
+QString PageTextExtractor::ocrText(int page, int timeoutMs) const {
+    if (!doc_ || page < 1 || page > doc_->pageCount() || !hasOcr()) return QString();
+    const QSizeF points = doc_->pagePointSize(page - 1);
+    if (points.isEmpty()) return QString();
+    // Scale to kOcrDpi (72 points per inch), shrinking oversized pages to kMaxOcrSide
+    qreal scale = kOcrDpi / 72.0;
+    scale = qMin(scale, kMaxOcrSide / qMax(points.width(), points.height()));
+    const QSize px(qMax(1, qRound(points.width() * scale)), qMax(1, qRound(points.height() * scale)));
+    const QImage img = doc_->render(page - 1, px);
+    if (img.isNull()) return QString();
+    return ocrImage(img.convertToFormat(QImage::Format_Grayscale8), qRound(scale * 72.0), timeoutMs);
+}
+
+QString PageTextExtractor::ocrImage(const QImage& image, int dpi, int timeoutMs) {
+    if (image.isNull() || !hasOcr()) return QString();
+    QByteArray png;
+    {
+        QBuffer buf(&png);
+        buf.open(QIODevice::WriteOnly);
+        if (!image.save(&buf, "PNG")) return QString();
+    }
+    QProcess ocr;
+    ocr.start(QStringLiteral("tesseract"), QStringList{ "stdin", "stdout", "-l", "por+eng", "--psm", "6", "--dpi", QString::number(dpi) });
+    if (!ocr.waitForStarted(2000)) return QString();
+    ocr.write(png);
+    ocr.closeWriteChannel();
+    if (!ocr.waitForFinished(timeoutMs)) {
+        ocr.kill();
+        ocr.waitForFinished(2000);
+        return QString();
+    }
+    return QString::fromUtf8(ocr.readAllStandardOutput());
+}
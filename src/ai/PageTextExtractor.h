@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <memory>
+
+class QImage;
+class QPdfDocument;
+
+// Text layer of a PDF, page by page, without one external process per page.
+//
+// The document is parsed once (QPdfDocument / PDFium, already a dependency of the viewer) and
+// pages are read from it in order. pdftotext stays as a fallback for pages whose text QtPdf
+// cannot produce (and for Qt < 6.4, which lacks QPdfDocument::getAllText()); when it is needed
+// it is run once per contiguous run of such pages, not once per page. Pages that are still blank
+// can optionally be OCRed: the page is rendered in process and piped to tesseract, without
+// temporary image files.
+//
+// Not thread-safe: use one extractor per thread.
+class PageTextExtractor {
+public:
+    enum class Source { None, QtPdf, PdfToText, Ocr };
+
+    PageTextExtractor();
+    ~PageTextExtractor();
+    PageTextExtractor(const PageTextExtractor&) = delete;
+    PageTextExtractor& operator=(const PageTextExtractor&) = delete;
+
+    // Loads pdfPath into an owned QPdfDocument
+    bool open(const QString& pdfPath, QString* err = nullptr);
+    // Reads from an already loaded document (e.g. the viewer's); doc must outlive the extractor.
+    // pdfPath is only used by the pdftotext fallback.
+    bool attach(QPdfDocument* doc, const QString& pdfPath);
+
+    int pageCount() const;
+    // Enables the pdftotext fallback for blank pages (default: on when pdftotext is installed)
+    void setExternalFallback(bool on) { externalFallback_ = on && hasPdfToText(); }
+    // Enables OCR of pages left blank by both backends (default: off)
+    void setOcrFallback(bool on) { ocrFallback_ = on && hasOcr(); }
+
+    // Text of one 1-based page; *source tells which backend produced it (None when blank)
+    QString pageText(int page, Source* source = nullptr);
+
+    // Streams pages [first, last] (1-based, inclusive) in page order. consume() returns false
+    // to stop. Returns the number of pages delivered.
+    int forEachPage(int first, int last, const std::function<bool(int, const QString&, Source)>& consume);
+
+    static bool hasPdfToText();
+    // Runs one pdftotext process over pages [first, last] and splits its output on the form
+    // feeds pdftotext writes after each page. Returns last - first + 1 entries (empty on failure).
+    static QStringList pdfToTextRange(const QString& pdfPath, int first, int last, int timeoutMs = 120000);
+    // tesseract is installed (pages are rendered by QtPdf)
+    static bool hasOcr();
+    // Renders one 1-based page at kOcrDpi and returns the text tesseract reads from it
+    QString ocrText(int page, int timeoutMs = kOcrTimeoutMs) const;
+    // Runs tesseract on an image rendered at dpi, fed through its stdin
+    static QString ocrImage(const QImage& image, int dpi, int timeoutMs = kOcrTimeoutMs);
+
+    static constexpr int kOcrDpi = 200;
+    static constexpr int kOcrTimeoutMs = 60000;
+
+private:
+    QString qtPdfText(int page) const;
+
+    std::unique_ptr<QPdfDocument> owned_;
+    QPdfDocument* doc_ {nullptr};
+    QString path_;
+    bool externalFallback_ {false};
+    bool ocrFallback_ {false};
+};
@@ -0,0 +1,180 @@
+#include "ai/ParallelPageExtractor.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QThread>
+#include <QThreadPool>
+#include <QHash>
+#include <QtGlobal>
+#include <set>
+
+namespace {
+bool isBlank(const QString& s) {
+    for (const QChar c : s) if (!c.isSpace()) return false;
+    return true;
+}
+
+struct PageResult {
+    QString text;
+    PageTextExtractor::Source source {PageTextExtractor::Source::None};
+    bool awaitingOcr {false}; // blank so far, queued for the OCR workers
+};
+
+// Shared by the workers and the delivering thread; every field is guarded by mutex
+struct SharedState {
+    QMutex mutex;
+    QWaitCondition produced; // a page was stored (or a worker finished)
+    QWaitCondition consumed; // the delivery cursor moved (or cancel was set)
+    QWaitCondition ocrQueued; // a page was queued for OCR (or extraction finished, or cancel)
+    QHash<int, PageResult> ready; // reorder buffer: page -> result
+    std::set<int> ocrQueue; // pages waiting for an OCR worker, taken lowest first
+    int nextFirst {1};  // first page of the next unclaimed range
+    int cursor {1};     // next page to deliver
+    int running {0};    // workers still claiming ranges
+    int ocrStarted {0}; // OCR workers started so far
+    int ocrPending {0}; // pages queued or being OCRed
+    bool cancel {false};
+};
+}
+
+ParallelPageExtractor::ParallelPageExtractor(const QString& pdfPath, const Options& opt)
+    : path_(pdfPath), opt_(opt) {
+    workers_ = opt_.workers > 0 ? opt_.workers : qMax(1, QThread::idealThreadCount());
+    ocrWorkers_ = opt_.ocrWorkers > 0 ? opt_.ocrWorkers : qMax(1, QThread::idealThreadCount());
+    opt_.pagesPerTask = qMax(1, opt_.pagesPerTask);
+    if (opt_.maxPagesAhead <= 0) opt_.maxPagesAhead = 4 * workers_ * opt_.pagesPerTask;
+    opt_.maxPagesAhead = qMax(opt_.maxPagesAhead, opt_.pagesPerTask);
+}
+
+int ParallelPageExtractor::pageCount(QString* err) {
+    if (pageCount_ >= 0) return pageCount_;
+    PageTextExtractor probe;
+    pageCount_ = probe.open(path_, err) ? probe.pageCount() : 0;
+    return pageCount_;
+}
+
+int ParallelPageExtractor::run(const std::function<bool(int, const QString&, Source)>& consume, QString* err) {
+    const int total = pageCount(err);
+    if (total <= 0) return 0;
+    const int workers = qMin(workers_, (total + opt_.pagesPerTask - 1) / opt_.pagesPerTask);
+    QThread* caller = QThread::currentThread();
+    auto stopRequested = [this, caller]() {
+        return caller->isInterruptionRequested() || (opt_.cancelled && opt_.cancelled());
+    };
+
+    SharedState st;
+    st.running = workers;
+    const bool ocr = opt_.ocr && PageTextExtractor::hasOcr();
+    // Private pools: never compete with the search shards on the global one
+    QThreadPool ocrPool;
+    ocrPool.setMaxThreadCount(ocrWorkers_);
+    auto ocrWorker = [this, &st]() {
+        PageTextExtractor ex;
+        const bool opened = ex.open(path_);
+        for (;;) {
+            int page = 0;
+            {
+                QMutexLocker lock(&st.mutex);
+                while (!st.cancel && st.ocrQueue.empty() && st.running > 0)
+                    st.ocrQueued.wait(&st.mutex);
+                if (st.cancel || st.ocrQueue.empty()) break;
+                page = *st.ocrQueue.begin();
+                st.ocrQueue.erase(st.ocrQueue.begin());
+            }
+            const QString text = opened ? ex.ocrText(page) : QString();
+            QMutexLocker lock(&st.mutex);
+            --st.ocrPending;
+            PageResult& r = st.ready[page];
+            r.awaitingOcr = false;
+            if (!isBlank(text)) {
+                r.text = text;
+                r.source = Source::Ocr;
+            }
+            st.produced.wakeAll();
+        }
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (int w = 0; w < workers; ++w) {
+        pool.start([this, &st, &ocrPool, &ocrWorker, ocr, total]() {
+            PageTextExtractor ex;
+            const bool opened = ex.open(path_);
+            for (;;) {
+                int first = 0, last = 0;
+                {
+                    QMutexLocker lock(&st.mutex);
+                    // Stay within the window ahead of the delivery cursor
+                    while (!st.cancel && st.nextFirst <= total && st.nextFirst - st.cursor >= opt_.maxPagesAhead)
+                        st.consumed.wait(&st.mutex);
+                    if (st.cancel || st.nextFirst > total) break;
+                    first = st.nextFirst;
+                    last = qMin(total, first + opt_.pagesPerTask - 1);
+                    st.nextFirst = last + 1;
+                }
+                auto store = [&](int page, const QString& text, Source src) {
+                    QMutexLocker lock(&st.mutex);
+                    if (st.cancel) return false;
+                    const bool queue = ocr && opened && src == Source::None;
+                    st.ready.insert(page, PageResult{ text, src, queue });
+                    if (queue) {
+                        st.ocrQueue.insert(page);
+                        ++st.ocrPending;
+                        // OCR workers start with the first pages that need them
+                        if (st.ocrStarted < ocrWorkers_ && st.ocrStarted < st.ocrPending) {
+                            ++st.ocrStarted;
+                            ocrPool.start(ocrWorker);
+                        }
+                        st.ocrQueued.wakeOne();
+                    }
+                    st.produced.wakeAll();
+                    return true;
+                };
+                int done = opened ? ex.forEachPage(first, last, store) : 0;
+                // Unreadable document (or stopped early): pages still owed are delivered blank
+                for (int page = first + done; page <= last; ++page)
+                    if (!store(page, QString(), Source::None)) break;
+            }
+            QMutexLocker lock(&st.mutex);
+            --st.running;
+            st.produced.wakeAll();
+            st.ocrQueued.wakeAll(); // idle OCR workers exit once nothing more can be queued
+        });
+    }
+
+    int delivered = 0;
+    for (int page = 1; page <= total; ++page) {
+        PageResult r;
+        bool have = false;
+        {
+            QMutexLocker lock(&st.mutex);
+            auto isReady = [&st, page]() {
+                const auto it = st.ready.constFind(page);
+                return it != st.ready.cend() && !it->awaitingOcr;
+            };
+            while (!(have = isReady()) && (st.running > 0 || st.ocrPending > 0) && !stopRequested())
+                st.produced.wait(&st.mutex, 100); // wake up periodically to honour interruption
+            if (have) {
+                r = st.ready.take(page);
+                st.cursor = page + 1;
+                st.consumed.wakeAll();
+            }
+        }
+        if (!have || stopRequested()) break;
+        if (!consume(page, r.text, r.source)) break;
+        ++delivered;
+    }
+    {
+        QMutexLocker lock(&st.mutex);
+        st.cancel = true;
+        st.consumed.wakeAll();
+        st.ocrQueued.wakeAll();
+    }
+    pool.waitForDone();
+    ocrPool.waitForDone();
+    if (delivered < total && err && err->isEmpty() && stopRequested())
+        *err = QObject::tr("Extração de texto interrompida.");
+    return delivered;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QString>
+#include <functional>
+
+#include "ai/PageTextExtractor.h"
+
+// Extracts the pages of a PDF on a bounded pool of workers and hands them back in page order.
+//
+// Pages are cut into fixed-size ranges; each worker owns a PageTextExtractor and claims the next
+// range, so pdftotext runs (an external process per run of text-less pages) proceed in parallel.
+// QtPdf text itself goes through PDFium, which Qt serializes behind a global lock, so that part
+// gains little from more workers. Workers never run more than maxPagesAhead pages past the page
+// being delivered, which bounds the memory held in the reorder buffer.
+//
+// Pages still blank are not OCRed by the extraction workers: they are queued for a separate pool
+// of OCR workers (started on the first such page), each rendering pages from its own document
+// and running one tesseract at a time, lowest page first. Extraction keeps going meanwhile, and
+// every page before the first one waiting for OCR is delivered (and can be embedded) as soon
+// as it is ready.
+//
+// run() blocks the calling thread; it stops early when consume() returns false, when the
+// calling thread's isInterruptionRequested() is set or Options::cancelled() returns true, and
+// always waits for its workers.
+class ParallelPageExtractor {
+public:
+    struct Options {
+        int workers {0};        // 0 = QThread::idealThreadCount()
+        int pagesPerTask {8};   // pages per claimed range
+        int maxPagesAhead {0};  // 0 = 4 ranges per worker
+        bool ocr {true};        // OCR pages left blank by QtPdf and pdftotext
+        int ocrWorkers {0};     // 0 = QThread::idealThreadCount()
+        // Extra stop condition polled by run(), for callers running it off their own thread
+        std::function<bool()> cancelled;
+    };
+    using Source = PageTextExtractor::Source;
+
+    ParallelPageExtractor(const QString& pdfPath, const Options& opt);
+
+    // Page count of the document (opens it once); 0 when it cannot be read
+    int pageCount(QString* err = nullptr);
+
+    // Delivers pages [1, pageCount()] in order. Returns the number of pages delivered.
+    int run(const std::function<bool(int, const QString&, Source)>& consume, QString* err = nullptr);
+
+    int workerCount() const { return workers_; }
+    int ocrWorkerCount() const { return ocrWorkers_; }
+
+private:
+    QString path_;
+    Options opt_;
+    int workers_ {1};
+    int ocrWorkers_ {1};
+    int pageCount_ {-1};
+};
@@ -0,0 +1,230 @@
+#include "ai/QuantizedIndex.h"
+#include "ai/VectorKernels.h"
+
+#include <QObject>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// Same total order as VectorIndex::topK(): score desc, row asc
+inline bool betterHit(const VectorIndex::Hit& a, const VectorIndex::Hit& b) {
+    return a.score > b.score || (a.score == b.score && a.index < b.index);
+}
+
+// Bounded selection of the best n hits, returned best first
+class HitSelector {
+public:
+    explicit HitSelector(int n) : n_(n) { heap_.reserve(size_t(qMax(0, n))); }
+    void offer(int index, float score) {
+        if (n_ <= 0 || !(score == score)) return; // NaN never wins
+        const VectorIndex::Hit h{index, score};
+        if (int(heap_.size()) < n_) {
+            heap_.push_back(h);
+            std::push_heap(heap_.begin(), heap_.end(), betterHit);
+        } else if (betterHit(h, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), betterHit);
+            heap_.back() = h;
+            std::push_heap(heap_.begin(), heap_.end(), betterHit);
+        }
+    }
+    QList<VectorIndex::Hit> take() {
+        std::sort_heap(heap_.begin(), heap_.end(), betterHit);
+        QList<VectorIndex::Hit> out;
+        out.reserve(qsizetype(heap_.size()));
+        for (const auto& h : heap_) out.append(h);
+        heap_.clear();
+        return out;
+    }
+private:
+    int n_;
+    std::vector<VectorIndex::Hit> heap_;
+};
+
+float exactScore(const VectorIndex& v, const float* q, float nq, int i, VectorIndex::Metric metric) {
+    const float* r = v.row(i).data;
+    const int d = v.dim();
+    if (metric == VectorIndex::Metric::Cosine) {
+        const float nv = v.norm(i);
+        const float dp = VectorKernels::dot(q, r, d);
+        return (nq > 0 && nv > 0) ? dp / (nq * nv) : 0.0f;
+    }
+    if (metric == VectorIndex::Metric::Dot) return VectorKernels::dot(q, r, d);
+    return -std::sqrt(VectorKernels::squaredL2(q, r, d));
+}
+}
+
+void QuantizedIndex::clear() {
+    count_ = 0; dim_ = 0; fingerprint_ = 0;
+    mins_.clear(); scales_.clear(); codes_.clear();
+}
+
+void QuantizedIndex::build(const VectorIndex& vectors) {
+    clear();
+    const int n = vectors.count();
+    const int d = vectors.dim();
+    if (n == 0 || d <= 0) return;
+    mins_.assign(size_t(d), std::numeric_limits<float>::max());
+    std::vector<float> maxs(size_t(d), std::numeric_limits<float>::lowest());
+    for (int i = 0; i < n; ++i) {
+        const float* r = vectors.row(i).data;
+        for (int j = 0; j < d; ++j) {
+            mins_[size_t(j)] = std::min(mins_[size_t(j)], r[j]);
+            maxs[size_t(j)] = std::max(maxs[size_t(j)], r[j]);
+        }
+    }
+    scales_.resize(size_t(d));
+    std::vector<float> inv(static_cast<size_t>(d));
+    for (int j = 0; j < d; ++j) {
+        const float range = maxs[size_t(j)] - mins_[size_t(j)];
+        scales_[size_t(j)] = range > 0 ? range / 255.0f : 0.0f;
+        inv[size_t(j)] = range > 0 ? 255.0f / range : 0.0f;
+    }
+    codes_.resize(size_t(n) * size_t(d));
+    for (int i = 0; i < n; ++i) {
+        const float* r = vectors.row(i).data;
+        unsigned char* c = codes_.data() + size_t(i) * size_t(d);
+        for (int j = 0; j < d; ++j) {
+            const float x = (r[j] - mins_[size_t(j)]) * inv[size_t(j)];
+            c[j] = static_cast<unsigned char>(qBound(0.0f, std::nearbyint(x), 255.0f));
+        }
+    }
+    count_ = n;
+    dim_ = d;
+    fingerprint_ = vectors.fingerprint();
+}
+
+bool QuantizedIndex::save(const QString& path, QString* err) const {
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (err) *err = QObject::tr("Falha ao abrir índice quantizado '%1' para escrita: %2").arg(path, f.errorString());
+        return false;
+    }
+    const qint32 header[3] = { count_, dim_, qint32(kFlagFingerprint) };
+    const qint64 tableBytes = qint64(dim_) * qint64(sizeof(float));
+    bool ok = f.write("VSQ8", 4) == 4;
+    ok = ok && f.write(reinterpret_cast<const char*>(header), sizeof(header)) == qint64(sizeof(header));
+    ok = ok && f.write(reinterpret_cast<const char*>(&fingerprint_), sizeof(fingerprint_)) == qint64(sizeof(fingerprint_));
+    ok = ok && f.write(reinterpret_cast<const char*>(mins_.data()), tableBytes) == tableBytes;
+    ok = ok && f.write(reinterpret_cast<const char*>(scales_.data()), tableBytes) == tableBytes;
+    ok = ok && f.write(reinterpret_cast<const char*>(codes_.data()), qint64(codes_.size())) == qint64(codes_.size());
+    if (!ok || !f.commit()) {
+        if (err) *err = QObject::tr("Falha ao gravar índice quantizado '%1': %2").arg(path, f.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool QuantizedIndex::load(const QString& path, QString* err) {
+    clear();
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (err) *err = QObject::tr("Falha ao abrir índice quantizado '%1'").arg(path);
+        return false;
+    }
+    auto invalid = [this, err, &path]() {
+        clear();
+        if (err) *err = QObject::tr("Índice quantizado inválido: %1").arg(path);
+        return false;
+    };
+    char magic[4];
+    qint32 h[3];
+    quint64 fingerprint = 0;
+    if (f.read(magic, 4) != 4 || std::strncmp(magic, "VSQ8", 4) != 0) return invalid();
+    if (f.read(reinterpret_cast<char*>(h), sizeof(h)) != qint64(sizeof(h))) return invalid();
+    if (!(quint32(h[2]) & kFlagFingerprint)) return invalid();
+    if (f.read(reinterpret_cast<char*>(&fingerprint), sizeof(fingerprint)) != qint64(sizeof(fingerprint))) return invalid();
+    const int n = h[0], d = h[1];
+    if (n < 0 || d < 0 || (n > 0 && d == 0)) return invalid();
+    const qint64 tableBytes = qint64(d) * qint64(sizeof(float));
+    const qint64 codeBytes = qint64(n) * qint64(d);
+    if (f.size() != kHeaderSize + 2 * tableBytes + codeBytes) return invalid();
+    mins_.resize(size_t(d));
+    scales_.resize(size_t(d));
+    codes_.resize(size_t(codeBytes));
+    if (f.read(reinterpret_cast<char*>(mins_.data()), tableBytes) != tableBytes) return invalid();
+    if (f.read(reinterpret_cast<char*>(scales_.data()), tableBytes) != tableBytes) return invalid();
+    if (f.read(reinterpret_cast<char*>(codes_.data()), codeBytes) != codeBytes) return invalid();
+    count_ = n;
+    dim_ = d;
+    fingerprint_ = fingerprint;
+    return true;
+}
+
+bool QuantizedIndex::isCompatible(const VectorIndex& vectors) const {
+    // Same count and dim are not enough: a rebuilt container of the same size has other rows
+    return count_ > 0 && count_ == vectors.count() && dim_ == vectors.dim() && fingerprint_ == vectors.fingerprint();
+}
+
+QList<VectorIndex::Hit> QuantizedIndex::approximateTopK(const VectorIndex& vectors, const QVector<float>& query, int n,
+                                                        VectorIndex::Metric metric) const {
+    HitSelector sel(qMin(n, count_));
+    if (count_ == 0 || query.size() != dim_ || vectors.count() < count_) return sel.take();
+    const int d = dim_;
+    const float* q = query.constData();
+    // Fold the per-dimension affine map into the query once:
+    //   q.x  ~= q.min + sum((q*scale)[j] * code[j])
+    //   |q-x|^2 ~= sum(((q-min)[j] - scale[j]*code[j])^2)
+    std::vector<float> w(static_cast<size_t>(d));
+    float qDotMin = 0.0f;
+    if (metric == VectorIndex::Metric::L2) {
+        for (int j = 0; j < d; ++j) w[size_t(j)] = q[j] - mins_[size_t(j)];
+    } else {
+        for (int j = 0; j < d; ++j) w[size_t(j)] = q[j] * scales_[size_t(j)];
+        qDotMin = VectorKernels::dot(q, mins_.data(), d);
+    }
+    const float nq = std::sqrt(VectorKernels::squaredNorm(q, d));
+    for (int i = 0; i < count_; ++i) {
+        float score;
+        if (metric == VectorIndex::Metric::L2) {
+            score = -VectorKernels::squaredL2U8(w.data(), scales_.data(), codes(i), d); // monotonic in -distance
+        } else {
+            const float dp = qDotMin + VectorKernels::dotU8(w.data(), codes(i), d);
+            if (metric == VectorIndex::Metric::Cosine) {
+                const float nv = vectors.norm(i);
+                score = (nq > 0 && nv > 0) ? dp / (nq * nv) : 0.0f;
+            } else {
+                score = dp;
+            }
+        }
+        sel.offer(i, score);
+    }
+    return sel.take();
+}
+
+QList<VectorIndex::Hit> QuantizedIndex::search(const VectorIndex& vectors, const QVector<float>& query, int k,
+                                               VectorIndex::Metric metric, float minScore, int rerankFactor) const {
+    if (k <= 0 || count_ == 0 || query.size() != dim_) return {};
+    const int candidates = int(qMin<qint64>(count_, qint64(k) * qMax(1, rerankFactor)));
+    const QList<VectorIndex::Hit> approx = approximateTopK(vectors, query, candidates, metric);
+    const float* q = query.constData();
+    const float nq = std::sqrt(VectorKernels::squaredNorm(q, dim_));
+    HitSelector sel(k);
+    for (const auto& h : approx) {
+        const float score = exactScore(vectors, q, nq, h.index, metric);
+        if (score >= minScore) sel.offer(h.index, score);
+    }
+    return sel.take();
+}
+
+double QuantizedIndex::estimateRecall(const VectorIndex& vectors, VectorIndex::Metric metric, int k,
+                                      int sampleCount, int rerankFactor) const {
+    if (count_ == 0 || k <= 0 || sampleCount <= 0 || vectors.count() < count_) return 0.0;
+    const int samples = qMin(sampleCount, count_);
+    const int kk = qMin(k, count_);
+    qint64 found = 0, expected = 0;
+    for (int s = 0; s < samples; ++s) {
+        const int row = int(qint64(s) * count_ / samples);
+        const QVector<float> q = vectors.row(row).toVector();
+        QSet<int> exact;
+        for (const auto& h : vectors.topK(q, kk, metric)) exact.insert(h.index);
+        for (const auto& h : search(vectors, q, kk, metric, -std::numeric_limits<float>::infinity(), rerankFactor))
+            if (exact.contains(h.index)) ++found;
+        expected += exact.size();
+    }
+    return expected > 0 ? double(found) / double(expected) : 0.0;
+}
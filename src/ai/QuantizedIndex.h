@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <limits>
+#include <vector>
+
+#include "ai/VectorIndex.h"
+
+// Scalar (int8) quantization of the rows of a VectorIndex.
+//
+// Each dimension j is mapped linearly onto 0..255 using the per-dimension minimum and scale
+// observed at build time: x[j] ~= min[j] + scale[j] * code[j]. The codes take a quarter of
+// the float32 rows, so a query scans (and keeps resident) 4x less memory; the best candidates
+// are then rescored exactly against the full-precision rows of the (mapped) VectorIndex, which
+// are only paged in for those few rows.
+//
+// File format (".q8", little-endian): magic "VSQ8" + count(int32) + dim(int32) + flags(uint32)
+// + fingerprint(uint64, VectorIndex::fingerprint() of the encoded rows; flags kFlagFingerprint),
+// then dim float mins, dim float scales and count*dim uint8 codes.
+class QuantizedIndex {
+public:
+    QuantizedIndex() = default;
+
+    void clear();
+    // Trains min/scale on all rows of vectors and encodes them
+    void build(const VectorIndex& vectors);
+
+    bool save(const QString& path, QString* err = nullptr) const;
+    bool load(const QString& path, QString* err = nullptr);
+
+    // True when the codes encode exactly the rows of vectors (count, dim and fingerprint).
+    // Computes vectors.fingerprint(): check once per loaded index.
+    bool isCompatible(const VectorIndex& vectors) const;
+
+    // Approximate scores from the codes only (cosine uses the exact row norms of vectors).
+    // Returns at most n candidates, best first.
+    QList<VectorIndex::Hit> approximateTopK(const VectorIndex& vectors, const QVector<float>& query, int n,
+                                            VectorIndex::Metric metric) const;
+
+    // Two-phase query: approximateTopK() for k * rerankFactor candidates, then exact rescoring
+    // against the full-precision rows. Hits are ordered and thresholded like VectorIndex::topK().
+    QList<VectorIndex::Hit> search(const VectorIndex& vectors, const QVector<float>& query, int k,
+                                   VectorIndex::Metric metric,
+                                   float minScore = -std::numeric_limits<float>::infinity(),
+                                   int rerankFactor = 4) const;
+
+    // Recall@k of search() against the exact scan, using sampleCount rows of vectors (evenly
+    // spaced) as queries. rerankFactor 1 measures the codes alone.
+    double estimateRecall(const VectorIndex& vectors, VectorIndex::Metric metric, int k,
+                          int sampleCount, int rerankFactor) const;
+
+    int count() const { return count_; }
+    int dim() const { return dim_; }
+    bool isEmpty() const { return count_ == 0; }
+    // Bytes held by the codes and the per-dimension tables
+    qint64 byteSize() const { return qint64(codes_.size()) + qint64(mins_.size() + scales_.size()) * qint64(sizeof(float)); }
+
+private:
+    static constexpr qint64 kHeaderSize = 24; // magic + count + dim + flags + fingerprint
+    static constexpr quint32 kFlagFingerprint = 0x1; // files without it predate the fingerprint
+    const unsigned char* codes(int i) const { return codes_.data() + size_t(i) * size_t(dim_); }
+
+    int count_ {0};
+    int dim_ {0};
+    quint64 fingerprint_ {0};
+    std::vector<float> mins_;
+    std::vector<float> scales_;
+    std::vector<unsigned char> codes_; // count * dim, row-major
+};
@@ -0,0 +1,159 @@
+#include "ai/RagContextBuilder.h"
+
+#include "ai/TextChunker.h"
+
+#include <QObject>
+#include <QSet>
+#include <algorithm>
+
+namespace {
+bool isTerminator(QChar c) {
+    return c == QLatin1Char('.') || c == QLatin1Char('!') || c == QLatin1Char('?') || c == QChar(0x2026);
+}
+
+// A sentence starts at s: start of the text, after a line break, or after "<terminator> "
+bool startsSentence(const QString& t, int s) {
+    if (s <= 0) return true;
+    if (t.at(s - 1) == QLatin1Char('\n')) return true;
+    return s >= 2 && t.at(s - 1).isSpace() && isTerminator(t.at(s - 2));
+}
+
+// A sentence ends at e (exclusive): end of the text, before a line break, or after a terminator
+// followed by a space
+bool endsSentence(const QString& t, int e) {
+    if (e >= t.size()) return true;
+    if (t.at(e) == QLatin1Char('\n')) return true;
+    return e > 0 && isTerminator(t.at(e - 1)) && t.at(e).isSpace();
+}
+
+bool atWordBoundary(const QString& t, int i) {
+    return i <= 0 || i >= t.size() || t.at(i - 1).isSpace() || t.at(i).isSpace();
+}
+
+// Moves from forward, up to limit, to the first sentence start, else the first word start
+int snapStart(const QString& t, int from, int limit) {
+    for (int s = from; s <= limit; ++s)
+        if (startsSentence(t, s)) return s;
+    for (int s = from; s < limit; ++s)
+        if (atWordBoundary(t, s)) return s;
+    return limit;
+}
+
+// Moves to backward, down to limit, to the last sentence end, else the last word end
+int snapEnd(const QString& t, int to, int limit) {
+    for (int e = to; e >= limit; --e)
+        if (endsSentence(t, e)) return e;
+    for (int e = to; e > limit; --e)
+        if (atWordBoundary(t, e)) return e;
+    return limit;
+}
+
+QString header(int page) {
+    return QObject::tr("[Página %1]").arg(page);
+}
+}
+
+RagContextBuilder::RagContextBuilder(const Params& p) : p_(p) {
+    p_.maxTokens = qMax(kMinPartialTokens, p_.maxTokens);
+    p_.neighbourChars = qMax(0, p_.neighbourChars);
+    p_.pageWindowChars = qMax(200, p_.pageWindowChars);
+    p_.mergeGapChars = qMax(0, p_.mergeGapChars);
+}
+
+void RagContextBuilder::windowsOf(const QStringList& pages, const Passage& ps, int rank, QVector<Block>* out) const {
+    if (ps.page < 1 || ps.page > pages.size()) return;
+    auto add = [&](int page, int start, int end) {
+        if (end > start) out->append(Block{ page, start, end, rank, QString(), 0 });
+    };
+    const QString& first = pages.at(ps.page - 1);
+    const int firstLen = int(first.size());
+    if (ps.start < 0) {
+        // Page-level hit: a window around the match, else the top of the page
+        if (ps.matchStart >= 0 && ps.matchStart < firstLen) {
+            const int ms = ps.matchStart;
+            const int me = qBound(ms, ps.matchEnd, firstLen);
+            const int from = qBound(0, ms - (p_.pageWindowChars - (me - ms)) / 2, ms);
+            const int to = qBound(me, from + p_.pageWindowChars, firstLen);
+            add(ps.page, snapStart(first, from, ms), snapEnd(first, to, me));
+        } else {
+            const int to = qMin(firstLen, p_.pageWindowChars);
+            add(ps.page, 0, snapEnd(first, to, qMax(0, to - p_.neighbourChars)));
+        }
+        return;
+    }
+    const int lastPage = qBound(ps.page, ps.endPage, int(pages.size()));
+    for (int page = ps.page; page <= lastPage; ++page) {
+        const QString& t = pages.at(page - 1);
+        const int len = int(t.size());
+        int start = 0;
+        int end = len;
+        if (page == ps.page) {
+            const int s = qBound(0, ps.start, len);
+            start = snapStart(t, qMax(0, s - p_.neighbourChars), s);
+        }
+        if (page == lastPage && page == ps.endPage && ps.end >= 0) {
+            const int e = qBound(page == ps.page ? qBound(0, ps.start, len) : 0, ps.end, len);
+            end = snapEnd(t, qMin(len, e + p_.neighbourChars), e);
+        }
+        add(page, start, end);
+    }
+}
+
+RagContextBuilder::Context RagContextBuilder::build(const QStringList& pages, const QList<Passage>& passages) const {
+    Context ctx;
+    QVector<Block> windows;
+    for (int i = 0; i < passages.size(); ++i) windowsOf(pages, passages.at(i), i, &windows);
+
+    // Merge the windows of a page that overlap or nearly touch; the block ranks as its best one
+    std::sort(windows.begin(), windows.end(), [](const Block& a, const Block& b) {
+        return a.page != b.page ? a.page < b.page : a.start < b.start;
+    });
+    QVector<Block> blocks;
+    for (const Block& w : windows) {
+        if (!blocks.isEmpty() && blocks.last().page == w.page && w.start <= blocks.last().end + p_.mergeGapChars) {
+            Block& b = blocks.last();
+            b.end = qMax(b.end, w.end);
+            b.rank = qMin(b.rank, w.rank);
+        } else {
+            blocks.append(w);
+        }
+    }
+    std::stable_sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) {
+        return a.rank != b.rank ? a.rank < b.rank : (a.page != b.page ? a.page < b.page : a.start < b.start);
+    });
+
+    // Pack best first. Whitespace does not count in the token estimate, so the raw slice is
+    // measured and only the packed text is normalized.
+    QSet<int> cited;
+    QStringList parts;
+    for (Block b : blocks) {
+        const QString& t = pages.at(b.page - 1);
+        const int headerTokens = TextChunker::estimateTokens(header(b.page)) + 1;
+        const int left = p_.maxTokens - ctx.tokens - headerTokens;
+        if (left <= 0) break;
+        int tokens = TextChunker::estimateTokens(QStringView(t).mid(b.start, b.end - b.start));
+        if (tokens > left) {
+            if (left < kMinPartialTokens) continue;
+            // Longest head that fits, cut back to a sentence or word end
+            int lo = b.start, hi = b.end;
+            while (lo < hi) {
+                const int mid = lo + (hi - lo + 1) / 2;
+                if (TextChunker::estimateTokens(QStringView(t).mid(b.start, mid - b.start)) <= left) lo = mid; else hi = mid - 1;
+            }
+            int end = snapEnd(t, lo, b.start + (lo - b.start) / 2);
+            if (end <= b.start) end = lo;
+            if (end <= b.start) continue;
+            b.end = end;
+            tokens = TextChunker::estimateTokens(QStringView(t).mid(b.start, b.end - b.start));
+        }
+        b.text = t.mid(b.start, b.end - b.start).simplified();
+        if (b.text.isEmpty()) continue;
+        b.tokens = tokens + headerTokens;
+        ctx.tokens += b.tokens;
+        parts << header(b.page) + QLatin1Char('\n') + b.text;
+        if (!cited.contains(b.page)) { cited.insert(b.page); ctx.pages << b.page; }
+        ctx.blocks << b;
+    }
+    ctx.text = parts.join(QStringLiteral("\n\n"));
+    return ctx;
+}
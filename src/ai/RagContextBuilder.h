@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Assembles the book context of a RAG answer from the retrieved passages rather than whole pages.
+//
+// Each passage (a chunk span, or for a page-level hit a window around its match, else the top of
+// the page) is widened by a neighbour margin on both sides, and the margins are trimmed back to
+// sentence ends, then word boundaries, so no window starts or stops mid-word. Windows are split
+// per page (citations are per page), and windows of a page that overlap or nearly touch are
+// merged into one block ranked as its best passage. Blocks are then packed best first into the
+// token budget (TextChunker::estimateTokens): a block that does not fit is skipped for smaller
+// ones, except that a leftover of at least kMinPartialTokens is filled with the head of the block,
+// cut at a sentence or word boundary. Only the packed text is whitespace-normalized.
+class RagContextBuilder {
+public:
+    struct Passage {
+        int page {0};        // 1-based, where the passage starts
+        int start {-1};      // into the text of page; -1: page-level hit
+        int endPage {0};
+        int end {-1};        // exclusive, into the text of endPage
+        int matchStart {-1}; // page-level hit: match to center the window on (in page)
+        int matchEnd {-1};
+    };
+    struct Params {
+        int maxTokens {1000};       // whole context, headers included
+        int neighbourChars {300};   // margin added on each side of a passage
+        int pageWindowChars {1200}; // window of a page-level hit
+        int mergeGapChars {80};     // windows closer than this on a page are merged
+    };
+    struct Block {
+        int page {0};
+        int start {0};
+        int end {0}; // exclusive
+        int rank {0}; // of the best passage in the block (0 = best)
+        QString text;
+        int tokens {0};
+    };
+    struct Context {
+        QString text;
+        QList<Block> blocks; // as packed, best first
+        QList<int> pages;    // cited, in packing order
+        int tokens {0};
+    };
+
+    static constexpr int kMinPartialTokens = 64;
+
+    explicit RagContextBuilder(const Params& p);
+
+    // pages: text of each page (page 1 first); passages: best first
+    Context build(const QStringList& pages, const QList<Passage>& passages) const;
+
+private:
+    // Windows of passage, one per page it covers
+    void windowsOf(const QStringList& pages, const Passage& ps, int rank, QVector<Block>* out) const;
+
+    Params p_;
+};
@@ -0,0 +1,94 @@
+#include "ai/Reranker.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+#include <QUrl>
+
+bool Reranker::isEnabled() const {
+    return (cfg_.provider == QLatin1String("rerank") || cfg_.provider == QLatin1String("tei")) && !cfg_.baseUrl.trimmed().isEmpty();
+}
+
+bool Reranker::score(const QString& query, const QStringList& passages, QVector<double>* scores, QString* err) const {
+    if (!isEnabled()) {
+        if (err) *err = QStringLiteral("reranker disabled");
+        return false;
+    }
+    const bool tei = cfg_.provider == QLatin1String("tei");
+    QString base = cfg_.baseUrl.trimmed();
+    while (base.endsWith('/')) base.chop(1);
+    const QUrl url(base.endsWith(QLatin1String("/rerank")) ? base : base + QStringLiteral("/rerank"));
+
+    QNetworkRequest req(url);
+    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
+    req.setRawHeader("Accept", "application/json");
+    if (!cfg_.apiKey.isEmpty()) req.setRawHeader("Authorization", QByteArray("Bearer ") + cfg_.apiKey.toUtf8());
+    QJsonObject payload;
+    payload.insert("query", query);
+    if (tei) {
+        payload.insert("texts", QJsonArray::fromStringList(passages));
+        payload.insert("truncate", true);
+    } else {
+        if (!cfg_.model.isEmpty()) payload.insert("model", cfg_.model);
+        payload.insert("documents", QJsonArray::fromStringList(passages));
+        payload.insert("top_n", int(passages.size()));
+    }
+
+    QNetworkAccessManager nam;
+    QEventLoop loop;
+    QTimer budget;
+    budget.setSingleShot(true);
+    QElapsedTimer timer;
+    timer.start();
+    QNetworkReply* rep = nam.post(req, QJsonDocument(payload).toJson(QJsonDocument::Compact));
+    bool timedOut = false;
+    QObject::connect(rep, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    QObject::connect(&budget, &QTimer::timeout, &loop, [&]() { timedOut = true; rep->abort(); });
+    budget.start(qMax(1, cfg_.budgetMs));
+    if (!rep->isFinished()) loop.exec();
+    budget.stop();
+
+    const int status = rep->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QByteArray resp = rep->readAll();
+    const QString errStr = rep->errorString();
+    const auto netErr = rep->error();
+    rep->deleteLater();
+    if (timedOut) {
+        if (err) *err = QStringLiteral("latency budget of %1 ms exceeded").arg(cfg_.budgetMs);
+        return false;
+    }
+    if (netErr != QNetworkReply::NoError || status >= 400) {
+        const QString full = QStringLiteral("HTTP error: status=%1 qt_error=%2 (%3) url=%4 body=%5")
+                                 .arg(status).arg(int(netErr)).arg(errStr, url.toString(), QString::fromUtf8(resp.left(800)));
+        qWarning() << "[Reranker]" << full;
+        if (err) *err = full;
+        return false;
+    }
+
+    // Cohere-style {"results":[{"index","relevance_score"}]}, TEI [{"index","score"}]; any order
+    const QJsonDocument doc = QJsonDocument::fromJson(resp);
+    const QJsonArray results = doc.isArray() ? doc.array() : doc.object().value("results").toArray();
+    QVector<double> out(passages.size(), 0.0);
+    QVector<bool> seen(passages.size(), false);
+    for (const auto& v : results) {
+        const QJsonObject o = v.toObject();
+        const int i = o.value("index").toInt(-1);
+        if (i < 0 || i >= out.size()) continue;
+        out[i] = o.contains("relevance_score") ? o.value("relevance_score").toDouble() : o.value("score").toDouble();
+        seen[i] = true;
+    }
+    if (seen.contains(false)) {
+        if (err) *err = QStringLiteral("reranker response misses passages (%1 of %2 scored)").arg(seen.count(true)).arg(passages.size());
+        return false;
+    }
+    qInfo() << "[Reranker] ok" << "passages=" << passages.size() << "ms=" << timer.elapsed();
+    *scores = out;
+    return true;
+}
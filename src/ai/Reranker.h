@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Second retrieval stage: a reranker model (cross-encoder) scores the query together with each
+// candidate passage, which orders passages much better than the embedding similarity, at the
+// cost of one request per query. Speaks the /rerank endpoint served by Cohere, Jina, vLLM,
+// Infinity and llama.cpp (--reranking), or Hugging Face Text Embeddings Inference, remote or on
+// localhost.
+//
+// The call is bounded by a latency budget: past it the request is aborted and the caller keeps
+// its first-stage order, so a slow reranker never holds up an answer for long.
+class Reranker {
+public:
+    struct Config {
+        QString provider;   // "none", "rerank" (Cohere-style "documents"), "tei" ("texts")
+        QString model;
+        QString baseUrl;    // up to the API version (e.g. https://api.jina.ai/v1); /rerank is appended
+        QString apiKey;
+        int budgetMs {1500}; // whole request, connection included
+    };
+
+    explicit Reranker(const Config& cfg) : cfg_(cfg) {}
+
+    bool isEnabled() const;
+    // Relevance of each passage to query, in passages order (higher is more relevant). False on
+    // failure or when the budget runs out, with the reason in err.
+    // Runs a local event loop: call it from a thread with no other use for its events meanwhile.
+    bool score(const QString& query, const QStringList& passages, QVector<double>* scores, QString* err = nullptr) const;
+
+private:
+    Config cfg_;
+};
@@ -0,0 +1,563 @@
+#include "ai/SearchService.h"
+
+#include "ai/EmbeddingCache.h"
+#include "ai/EmbeddingProvider.h"
+#include "ai/HnswIndex.h"
+#include "ai/PageTextCache.h"
+#include "ai/QuantizedIndex.h"
+#include "ai/Reranker.h"
+#include "ai/VectorIndex.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSet>
+#include <QSettings>
+#include <algorithm>
+#include <numeric>
+
+// Search state of one document, kept across semantic searches. The key (container path, which
+// already encodes document + model, plus mtime/size of the container and of the document) is
+// checked with two stat() calls; a match means the query touches no file data.
+struct SearchService::ResidentIndex {
+    QString containerPath;
+    QString model;
+    QString documentPath;
+    QDateTime containerMtime;
+    qint64 containerSize {-1};
+    QDateTime documentMtime;
+    qint64 documentSize {-1};
+    VectorIndex index;
+    // Approximate structures over index, loaded lazily for emb/index_type
+    HnswIndex graph;
+    bool graphTried {false}; // load attempted: a missing or stale graph is not retried per query
+    bool graphReady {false};
+    QuantizedIndex q8;
+    bool q8Tried {false};
+    bool q8Ready {false};
+    // Rows by chunk start (page, offset), built on the first lexical match to map
+    QVector<int> byStart;
+
+    bool matches(const QString& path, const QString& m, const QString& doc) const {
+        if (path != containerPath || m != model || doc != documentPath) return false;
+        const QFileInfo ci(containerPath), di(documentPath);
+        return ci.exists() && ci.lastModified() == containerMtime && ci.size() == containerSize
+            && di.lastModified() == documentMtime && di.size() == documentSize;
+    }
+
+    // Rows whose chunk span covers the character at offset of page (index with spans only).
+    // Chunks are cut in text order, so their ends grow with their starts and the chunks
+    // covering a point are the ones right before the first chunk starting past it.
+    QVector<int> rowsAt(int page, int offset) {
+        auto before = [](int p1, int o1, int p2, int o2) { return p1 != p2 ? p1 < p2 : o1 < o2; };
+        if (byStart.isEmpty()) {
+            byStart.resize(index.count());
+            std::iota(byStart.begin(), byStart.end(), 0);
+            std::sort(byStart.begin(), byStart.end(), [&](int a, int b) {
+                return before(index.page(a), index.startOffset(a), index.page(b), index.startOffset(b));
+            });
+        }
+        const auto after = std::upper_bound(byStart.cbegin(), byStart.cend(), 0, [&](int, int row) {
+            return before(page, offset, index.page(row), index.startOffset(row));
+        });
+        QVector<int> rows;
+        for (auto it = after; it != byStart.cbegin();) {
+            const int row = *--it;
+            if (index.startOffset(row) < 0) continue; // no span recorded for the row
+            if (!before(page, offset, index.endPage(row), index.endOffset(row))) break;
+            rows << row;
+        }
+        return rows;
+    }
+};
+
+namespace {
+// Pages extracted between two log lines
+constexpr int kExtractProgressEvery = 50;
+// Hybrid search: each side ranks max(kMinCandidates, k * kCandidateFactor) candidates
+constexpr int kMinCandidates = 20;
+constexpr int kCandidateFactor = 4;
+// Reranker passages are cut here: cross-encoders read a few hundred tokens per pair anyway
+constexpr int kMaxPassageChars = 2000;
+
+Reranker::Config rerankerConfig(const QSettings& s) {
+    Reranker::Config cfg;
+    cfg.provider = s.value("emb/rerank_provider", "none").toString();
+    cfg.model = s.value("emb/rerank_model").toString();
+    cfg.baseUrl = s.value("emb/rerank_base_url").toString();
+    cfg.apiKey = s.value("emb/rerank_api_key").toString();
+    cfg.budgetMs = qMax(1, s.value("emb/rerank_budget_ms", 1500).toInt());
+    return cfg;
+}
+
+// Distinct pages of the best hits, up to k: where the match is, else where the chunk starts
+QList<int> pagesOf(const QList<SearchService::ChunkHit>& hits, int k) {
+    QList<int> pages;
+    QSet<int> seen;
+    for (const SearchService::ChunkHit& h : hits) {
+        if (pages.size() >= k) break;
+        const int page = h.matchPage > 0 ? h.matchPage : h.page;
+        if (!seen.contains(page)) { pages << page; seen.insert(page); }
+    }
+    return pages;
+}
+}
+
+SearchService::SearchService(QObject* parent) : QObject(parent) {
+    thread_.setObjectName(QStringLiteral("SearchService"));
+    worker_ = new QObject;
+    worker_->moveToThread(&thread_);
+    connect(&thread_, &QThread::finished, worker_, &QObject::deleteLater);
+    thread_.start();
+}
+
+SearchService::~SearchService() {
+    cancelAll();
+    thread_.quit();
+    thread_.wait();
+}
+
+qint64 SearchService::submit(const Request& r, QObject* receiver, Callback done) {
+    const qint64 id = ++nextId_;
+    {
+        QMutexLocker lock(&queueMutex_);
+        // A queued request of the same lane is superseded; a running one sees latest_ change
+        for (int i = queue_.size() - 1; i >= 0; --i)
+            if (queue_.at(i).request.lane == r.lane) queue_.removeAt(i);
+        latest_[int(r.lane)] = id;
+        queue_.append(Job{ id, r, QPointer<QObject>(receiver), std::move(done) });
+    }
+    QMetaObject::invokeMethod(worker_, [this]() { drain(); }, Qt::QueuedConnection);
+    return id;
+}
+
+void SearchService::cancel(Lane lane) {
+    QMutexLocker lock(&queueMutex_);
+    for (int i = queue_.size() - 1; i >= 0; --i)
+        if (queue_.at(i).request.lane == lane) queue_.removeAt(i);
+    latest_[int(lane)] = ++nextId_;
+}
+
+void SearchService::cancelAll() {
+    for (int l = 0; l < kLanes; ++l) cancel(Lane(l));
+}
+
+void SearchService::preloadPagesText(const QString& pdfPath, const QString& dbDir) {
+    Request r;
+    r.lane = Lane::PageText;
+    r.pdfPath = pdfPath;
+    r.dbDir = dbDir;
+    submit(r, nullptr, Callback());
+}
+
+void SearchService::invalidateIndex() {
+    // Also drops the mapping, so the indexer/migration can replace or move the files
+    {
+        QMutexLocker lock(&indexMutex_);
+        index_.reset();
+    }
+    // The indexer may also have rewritten the page text and full-text index (OCR): reread them
+    // on the next request
+    QMetaObject::invokeMethod(worker_, [this]() {
+        textPath_.clear();
+        fullText_ = FullTextIndex();
+    }, Qt::QueuedConnection);
+}
+
+void SearchService::drain() {
+    // The embedding call of a semantic search runs a nested event loop on this thread, which may
+    // deliver the next drain(): the outer loop picks the queued jobs up instead
+    if (draining_) return;
+    draining_ = true;
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker lock(&queueMutex_);
+            if (queue_.isEmpty()) break;
+            job = queue_.takeFirst();
+        }
+        if (isCurrent(job.request.lane, job.id)) execute(job);
+    }
+    draining_ = false;
+}
+
+void SearchService::execute(const Job& job) {
+    const Request& r = job.request;
+    Result res;
+    res.id = job.id;
+    if (r.lane == Lane::PageText) {
+        // Background loading gives way to searches (which resume the extraction themselves)
+        // and is queued again behind them
+        bool yielded = false;
+        visitPagesText(r.pdfPath, r.dbDir, [this, &job, &yielded](int, const QString&) {
+            QMutexLocker lock(&queueMutex_);
+            yielded = !queue_.isEmpty();
+            return isCurrent(Lane::PageText, job.id) && !yielded;
+        });
+        if (yielded && isCurrent(Lane::PageText, job.id)) {
+            QMutexLocker lock(&queueMutex_);
+            queue_.append(job);
+            return;
+        }
+        res.pageTexts = texts_;
+    } else if (!r.query.trimmed().isEmpty()) {
+        if (r.mode == Mode::Hybrid) {
+            hybridSearch(job.id, r, &res);
+            if (r.rerank && isCurrent(r.lane, job.id)) rerank(job.id, r, &res);
+        } else {
+            res.textHits = plainTextSearch(job.id, r, r.k);
+            for (const FullTextIndex::Hit& h : res.textHits) res.pages << h.page;
+        }
+    }
+    if (!isCurrent(r.lane, job.id) || !job.receiver || !job.done) return;
+    const Lane lane = r.lane;
+    const Callback done = job.done;
+    QMetaObject::invokeMethod(job.receiver, [this, lane, done, res]() {
+        if (isCurrent(lane, res.id)) done(res); // not superseded while queued
+    }, Qt::QueuedConnection);
+}
+
+QList<FullTextIndex::Hit> SearchService::plainTextSearch(qint64 id, const Request& r, int maxPages) {
+    openText(r.pdfPath, r.dbDir);
+    if (!fullText_.isEmpty()) return fullText_.search(r.query, maxPages);
+    // No index yet: match the pages as they are extracted, with the terms and rules of the index
+    // (every word, quoted phrases), so a page found now is also found once it is built. Until
+    // then the first matching pages come in page order; a scan that reaches the last page has
+    // built the index and returns its ranking.
+    QList<FullTextIndex::Hit> hits;
+    QList<int> pages;
+    const bool complete = visitPagesText(r.pdfPath, r.dbDir, [&](int page, const QString& text) {
+        if (!isCurrent(r.lane, id)) return false;
+        FullTextIndex::Hit h;
+        if (FullTextIndex::matchPage(r.query, page, text, &h)) {
+            hits.append(h);
+            pages.append(page);
+            emit partialResults(id, pages);
+        }
+        return hits.size() < maxPages;
+    });
+    if (complete && !fullText_.isEmpty() && isCurrent(r.lane, id)) return fullText_.search(r.query, maxPages);
+    return hits;
+}
+
+void SearchService::openText(const QString& pdfPath, const QString& dbDir) {
+    if (pdfPath == textPath_) return;
+    textPath_ = pdfPath;
+    texts_.clear();
+    textSources_.clear();
+    textComplete_ = false;
+    QString err;
+    if (!fullText_.load(FullTextIndex::pathFor(dbDir, pdfPath), pdfPath, &err) && !err.isEmpty()) qWarning() << "[Search]" << err;
+    PageTextCache cache;
+    if (cache.load(PageTextCache::pathFor(dbDir, pdfPath), pdfPath)) {
+        texts_ = cache.texts();
+        for (int pg = 1; pg <= cache.pageCount(); ++pg) textSources_ << cache.source(pg);
+        completeText(pdfPath, dbDir);
+    }
+}
+
+void SearchService::completeText(const QString& pdfPath, const QString& dbDir) {
+    textComplete_ = true;
+    if (fullText_.isEmpty()) {
+        QElapsedTimer timer;
+        timer.start();
+        fullText_.build(texts_);
+        QString err;
+        if (!fullText_.save(FullTextIndex::pathFor(dbDir, pdfPath), pdfPath, &err)) qWarning() << "[Search]" << err;
+        qInfo() << "[Search] índice de texto:" << fullText_.termCount() << "termos em" << timer.elapsed() << "ms";
+    }
+    emit pagesTextReady(pdfPath, texts_);
+}
+
+bool SearchService::visitPagesText(const QString& pdfPath, const QString& dbDir,
+                                   const std::function<bool(int, const QString&)>& visit) {
+    openText(pdfPath, dbDir);
+    for (int i = 0; i < texts_.size(); ++i)
+        if (!visit(i + 1, texts_.at(i))) return textComplete_;
+    if (textComplete_) return true;
+    // Extract the pages still missing with a document of our own (the viewer's belongs to the
+    // GUI thread), resuming after the last page an earlier request got to
+    PageTextExtractor ex;
+    if (!ex.open(pdfPath)) return false;
+    const int pageCount = ex.pageCount();
+    ex.forEachPage(texts_.size() + 1, pageCount, [&](int page, const QString& text, PageTextExtractor::Source src) {
+        texts_ << text;
+        textSources_ << src;
+        if (page % kExtractProgressEvery == 0) qInfo() << "[Search] texto extraído:" << page << "/" << pageCount;
+        return visit(page, text);
+    });
+    if (texts_.size() < pageCount) return false;
+    // Same cache the indexer writes; built without OCR, so the indexer still OCRs blank pages
+    PageTextCache cache;
+    cache.reset(pageCount, false);
+    for (int i = 0; i < pageCount; ++i) cache.setPage(i + 1, texts_.at(i), textSources_.at(i));
+    QString err;
+    if (!cache.save(PageTextCache::pathFor(dbDir, pdfPath), pdfPath, &err)) qWarning() << "[Search]" << err;
+    completeText(pdfPath, dbDir);
+    return true;
+}
+
+void SearchService::hybridSearch(qint64 id, const Request& r, Result* res) {
+    QSettings s;
+    int depth = qMax(kMinCandidates, r.k * kCandidateFactor);
+    // Over-fetch for the reranker, which picks the best of a wider pool
+    if (r.rerank && Reranker(rerankerConfig(s)).isEnabled()) depth = qMax(depth, s.value("emb/rerank_candidates", 50).toInt());
+    const double rrfK = qMax(1.0, s.value("emb/hybrid_rrf_k", 60).toDouble());
+    const double lexicalWeight = qMax(0.0, s.value("emb/hybrid_lexical_weight", 1.0).toDouble());
+    const double vectorWeight = qMax(0.0, s.value("emb/hybrid_vector_weight", 1.0).toDouble());
+    // Lexical side first: it takes microseconds, and its pages are shown while the query embeds
+    if (lexicalWeight > 0) res->textHits = plainTextSearch(id, r, depth);
+    if (!res->textHits.isEmpty()) {
+        QList<int> pages;
+        for (int i = 0; i < qMin(r.k, int(res->textHits.size())); ++i) pages << res->textHits.at(i).page;
+        emit partialResults(id, pages);
+    }
+    QVector<float> query;
+    if (vectorWeight > 0 && !r.index.containerPath.isEmpty() && isCurrent(r.lane, id)) {
+        emit progress(id, tr("[RAG] Gerando embedding da consulta..."));
+        query = embedQuery(r, &res->error);
+    }
+    // A newer request (or another document) made this one moot while the provider answered
+    if (!isCurrent(r.lane, id)) return;
+
+    QMutexLocker lock(&indexMutex_);
+    ResidentIndex* idx = r.index.containerPath.isEmpty() ? nullptr : residentIndex(id, r, &res->error);
+    if (idx && !query.isEmpty() && query.size() != idx->index.dim()) {
+        // The provider now serves another model under the configured name
+        res->error = tr("A consulta tem dimensão %1, mas o índice tem dimensão %2. Recrie os embeddings com o modelo atual.")
+                         .arg(query.size()).arg(idx->index.dim());
+        qWarning() << "[Search]" << res->error;
+        query.clear();
+    }
+    const bool byChunk = idx && idx->index.hasSpans();
+    // Fused entries, keyed by row (>= 0) or by -page for page-level entries
+    QHash<qint64, int> slotOf;
+    QList<ChunkHit>& fused = res->chunks;
+    auto entry = [&](int row, int page) -> ChunkHit& {
+        const qint64 key = row >= 0 ? qint64(row) : -qint64(page);
+        const auto it = slotOf.constFind(key);
+        if (it != slotOf.constEnd()) return fused[*it];
+        ChunkHit h;
+        h.page = h.endPage = page;
+        if (row >= 0) {
+            h.chunk = row;
+            h.startOffset = idx->index.startOffset(row);
+            h.endPage = idx->index.endPage(row);
+            h.endOffset = idx->index.endOffset(row);
+        }
+        slotOf.insert(key, int(fused.size()));
+        fused.append(h);
+        return fused.last();
+    };
+    if (idx && !query.isEmpty()) {
+        int rank = 0;
+        for (const VectorIndex::Hit& vh : scanIndex(idx, r, query, depth)) {
+            if (vh.index < 0 || vh.index >= idx->index.count()) continue;
+            const int page = idx->index.page(vh.index);
+            if (page <= 0) continue;
+            ChunkHit& h = entry(byChunk ? vh.index : -1, page);
+            if (h.vectorRank) continue; // page-level: the page ranks by its best chunk
+            h.vectorRank = ++rank;
+            h.vectorScore = vh.score;
+        }
+    }
+    int lexicalRank = 0;
+    for (const FullTextIndex::Hit& lh : res->textHits) {
+        // Chunks of the page holding matches, most matches first; the page itself when no
+        // recorded chunk covers them
+        QVector<int> rows;
+        QHash<int, int> matches;
+        QHash<int, FullTextIndex::Span> firstMatch;
+        if (byChunk) {
+            for (const FullTextIndex::Span& sp : lh.spans) {
+                for (int row : idx->rowsAt(lh.page, sp.start)) {
+                    if (!matches.contains(row)) { rows << row; firstMatch.insert(row, sp); }
+                    ++matches[row];
+                }
+            }
+            std::stable_sort(rows.begin(), rows.end(), [&](int a, int b) { return matches.value(a) > matches.value(b); });
+        }
+        if (rows.isEmpty()) rows << -1;
+        for (int row : rows) {
+            ChunkHit& h = entry(row, row >= 0 ? idx->index.page(row) : lh.page);
+            if (h.lexicalRank) continue;
+            h.lexicalRank = ++lexicalRank;
+            const FullTextIndex::Span sp = row >= 0 ? firstMatch.value(row) : lh.spans.value(0);
+            h.matchPage = lh.page;
+            h.matchStart = sp.start;
+            h.matchEnd = sp.end;
+        }
+    }
+    for (ChunkHit& h : fused) {
+        if (h.lexicalRank) h.score += lexicalWeight / (rrfK + h.lexicalRank);
+        if (h.vectorRank) h.score += vectorWeight / (rrfK + h.vectorRank);
+        res->semantic = res->semantic || h.vectorRank > 0;
+    }
+    std::stable_sort(fused.begin(), fused.end(), [](const ChunkHit& a, const ChunkHit& b) { return a.score > b.score; });
+    res->pages = pagesOf(fused, r.k);
+}
+
+void SearchService::rerank(qint64 id, const Request& r, Result* res) {
+    QSettings s;
+    const Reranker reranker(rerankerConfig(s));
+    if (!reranker.isEnabled() || res->chunks.size() < 2) return;
+    const int n = qMin(int(res->chunks.size()), qMax(2, s.value("emb/rerank_candidates", 50).toInt()));
+    QStringList passages;
+    for (int i = 0; i < n; ++i) passages << passageText(r, res->chunks.at(i));
+    if (!isCurrent(r.lane, id)) return;
+    emit progress(id, tr("[RAG] Reordenando %1 trechos (reranker)...").arg(n));
+    QVector<double> scores;
+    QString err;
+    if (!reranker.score(r.query, passages, &scores, &err)) {
+        qWarning() << "[Search] reranker:" << err;
+        emit progress(id, tr("[aviso] Reordenação ignorada, mantida a ordem da busca híbrida: %1").arg(err));
+        return;
+    }
+    // The candidates past n keep their fused order behind the reranked ones
+    for (int i = 0; i < n; ++i) res->chunks[i].rerankScore = scores.at(i);
+    std::stable_sort(res->chunks.begin(), res->chunks.begin() + n,
+                     [](const ChunkHit& a, const ChunkHit& b) { return a.rerankScore > b.rerankScore; });
+    res->reranked = true;
+    res->pages = pagesOf(res->chunks, r.k);
+}
+
+QString SearchService::passageText(const Request& r, const ChunkHit& h) {
+    const int last = qMax(h.page, h.endPage);
+    if (texts_.size() < last || textPath_ != r.pdfPath)
+        visitPagesText(r.pdfPath, r.dbDir, [last](int page, const QString&) { return page < last; });
+    if (h.page < 1 || h.page > texts_.size()) return QString();
+    QString text;
+    if (h.startOffset < 0) {
+        text = texts_.at(h.page - 1);
+    } else {
+        // Span from (page, startOffset) to (endPage, endOffset)
+        for (int p = h.page; p <= last && p <= texts_.size() && text.size() < kMaxPassageChars; ++p) {
+            const QString& pt = texts_.at(p - 1);
+            const int from = p == h.page ? qBound(0, h.startOffset, int(pt.size())) : 0;
+            const int to = p == h.endPage && h.endOffset >= 0 ? qBound(from, h.endOffset, int(pt.size())) : int(pt.size());
+            if (!text.isEmpty()) text += QLatin1Char(' ');
+            text += QStringView(pt).mid(from, to - from);
+        }
+    }
+    return text.simplified().left(kMaxPassageChars);
+}
+
+QVector<float> SearchService::embedQuery(const Request& r, QString* err) {
+    QSettings s;
+    EmbeddingProvider::Config cfg;
+    cfg.provider = s.value("emb/provider", "generativa").toString();
+    cfg.model = s.value("emb/model", "nomic-embed-text:latest").toString();
+    cfg.baseUrl = s.value("emb/base_url").toString();
+    cfg.apiKey = s.value("emb/api_key").toString();
+    // Minimal normalization (match indexer behavior): collapse whitespace and trim
+    QString qnorm = r.query;
+    qnorm.replace(QRegularExpression("\\s+"), " ");
+    qnorm = qnorm.trimmed();
+    // Repeated queries (and query text that matches an indexed chunk) skip the provider
+    const std::shared_ptr<EmbeddingCache> embCache = EmbeddingCache::open(QDir(r.dbDir).filePath(QStringLiteral("embedding_cache")),
+                                                                          s.value("emb/cache_max_mb", 512).toLongLong() << 20);
+    const QByteArray queryKey = EmbeddingCache::key(cfg.provider, cfg.model, qnorm);
+    QVector<float> cached;
+    if (embCache && embCache->lookup(queryKey, &cached)) return cached;
+    QList<QVector<float>> qv;
+    EmbeddingProvider prov(cfg);
+    try { qv = prov.embedBatch(QStringList{qnorm}); }
+    catch (const std::exception& ex) {
+        qWarning() << "[Search] embed query failed:" << ex.what();
+        if (err) *err = QString::fromUtf8(ex.what());
+        return QVector<float>();
+    }
+    if (qv.isEmpty()) return QVector<float>();
+    if (embCache) { embCache->insert(queryKey, qv.first()); embCache->flush(); }
+    return qv.first();
+}
+
+SearchService::ResidentIndex* SearchService::residentIndex(qint64 id, const Request& r, QString* err) {
+    const IndexFiles& paths = r.index;
+    const QString model = QSettings().value("emb/model", "nomic-embed-text:latest").toString();
+    if (index_ && index_->matches(paths.containerPath, model, r.pdfPath)) return index_.get();
+    index_.reset();
+    // One-time conversion of the legacy .bin/.ids.json/.meta.json trio into a single container
+    if (!QFileInfo::exists(paths.containerPath)) {
+        if (!VectorIndex::convertLegacy(paths.binPath, paths.idsPath, paths.metaPath, paths.containerPath, err)) {
+            qWarning() << "[Search] Falha ao converter índice para contêiner:" << (err ? *err : QString());
+            return nullptr;
+        }
+        qInfo() << "[Search] Índice convertido para contêiner único:" << paths.containerPath;
+        QFile::remove(paths.binPath); QFile::remove(paths.idsPath); QFile::remove(paths.metaPath);
+    }
+    // Load index (memory-mapped, zero-copy; falls back to in-memory load)
+    auto cache = std::make_unique<ResidentIndex>();
+    if (!cache->index.loadContainer(paths.containerPath, err)) {
+        qWarning() << "[Search] Falha ao carregar índice:" << (err ? *err : QString());
+        return nullptr;
+    }
+    const QFileInfo ci(paths.containerPath), di(r.pdfPath);
+    cache->containerPath = paths.containerPath;
+    cache->model = model;
+    cache->documentPath = r.pdfPath;
+    cache->containerMtime = ci.lastModified();
+    cache->containerSize = ci.size();
+    cache->documentMtime = di.lastModified();
+    cache->documentSize = di.size();
+    qInfo() << "[Search] Índice carregado em memória:" << paths.containerPath << cache->index.count() << "vetores";
+    emit progress(id, tr("[RAG] Índice carregado: %1 vetores").arg(cache->index.count()));
+    index_ = std::move(cache);
+    return index_.get();
+}
+
+QList<VectorIndex::Hit> SearchService::scanIndex(ResidentIndex* idx, const Request& r, const QVector<float>& query, int depth) {
+    QSettings s;
+    const VectorIndex& index = idx->index;
+    const VectorIndex::Metric metric = VectorIndex::metricFromString(s.value("emb/similarity_metric", "cosine").toString());
+    // Thresholds are applied inside the scan: rows below the cutoff never enter the top-K heap
+    const double simThreshold = s.value("emb/sim_threshold", 0.35).toDouble();
+    const double l2Max = s.value("emb/l2_max_distance", 1.5).toDouble();
+    // L2 score = -distance, so distance <= l2Max <=> score >= -l2Max
+    const float minScore = (metric == VectorIndex::Metric::L2) ? float(-l2Max) : float(simThreshold);
+    QString annErr;
+    const QString indexType = s.value("emb/index_type", "flat").toString();
+    if (indexType == QLatin1String("hnsw")) {
+        // Approximate search over the graph written by the indexer. It is only loaded here, never
+        // built: this runs under indexMutex_, which invalidateIndex() takes on the GUI thread.
+        // A graph that is missing or was built from other rows, metric or M is left to the next
+        // indexing run and the query uses the exact scan.
+        const int M = s.value("emb/hnsw_m", HnswIndex::Params().M).toInt();
+        HnswIndex& graph = idx->graph;
+        if (!idx->graphTried) {
+            idx->graphTried = true;
+            if (!QFileInfo::exists(r.index.hnswPath)) {
+                annErr = QObject::tr("arquivo ausente; recrie os embeddings");
+            } else if (graph.load(r.index.hnswPath, &annErr)) {
+                idx->graphReady = graph.isCompatible(index, graph.metric(), graph.params().M);
+                if (!idx->graphReady) annErr = QObject::tr("desatualizado em relação ao índice; recrie os embeddings");
+            }
+            if (!idx->graphReady) qWarning() << "[Search] Índice HNSW indisponível, usando busca exata:" << annErr;
+        }
+        if (idx->graphReady && graph.metric() == metric && graph.params().M == M) {
+            graph.setEfSearch(s.value("emb/hnsw_ef_search", graph.params().efSearch).toInt());
+            return graph.search(index, query, depth, minScore);
+        }
+    } else if (indexType == QLatin1String("sq8")) {
+        // Scan the int8 codes written by the indexer, then rescore the best candidates against
+        // the float rows. As for the graph, the codes are only loaded here, never built.
+        if (!idx->q8Tried) {
+            idx->q8Tried = true;
+            if (!QFileInfo::exists(r.index.q8Path)) {
+                annErr = QObject::tr("arquivo ausente; recrie os embeddings");
+            } else if (idx->q8.load(r.index.q8Path, &annErr)) {
+                idx->q8Ready = idx->q8.isCompatible(index);
+                if (!idx->q8Ready) annErr = QObject::tr("desatualizado em relação ao índice; recrie os embeddings");
+            }
+            if (!idx->q8Ready) qWarning() << "[Search] Índice quantizado indisponível, usando busca exata:" << annErr;
+        }
+        if (idx->q8Ready) return idx->q8.search(index, query, depth, metric, minScore, s.value("emb/sq8_rerank_factor", 4).toInt());
+    }
+    idx->index.setSearchThreads(s.value("emb/search_threads", 0).toInt()); // 0 = auto
+    return index.topK(query, depth, metric, minScore);
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "ai/FullTextIndex.h"
+#include "ai/PageTextExtractor.h"
+#include "ai/VectorIndex.h"
+
+// Document search off the GUI thread: plain-text search over the page text, and hybrid search,
+// where the lexical side (BM25 over the FullTextIndex) and the vector side (query embedding +
+// scan of the document's index) are fused by weighted reciprocal-rank fusion into chunk-level
+// hits: score = w_lex / (k + lexical rank) + w_vec / (k + vector rank), emb/hybrid_* settings.
+// Lexical matches are mapped to the chunks whose recorded span covers them; an index without
+// chunk spans (built before they were recorded) is fused per page instead. A request may then
+// have the best fused hits reordered by a reranker model (Reranker, emb/rerank_* settings).
+//
+// Requests run one at a time on a worker thread owned by the service. Each belongs to a lane; a
+// new request cancels the one still queued or running in its lane (typing a new query does not
+// disturb a chat answer being retrieved). A cancelled request stops at its next check and its
+// completion callback is never called.
+//
+// The worker keeps, across requests, the page text of the current document (read from the
+// PageTextCache, else extracted page by page and resumed where an interrupted request left it)
+// and the memory-mapped vector index with its HNSW graph / int8 codes, so repeated searches touch
+// no file data. Plain-text queries are answered from the document's FullTextIndex (loaded, or
+// built once the whole page text is known); before that, pages are scanned as they are extracted
+// and hits are reported as they are found (partialResults).
+class SearchService : public QObject {
+    Q_OBJECT
+public:
+    enum class Lane { Search, Answer, PageText };
+    enum class Mode { Plain, Hybrid };
+    // Index files of a document (see MainWindow::computeIndexPathsFor)
+    struct IndexFiles {
+        QString containerPath;
+        QString binPath; // legacy trio, converted to the container on first use
+        QString idsPath;
+        QString metaPath;
+        QString hnswPath;
+        QString q8Path;
+    };
+    struct Request {
+        Lane lane {Lane::Search};
+        Mode mode {Mode::Plain};
+        QString pdfPath;
+        QString dbDir;             // page-text cache and embedding cache (emb/db_path)
+        QString query;
+        int k {5};                 // distinct pages wanted
+        IndexFiles index;          // vector side of a hybrid search; none: lexical only
+        bool rerank {false};       // hybrid: reorder the best emb/rerank_candidates hits with the reranker
+    };
+    // Hybrid search hit: a chunk of the vector index, or a page when there is no index / spans
+    struct ChunkHit {
+        int page {0};          // where the chunk starts
+        int chunk {-1};        // row of the vector index; -1: page-level hit
+        int startOffset {-1};  // chunk span in the page text (-1: unknown)
+        int endPage {0};
+        int endOffset {-1};
+        int matchPage {0};     // first lexical match inside the chunk, if any
+        int matchStart {-1};
+        int matchEnd {-1};
+        double score {0.0};    // fused
+        int lexicalRank {0};   // 1-based rank in each list; 0: not in it
+        int vectorRank {0};
+        float vectorScore {0.0f};
+        double rerankScore {0.0}; // reranker relevance, when Result::reranked
+    };
+    struct Result {
+        qint64 id {0};
+        QList<int> pages;
+        QList<FullTextIndex::Hit> textHits; // lexical hits (pages with offsets), best first
+        QList<ChunkHit> chunks;             // hybrid: fused hits, best first
+        bool semantic {false}; // the vector side contributed
+        bool reranked {false}; // chunks were reordered by the reranker (best candidates first)
+        QStringList pageTexts; // PageText lane: the page text (partial if extraction failed)
+        QString error;
+    };
+    using Callback = std::function<void(const Result&)>;
+
+    explicit SearchService(QObject* parent = nullptr);
+    ~SearchService() override;
+
+    // Queues r, cancelling the request queued or running in its lane. done runs on receiver's
+    // thread once r completes (not at all if it is cancelled or receiver is gone). Returns its id.
+    qint64 submit(const Request& r, QObject* receiver, Callback done);
+    void cancel(Lane lane);
+    void cancelAll();
+    // Reads (or extracts) the page text of pdfPath in the background; emits pagesTextReady.
+    // A PageText request submitted with a callback gets the text in Result::pageTexts
+    void preloadPagesText(const QString& pdfPath, const QString& dbDir);
+    // Drops the resident index, waiting for a scan in progress. Call before its files are
+    // rewritten, moved or removed. The page text and full-text index are reread on the next
+    // request.
+    void invalidateIndex();
+
+signals:
+    // Log lines for the search progress dialog
+    void progress(qint64 id, const QString& line);
+    // Plain-text hits found so far by request id
+    void partialResults(qint64 id, const QList<int>& pages);
+    // The whole page text of pdfPath is loaded (from the cache or extracted)
+    void pagesTextReady(const QString& pdfPath, const QStringList& pages);
+
+private:
+    struct Job {
+        qint64 id {0};
+        Request request;
+        QPointer<QObject> receiver;
+        Callback done;
+    };
+    struct ResidentIndex;
+    static constexpr int kLanes = 3;
+
+    bool isCurrent(Lane lane, qint64 id) const { return latest_[int(lane)].load() == id; }
+    // Worker thread
+    void drain();
+    void execute(const Job& job);
+    QList<FullTextIndex::Hit> plainTextSearch(qint64 id, const Request& r, int maxPages);
+    void hybridSearch(qint64 id, const Request& r, Result* res);
+    // Query embedding (through the shared embedding cache); empty on failure
+    QVector<float> embedQuery(const Request& r, QString* err);
+    // With indexMutex_ held: the index of r, loaded or reused
+    ResidentIndex* residentIndex(qint64 id, const Request& r, QString* err);
+    QList<VectorIndex::Hit> scanIndex(ResidentIndex* idx, const Request& r, const QVector<float>& query, int depth);
+    // Reorders the best fused hits of res by the reranker's relevance; keeps them as they are
+    // when it is disabled, fails or runs out of its latency budget
+    void rerank(qint64 id, const Request& r, Result* res);
+    // Text of a hit (chunk span, else the whole page), extracting its pages if needed
+    QString passageText(const Request& r, const ChunkHit& h);
+    // Switches the resident page text / full-text index to pdfPath
+    void openText(const QString& pdfPath, const QString& dbDir);
+    // Loads or builds the full-text index once the whole page text is known
+    void completeText(const QString& pdfPath, const QString& dbDir);
+    // Visits the pages of pdfPath in order, extracting what is not loaded yet, until visit()
+    // returns false. Returns true once the whole text is loaded.
+    bool visitPagesText(const QString& pdfPath, const QString& dbDir, const std::function<bool(int, const QString&)>& visit);
+
+    QThread thread_;
+    QObject* worker_ {nullptr}; // lives on thread_; context of the queued drain() calls
+    std::atomic<qint64> nextId_ {0};
+    std::atomic<qint64> latest_[kLanes] {};
+    QMutex queueMutex_;
+    QList<Job> queue_;
+    bool draining_ {false}; // worker thread only
+
+    // Page text of the current document (worker thread only)
+    QString textPath_;
+    QStringList texts_;
+    QVector<PageTextExtractor::Source> textSources_;
+    bool textComplete_ {false};
+    FullTextIndex fullText_;
+
+    // Resident index, shared with invalidateIndex()
+    QMutex indexMutex_;
+    std::unique_ptr<ResidentIndex> index_;
+};
@@ -0,0 +1,395 @@
+#include "ai/TextChunker.h"
+
+#include <QObject>
+#include <QtGlobal>
+
+namespace {
+constexpr int kMaxHeadingChars = 80;
+
+bool isTerminal(QChar c) {
+    return c == QLatin1Char('.') || c == QLatin1Char('!') || c == QLatin1Char('?') || c == QChar(0x2026);
+}
+
+// Closing quotes/brackets that stay with the sentence they end
+bool isCloser(QChar c) {
+    return c == QLatin1Char('"') || c == QLatin1Char('\'') || c == QLatin1Char(')') || c == QLatin1Char(']')
+        || c == QChar(0x00BB) || c == QChar(0x201D) || c == QChar(0x2019);
+}
+
+bool isOpener(QChar c) {
+    return c == QLatin1Char('"') || c == QLatin1Char('\'') || c == QLatin1Char('(') || c == QLatin1Char('[')
+        || c == QChar(0x00AB) || c == QChar(0x201C) || c == QChar(0x2018) || c == QChar(0x2014);
+}
+
+// "Dr.", "fig.", "p." or an initial: the period does not end the sentence
+bool isAbbreviation(QStringView before) {
+    int k = int(before.size());
+    while (k > 0 && before.at(k - 1).isLetter()) --k;
+    const QStringView word = before.mid(k);
+    if (word.size() == 1) return true;
+    static const char* const kAbbrev[] = { "sr", "sra", "srs", "dr", "dra", "prof", "profa", "fig", "figs", "vol",
+                                           "cap", "art", "arts", "ex", "pág", "pag", "pp", "ed", "eq", "cf", "al",
+                                           "mr", "mrs", "ms", "st", "vs", "inc", "ltd", "no", "nº", "op", "cit" };
+    for (const char* a : kAbbrev) {
+        if (word.compare(QString::fromUtf8(a), Qt::CaseInsensitive) == 0) return true;
+    }
+    return false;
+}
+
+// Short line without closing punctuation that is numbered ("2.3 Resultados"), a chapter/section
+// keyword, a Markdown heading or all caps
+bool looksLikeHeading(QStringView line) {
+    if (line.size() > kMaxHeadingChars) return false;
+    const QChar last = line.at(line.size() - 1);
+    if (isTerminal(last) || last == QLatin1Char(',') || last == QLatin1Char(';') || last == QLatin1Char(':')) return false;
+    int letters = 0, upper = 0;
+    for (const QChar c : line) {
+        if (!c.isLetter()) continue;
+        ++letters;
+        if (c.isUpper()) ++upper;
+    }
+    if (letters < 2) return false;
+    if (line.startsWith(QLatin1Char('#'))) return true;
+    int k = 0;
+    while (k < line.size() && (line.at(k).isDigit() || line.at(k) == QLatin1Char('.'))) ++k;
+    if (k > 0 && k + 1 < line.size() && line.at(k).isSpace() && line.at(k + 1).isUpper()) return true;
+    if (upper == letters && letters >= 3) return true;
+    static const char* const kKeywords[] = { "capítulo", "seção", "secao", "parte", "anexo", "apêndice",
+                                             "chapter", "section", "part", "appendix" };
+    for (const char* kw : kKeywords) {
+        const QString w = QString::fromUtf8(kw);
+        if (line.startsWith(w, Qt::CaseInsensitive) && (line.size() == w.size() || !line.at(w.size()).isLetter()))
+            return true;
+    }
+    return false;
+}
+
+// Bullet ("•", "-", "*") or enumerator ("1)", "a)", "3.") followed by a space
+bool startsListItem(QStringView line) {
+    if (line.size() < 2) return false;
+    const QChar c = line.at(0);
+    if ((c == QChar(0x2022) || c == QChar(0x25E6) || c == QChar(0x2013) || c == QLatin1Char('-') || c == QLatin1Char('*'))
+        && line.at(1).isSpace())
+        return true;
+    int k = 0;
+    while (k < line.size() && k < 3 && line.at(k).isDigit()) ++k;
+    if (k == 0 && c.isLower()) k = 1;
+    return k > 0 && k + 1 < line.size() && (line.at(k) == QLatin1Char(')') || (line.at(k) == QLatin1Char('.') && c.isDigit()))
+        && line.at(k + 1).isSpace();
+}
+}
+
+int TextChunker::estimateTokens(QStringView text) {
+    int tokens = 0;
+    int run = 0;
+    for (const QChar c : text) {
+        if (c.isLetterOrNumber()) { ++run; continue; }
+        tokens += (run + 3) / 4;
+        run = 0;
+        if (!c.isSpace()) ++tokens;
+    }
+    return tokens + (run + 3) / 4;
+}
+
+TextChunker::TextChunker(const Params& p, QStringList* warnings) : p_(p) {
+    auto warn = [warnings](const QString& m) { if (warnings) warnings->append(m); };
+    if (p_.strategy == Strategy::Fixed && p_.unit == Unit::Tokens) {
+        warn(QObject::tr("Tamanho em tokens só se aplica à divisão estrutural. Usando caracteres."));
+        p_.unit = Unit::Chars;
+    }
+    if (p_.size <= 0) { warn(QObject::tr("chunkSize inválido (%1). Usando 1000.").arg(p_.size)); p_.size = 1000; }
+    if (p_.overlap < 0) { warn(QObject::tr("overlap negativo (%1). Usando 100.").arg(p_.overlap)); p_.overlap = 100; }
+    if (p_.overlap >= p_.size) {
+        const int newOv = qMax(0, p_.size / 4);
+        warn(QObject::tr("overlap (%1) >= chunkSize (%2). Ajustando overlap para %3.").arg(p_.overlap).arg(p_.size).arg(newOv));
+        p_.overlap = newOv;
+    }
+}
+
+int TextChunker::measure(QStringView text) const {
+    return p_.unit == Unit::Tokens ? estimateTokens(text) : int(text.size());
+}
+
+bool TextChunker::addPage(int page, const QString& text, const Consumer& consume) {
+    if (p_.strategy == Strategy::Fixed) return addPageFixed(page, text, consume);
+    pageText_.insert(page, text);
+    split_.clear();
+    splitPage(page, text);
+    for (const Segment& s : split_) {
+        if (!pack(s, consume)) return false;
+    }
+    split_.clear();
+    if (!p_.spanPages && pending_.size() > carried_ && !cutChunk(int(pending_.size()), consume)) return false;
+    if (!p_.spanPages) { pending_.clear(); pendingSize_ = 0; carried_ = 0; }
+    // Only the pages the chunk in progress starts on or after are still needed
+    const int keepFrom = pending_.isEmpty() ? page + 1 : pending_.first().page;
+    while (!pageText_.isEmpty() && pageText_.firstKey() < keepFrom) pageText_.erase(pageText_.begin());
+    return true;
+}
+
+bool TextChunker::finish(const Consumer& consume) {
+    bool ok = true;
+    if (pending_.size() > carried_) ok = cutChunk(int(pending_.size()), consume);
+    pending_.clear();
+    pendingSize_ = 0;
+    carried_ = 0;
+    pageText_.clear();
+    return ok;
+}
+
+bool TextChunker::addPageFixed(int page, const QString& text, const Consumer& consume) {
+    // Work with indices over the original string to avoid large allocations
+    const int n = int(text.size());
+    int i = 0;
+    while (i < n) {
+        const int take = qMax(1, qMin(p_.size, n - i));
+        const int j = i + take;
+        // Trim leading/trailing whitespace for the current chunk via indices
+        int start = i;
+        int end = j; // exclusive
+        while (start < end && text.at(start).isSpace()) ++start;
+        while (end > start && text.at(end - 1).isSpace()) --end;
+        if (end > start) {
+            Chunk c;
+            c.text = text.mid(start, end - start);
+            c.page = page;
+            c.startOffset = start;
+            c.endPage = page;
+            c.endOffset = end;
+            if (!deliver(std::move(c), consume)) return false;
+        }
+        int nextI = j - p_.overlap;
+        if (nextI <= i) nextI = i + take;
+        i = nextI;
+    }
+    return true;
+}
+
+void TextChunker::splitPage(int page, const QString& text) {
+    const int n = int(text.size());
+    const QStringView view(text);
+    Boundary next = pageBreak_;
+    int blockStart = -1, blockEnd = -1;
+    Boundary blockBefore = next;
+    auto closeBlock = [&]() {
+        if (blockStart >= 0) splitBlock(page, text, blockStart, blockEnd, blockBefore);
+        blockStart = -1;
+    };
+    int lastEnd = -1;
+    for (int i = 0; i < n;) {
+        int e = int(text.indexOf(QLatin1Char('\n'), i));
+        if (e < 0) e = n;
+        int a = i, b = e;
+        i = e + 1;
+        while (a < b && text.at(a).isSpace()) ++a;
+        while (b > a && text.at(b - 1).isSpace()) --b;
+        if (a == b) {
+            closeBlock();
+            next = qMax(next, Paragraph);
+            continue;
+        }
+        lastEnd = b;
+        const QStringView line = view.mid(a, b - a);
+        if (looksLikeHeading(line)) {
+            closeBlock();
+            pushSegment(page, text, a, b, Heading, true);
+            next = Line;
+            continue;
+        }
+        if (blockStart >= 0 && startsListItem(line)) {
+            closeBlock();
+            next = qMax(next, Paragraph);
+        }
+        if (blockStart < 0) {
+            blockStart = a;
+            blockBefore = next;
+            next = Word;
+        }
+        blockEnd = b;
+    }
+    closeBlock();
+    // A page that ends mid-sentence continues on the next one
+    if (lastEnd > 0) {
+        int k = lastEnd;
+        while (k > 0 && isCloser(text.at(k - 1))) --k;
+        pageBreak_ = k > 0 && isTerminal(text.at(k - 1)) ? Paragraph : Word;
+    }
+}
+
+void TextChunker::splitBlock(int page, const QString& text, int start, int end, Boundary before) {
+    int s = start;
+    Boundary b = before;
+    for (int k = start; k < end; ++k) {
+        const QChar c = text.at(k);
+        if (!isTerminal(c)) continue;
+        int e = k + 1;
+        while (e < end && isCloser(text.at(e))) ++e;
+        if (e >= end || !text.at(e).isSpace()) continue;
+        int nx = e;
+        bool newline = false;
+        while (nx < end && text.at(nx).isSpace()) {
+            newline = newline || text.at(nx) == QLatin1Char('\n');
+            ++nx;
+        }
+        if (nx >= end) break;
+        const QChar nc = text.at(nx);
+        if (!nc.isUpper() && !nc.isDigit() && !isOpener(nc)) continue;
+        if (c == QLatin1Char('.') && isAbbreviation(QStringView(text).mid(s, k - s))) continue;
+        pushSegment(page, text, s, e, b, false);
+        // A sentence ending at a line end is a stronger break than one mid-line
+        b = newline ? Line : Sentence;
+        s = nx;
+        k = nx - 1;
+    }
+    pushSegment(page, text, s, end, b, false);
+}
+
+void TextChunker::pushSegment(int page, const QString& text, int start, int end, Boundary before, bool heading) {
+    while (start < end && text.at(start).isSpace()) ++start;
+    while (end > start && text.at(end - 1).isSpace()) --end;
+    if (start >= end) return;
+    const QStringView view(text);
+    const int size = measure(view.mid(start, end - start));
+    if (size <= p_.size) {
+        split_.append(Segment{ page, start, end, size, before, heading });
+        return;
+    }
+    // Longer than a chunk: cut between words
+    const bool chars = p_.unit == Unit::Chars;
+    int pieceStart = start, pieceEnd = start, pieceSize = 0;
+    Boundary b = before;
+    int k = start;
+    while (k < end) {
+        while (k < end && text.at(k).isSpace()) ++k;
+        const int ws = k;
+        while (k < end && !text.at(k).isSpace()) ++k;
+        if (ws == k) break;
+        const int w = chars ? 0 : estimateTokens(view.mid(ws, k - ws));
+        int grown = chars ? k - pieceStart : pieceSize + w;
+        if (pieceEnd > pieceStart && grown > p_.size) {
+            split_.append(Segment{ page, pieceStart, pieceEnd, pieceSize, b, heading });
+            b = Word;
+            pieceStart = ws;
+            grown = chars ? k - ws : w;
+        }
+        if (grown > p_.size) {
+            // One "word" longer than a chunk (formula, URL, table row without spaces): hard cuts.
+            // A character never counts as more than one token, so size characters always fit.
+            for (int c = ws; c < k; c += p_.size) {
+                const int ce = qMin(k, c + p_.size);
+                split_.append(Segment{ page, c, ce, measure(view.mid(c, ce - c)), b, heading });
+                b = Word;
+            }
+            pieceStart = pieceEnd = k;
+            pieceSize = 0;
+            continue;
+        }
+        pieceEnd = k;
+        pieceSize = grown;
+    }
+    if (pieceEnd > pieceStart) split_.append(Segment{ page, pieceStart, pieceEnd, pieceSize, b, heading });
+}
+
+bool TextChunker::pack(const Segment& s, const Consumer& consume) {
+    if (s.before == Heading && !pending_.isEmpty()) {
+        // A new section starts a new chunk unless the current one is still small; the tail of the
+        // previous section is not carried into it
+        if (pending_.size() == carried_) {
+            pending_.clear();
+            pendingSize_ = 0;
+            carried_ = 0;
+        } else if (pendingSize_ >= p_.size / 3 && !cutChunk(int(pending_.size()), consume)) {
+            return false;
+        }
+    }
+    while (!pending_.isEmpty() && pendingSize_ + s.size > p_.size) {
+        if (pending_.size() == carried_) {
+            pending_.clear();
+            pendingSize_ = 0;
+            carried_ = 0;
+            break;
+        }
+        const int cut = chooseCut(s);
+        // Overlap: whole trailing sentences of the part being cut, not across a heading and never
+        // the entire part
+        const Boundary after = cut < pending_.size() ? pending_.at(cut).before : s.before;
+        QVector<Segment> overlap;
+        int overlapSize = 0;
+        if (p_.overlap > 0 && after < Heading) {
+            for (int k = cut - 1; k >= 1 && overlapSize + pending_.at(k).size <= p_.overlap; --k) {
+                overlapSize += pending_.at(k).size;
+                overlap.prepend(pending_.at(k));
+            }
+        }
+        if (!cutChunk(cut, consume)) return false;
+        // Dropped when it would not leave room for the next sentence
+        if (!overlap.isEmpty() && pendingSize_ + overlapSize + s.size <= p_.size) {
+            pending_ = overlap + pending_;
+            pendingSize_ += overlapSize;
+            carried_ = int(overlap.size());
+        }
+    }
+    pending_.append(s);
+    pendingSize_ += s.size;
+    return true;
+}
+
+int TextChunker::chooseCut(const Segment& next) const {
+    // Number of leading sentences of pending_ to cut: the strongest boundary once at least half
+    // the size is filled, the later one on ties; pending_ as a whole unless it ends in a heading
+    const int n = int(pending_.size());
+    const int half = p_.size / 2;
+    int best = -1;
+    Boundary bestLevel = Word;
+    if (!pending_.last().heading) { best = n; bestLevel = next.before; }
+    int prefix = 0;
+    for (int i = 1; i < n; ++i) {
+        prefix += pending_.at(i - 1).size;
+        if (i <= carried_ || prefix < half || pending_.at(i - 1).heading) continue;
+        const Boundary level = pending_.at(i).before;
+        if (best < 0 || level > bestLevel || (level == bestLevel && best != n)) {
+            best = i;
+            bestLevel = level;
+        }
+    }
+    if (best >= 0) return best;
+    return n - 1 > carried_ ? n - 1 : n;
+}
+
+bool TextChunker::cutChunk(int count, const Consumer& consume) {
+    const Segment& first = pending_.at(0);
+    const Segment& last = pending_.at(count - 1);
+    Chunk c;
+    c.page = first.page;
+    c.startOffset = first.start;
+    c.endPage = last.page;
+    c.endOffset = last.end;
+    // The original text of each page (whitespace and line breaks kept), pages joined by a newline
+    for (int k = 0; k < count;) {
+        const int page = pending_.at(k).page;
+        int j = k;
+        while (j + 1 < count && pending_.at(j + 1).page == page) ++j;
+        const auto it = pageText_.constFind(page);
+        if (it != pageText_.constEnd()) {
+            if (!c.text.isEmpty()) c.text += QLatin1Char('\n');
+            c.text += QStringView(it.value()).mid(pending_.at(k).start, pending_.at(j).end - pending_.at(k).start);
+        }
+        k = j + 1;
+    }
+    for (int k = 0; k < count; ++k) pendingSize_ -= pending_.at(k).size;
+    pending_.remove(0, count);
+    carried_ = 0;
+    return deliver(std::move(c), consume);
+}
+
+bool TextChunker::deliver(Chunk&& c, const Consumer& consume) {
+    if (c.page == lastPage_) {
+        ++indexInPage_;
+    } else {
+        lastPage_ = c.page;
+        indexInPage_ = 0;
+    }
+    c.index = indexInPage_;
+    ++emitted_;
+    return consume(c);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+#include <functional>
+
+// Cuts the page text of a document into the chunks the indexer embeds.
+//
+// Strategies:
+// - Fixed: windows of `size` characters advanced by size - overlap, cut at any offset; chunks
+//   never cross a page (the original indexer behavior).
+// - Structure: each page is split into blocks (blank lines, headings, list items) and blocks
+//   into sentences, each tagged with the strength of the boundary before it. Sentences are
+//   packed greedily up to `size`; when the next one does not fit, the chunk is cut at the
+//   strongest boundary in its second half (a heading or paragraph break over a sentence end),
+//   and a heading closes the chunk in progress once it holds a third of `size`. A heading is
+//   never left as the last line of a chunk. Overlap repeats whole trailing sentences of the
+//   previous chunk, never across a heading. Sentences longer than `size` are cut between words.
+//   With spanPages, packing continues across page breaks.
+//
+// Sizes and overlap are measured in characters or in estimated tokens (Structure only).
+//
+// Every chunk records where it starts and ends (page + character offset into that page's
+// extracted text), so a hit can be mapped back to the exact passage.
+class TextChunker {
+public:
+    enum class Strategy { Fixed, Structure };
+    enum class Unit { Chars, Tokens };
+    // Maps the emb/chunk_strategy ("structure", "fixed") and emb/chunk_unit ("chars", "tokens")
+    // settings
+    static Strategy strategyFromString(const QString& s) {
+        return s == QLatin1String("fixed") ? Strategy::Fixed : Strategy::Structure;
+    }
+    static Unit unitFromString(const QString& s) {
+        return s == QLatin1String("tokens") ? Unit::Tokens : Unit::Chars;
+    }
+
+    struct Params {
+        Strategy strategy {Strategy::Structure};
+        Unit unit {Unit::Chars};
+        int size {1000};
+        int overlap {200};
+        bool spanPages {true};
+    };
+    struct Chunk {
+        QString text;
+        int page {0};        // page where the chunk starts (1-based)
+        int index {0};       // among the chunks starting on that page
+        int startOffset {0}; // into the text of page
+        int endPage {0};
+        int endOffset {0};   // exclusive, into the text of endPage
+    };
+    // Returns false to stop chunking
+    using Consumer = std::function<bool(const Chunk&)>;
+
+    // Rough subword token count: one token per ~4 letters/digits of a word, one per other
+    // non-space character. Close enough to BPE tokenizers to size chunks, not to bill them.
+    static int estimateTokens(QStringView text);
+
+    // Invalid size/overlap are corrected; each correction is described in warnings
+    explicit TextChunker(const Params& p, QStringList* warnings = nullptr);
+
+    // Feeds the next page (pages in order) and hands over the chunks completed so far.
+    // Returns false once consume() does.
+    bool addPage(int page, const QString& text, const Consumer& consume);
+    // Hands over the chunk still being packed
+    bool finish(const Consumer& consume);
+
+    const Params& params() const { return p_; }
+    int chunkCount() const { return emitted_; }
+
+private:
+    // Strength of the break before a segment; the packer prefers to cut at the strongest
+    enum Boundary : quint8 { Word, Sentence, Line, Paragraph, Heading };
+    struct Segment { // a sentence, a heading or a piece of an overlong sentence
+        int page {0};
+        int start {0};
+        int end {0}; // exclusive
+        int size {0};
+        Boundary before {Word};
+        bool heading {false};
+    };
+
+    int measure(QStringView text) const;
+    bool addPageFixed(int page, const QString& text, const Consumer& consume);
+    void splitPage(int page, const QString& text);
+    void splitBlock(int page, const QString& text, int start, int end, Boundary before);
+    void pushSegment(int page, const QString& text, int start, int end, Boundary before, bool heading);
+    bool pack(const Segment& s, const Consumer& consume);
+    int chooseCut(const Segment& next) const;
+    bool cutChunk(int count, const Consumer& consume);
+    bool deliver(Chunk&& c, const Consumer& consume);
+
+    Params p_;
+    // Structure: segments split from the last page, then the chunk being packed
+    QVector<Segment> split_;
+    QVector<Segment> pending_;
+    int pendingSize_ {0};
+    int carried_ {0};                 // leading segments of pending_ repeated as overlap
+    QMap<int, QString> pageText_;     // pages still referenced by pending_
+    Boundary pageBreak_ {Paragraph};  // boundary before the first sentence of the next page
+    int lastPage_ {0};
+    int indexInPage_ {0};
+    int emitted_ {0};
+};
@@ -0,0 +1,469 @@
+#include "ai/VectorIndex.h"
+#include "ai/VectorKernels.h"
+
+#include <QObject>
+#include <QDebug>
+#include <QtGlobal>
+#include <QThread>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+VectorIndex::~VectorIndex() {
+    unmap();
+    releaseBuffer();
+}
+
+void VectorIndex::unmap() {
+    if (mapFile_ && mapBase_) mapFile_->unmap(mapBase_);
+    if (mapFile_) mapFile_->close();
+    const bool wasMapped = mapBase_ != nullptr;
+    mapFile_.reset();
+    mapBase_ = nullptr;
+    if (wasMapped) { data_ = nullptr; count_ = 0; dim_ = 0; norms_ = nullptr; rows_ = nullptr; spans_ = nullptr; strOffsets_ = nullptr; strBlob_ = nullptr; strCount_ = 0; }
+}
+
+void VectorIndex::releaseBuffer() {
+    if (buf_) qFreeAligned(buf_);
+    buf_ = nullptr;
+    capacity_ = 0;
+}
+
+void VectorIndex::clear() {
+    unmap();
+    count_ = 0;
+    dim_ = 0;
+    data_ = buf_;
+    ownedNorms_.clear();
+    norms_ = nullptr;
+    legacy_ = false;
+    rows_ = nullptr;
+    spans_ = nullptr;
+    strOffsets_ = nullptr;
+    strBlob_ = nullptr;
+    strCount_ = 0;
+    containerBytes_.clear();
+}
+
+void VectorIndex::reserve(int rows, int dim) {
+    if (isReadOnlyView()) clear();
+    if (count_ == 0 && dim > 0) dim_ = dim;
+    if (dim_ > 0) growTo(rows);
+    ownedNorms_.reserve(rows);
+    data_ = buf_;
+}
+
+bool VectorIndex::growTo(int rows) {
+    const qint64 floats = qint64(rows) * dim_;
+    if (floats <= capacity_) return true;
+    float* nb = static_cast<float*>(qMallocAligned(size_t(floats) * sizeof(float), kAlignment));
+    if (!nb) return false;
+    if (buf_ && count_ > 0) std::memcpy(nb, buf_, size_t(count_) * size_t(dim_) * sizeof(float));
+    if (buf_) qFreeAligned(buf_);
+    buf_ = nb;
+    capacity_ = floats;
+    data_ = buf_;
+    return true;
+}
+
+void VectorIndex::computeNorms(int from) {
+    ownedNorms_.resize(count_);
+    for (int i = from; i < count_; ++i) {
+        ownedNorms_[i] = std::sqrt(VectorKernels::squaredNorm(rowData(i), dim_));
+    }
+    norms_ = ownedNorms_.constData();
+}
+
+bool VectorIndex::appendRow(const float* v, int dim) {
+    if (isReadOnlyView()) clear();
+    if (dim <= 0) return false;
+    if (count_ == 0) dim_ = dim;
+    if (dim != dim_) return false;
+    if (qint64(count_ + 1) * dim_ > capacity_) {
+        // Geometric growth keeps appends amortized O(1)
+        if (!growTo(qMax(64, count_ * 2))) return false;
+    }
+    std::memcpy(buf_ + qint64(count_) * dim_, v, size_t(dim_) * sizeof(float));
+    ++count_;
+    data_ = buf_;
+    computeNorms(count_ - 1);
+    return true;
+}
+
+void VectorIndex::setVectors(const QList<QVector<float>>& vecs) {
+    clear();
+    if (vecs.isEmpty()) return;
+    reserve(int(vecs.size()), int(vecs.first().size()));
+    for (const auto& v : vecs) {
+        if (!appendRow(v)) {
+            qWarning() << "[VectorIndex] vetor ignorado: dimensão" << v.size() << "!=" << dim_;
+        }
+    }
+}
+
+quint64 VectorIndex::fingerprint() const {
+    // FNV-1a over a few bytes per row: the norm covers the whole row, the leading components
+    // and the row table tell apart rows with equal norms
+    quint64 h = 0xcbf29ce484222325ull;
+    auto mix = [&h](const void* p, size_t n) {
+        const uchar* b = static_cast<const uchar*>(p);
+        for (size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 0x100000001b3ull; }
+    };
+    const qint32 shape[2] = { count_, dim_ };
+    mix(shape, sizeof(shape));
+    const size_t lead = size_t(qMin(dim_, kFingerprintComponents)) * sizeof(float);
+    for (int i = 0; i < count_; ++i) {
+        const float nv = norm(i);
+        mix(&nv, sizeof(nv));
+        mix(rowData(i), lead);
+        if (rows_) mix(rows_ + qint64(i) * kRowColumns, size_t(kRowColumns) * sizeof(qint32));
+    }
+    return h;
+}
+
+bool VectorIndex::parseHeader(const char* p, qint64 avail, qint64 fileSize, Header* h, QString* err) {
+    auto invalid = [err]() { if (err) *err = QObject::tr("Arquivo de vetores inválido"); return false; };
+    if (avail < kHeaderSizeV1) return invalid();
+    qint32 c = 0, d = 0;
+    quint32 flags = 0;
+    std::memcpy(&c, p + 4, sizeof(qint32));
+    std::memcpy(&d, p + 8, sizeof(qint32));
+    qint64 headerSize = kHeaderSizeV1;
+    bool legacy = false;
+    if (std::strncmp(p, "VEC2", 4) == 0) {
+        if (avail < kHeaderSizeV2) return invalid();
+        std::memcpy(&flags, p + 12, sizeof(quint32));
+        headerSize = kHeaderSizeV2;
+    } else if (std::strncmp(p, "VEC1", 4) == 0) {
+        legacy = true;
+    } else {
+        return invalid();
+    }
+    if (c < 0 || d <= 0) return invalid();
+    // The payload must hold exactly count*dim floats (+ norms); a shorter file means an interrupted write.
+    qint64 expected = headerSize + qint64(c) * qint64(d) * qint64(sizeof(float));
+    if (flags & kFlagHasNorms) expected += qint64(c) * qint64(sizeof(float));
+    if (fileSize < expected) {
+        if (err) *err = QObject::tr("Arquivo de vetores truncado (%1 bytes, esperado %2)").arg(fileSize).arg(expected);
+        return false;
+    }
+    h->count = c;
+    h->dim = d;
+    h->flags = flags;
+    h->size = headerSize;
+    h->legacy = legacy;
+    return true;
+}
+
+bool VectorIndex::loadIds(const QString& idsJsonPath, QStringList* ids, QString* err) {
+    QFile fj(idsJsonPath);
+    if (!fj.open(QIODevice::ReadOnly)) { if (err) *err = QObject::tr("Falha ao abrir JSON de ids"); return false; }
+    const QJsonDocument doc = QJsonDocument::fromJson(fj.readAll()); fj.close();
+    for (const auto& x : doc.array()) ids->append(x.toString());
+    return true;
+}
+
+bool VectorIndex::save(const QString& binPath, const QString& idsJsonPath, QString* err) const {
+    if (isEmpty()) {
+        QFile fb(binPath);
+        if (!fb.open(QIODevice::WriteOnly)) { if (err) *err = QObject::tr("Falha ao salvar binário de vetores"); return false; }
+        fb.close();
+        return true;
+    }
+    Writer w;
+    if (!w.open(binPath, err)) return false;
+    for (int i = 0; i < count_; ++i) {
+        if (!w.append(rowData(i), dim_, err)) { w.close(); return false; }
+    }
+    if (!w.finish(err)) return false;
+
+    // ids (containers carry them in the row table)
+    QJsonArray arr;
+    if (ids_.isEmpty() && hasRowTable()) { for (int i = 0; i < count_; ++i) arr.append(QString::number(chunkId(i))); }
+    else { for (const auto& id : ids_) arr.append(id); }
+    QFile fj(idsJsonPath); if (!fj.open(QIODevice::WriteOnly)) { if (err) *err = QObject::tr("Falha ao salvar JSON de ids"); return false; }
+    fj.write(QJsonDocument(arr).toJson(QJsonDocument::Compact)); fj.close();
+    return true;
+}
+
+bool VectorIndex::load(const QString& binPath, const QString& idsJsonPath, QString* err) {
+    clear();
+    ids_.clear();
+    QFile fb(binPath);
+    if (!fb.open(QIODevice::ReadOnly)) { if (err) *err = QObject::tr("Falha ao abrir binário de vetores"); return false; }
+    char raw[kHeaderSizeV2];
+    const qint64 got = fb.read(raw, kHeaderSizeV2);
+    Header h;
+    if (!parseHeader(raw, got, fb.size(), &h, err)) { fb.close(); return false; }
+    // Single read straight into the contiguous buffer
+    fb.seek(h.size);
+    reserve(h.count, h.dim);
+    if (h.count > 0) {
+        const qint64 bytes = qint64(h.count) * h.dim * qint64(sizeof(float));
+        if (!buf_ || fb.read(reinterpret_cast<char*>(buf_), bytes) != bytes) {
+            if (err) *err = QObject::tr("Falha ao ler vetores");
+            fb.close();
+            clear();
+            return false;
+        }
+        count_ = h.count;
+    }
+    if (h.flags & kFlagHasNorms) {
+        ownedNorms_.resize(count_);
+        const qint64 bytes = qint64(count_) * qint64(sizeof(float));
+        if (count_ > 0 && fb.read(reinterpret_cast<char*>(ownedNorms_.data()), bytes) != bytes) {
+            if (err) *err = QObject::tr("Falha ao ler normas");
+            fb.close();
+            clear();
+            return false;
+        }
+        norms_ = ownedNorms_.constData();
+    } else {
+        computeNorms(0);
+    }
+    legacy_ = h.legacy;
+    fb.close();
+    if (!loadIds(idsJsonPath, &ids_, err)) return false;
+    return ids_.size() == count_;
+}
+
+bool VectorIndex::loadMapped(const QString& binPath, const QString& idsJsonPath, QString* err) {
+    clear();
+    ids_.clear();
+    auto file = std::make_unique<QFile>(binPath);
+    if (!file->open(QIODevice::ReadOnly)) { if (err) *err = QObject::tr("Falha ao abrir binário de vetores"); return false; }
+    const qint64 size = file->size();
+    if (size < kHeaderSizeV1) {
+        if (err) *err = QObject::tr("Arquivo de vetores inválido");
+        return false;
+    }
+    uchar* base = file->map(0, size);
+    if (!base) {
+        // mmap unavailable (e.g. special file systems): use the copying loader
+        qInfo() << "[VectorIndex] mmap indisponível, usando carregamento em memória:" << file->errorString();
+        file->close();
+        return load(binPath, idsJsonPath, err);
+    }
+    Header h;
+    if (!parseHeader(reinterpret_cast<const char*>(base), size, size, &h, err)) {
+        file->unmap(base);
+        return false;
+    }
+    mapFile_ = std::move(file);
+    mapBase_ = base;
+    // map() returns a page-aligned address and the header is 12/16 bytes, so rows are float-aligned
+    data_ = reinterpret_cast<const float*>(base + h.size);
+    count_ = h.count;
+    dim_ = h.dim;
+    legacy_ = h.legacy;
+    if (h.flags & kFlagHasNorms) {
+        norms_ = data_ + qint64(count_) * dim_;
+    } else {
+        computeNorms(0); // legacy VEC1: one pass at load instead of one per query
+    }
+    if (!loadIds(idsJsonPath, &ids_, err)) { clear(); return false; }
+    return ids_.size() == count_;
+}
+
+bool VectorIndex::upgradeFile(const QString& binPath, bool* upgraded, QString* err) {
+    if (upgraded) *upgraded = false;
+    QFile in(binPath);
+    if (!in.open(QIODevice::ReadOnly)) { if (err) *err = QObject::tr("Falha ao abrir binário de vetores"); return false; }
+    char raw[kHeaderSizeV2];
+    const qint64 got = in.read(raw, kHeaderSizeV2);
+    Header h;
+    if (!parseHeader(raw, got, in.size(), &h, err)) return false;
+    if (!h.legacy) return true;
+
+    // Stream rows from the old file into a VEC2 written next to it, then swap atomically
+    const QString tmpPath = binPath + QStringLiteral(".upgrade");
+    Writer w;
+    if (!w.open(tmpPath, err)) return false;
+    in.seek(h.size);
+    QVector<float> row(h.dim);
+    const qint64 rowBytes = qint64(h.dim) * qint64(sizeof(float));
+    for (int i = 0; i < h.count; ++i) {
+        if (in.read(reinterpret_cast<char*>(row.data()), rowBytes) != rowBytes || !w.append(row.constData(), h.dim, err)) {
+            if (err && err->isEmpty()) *err = QObject::tr("Falha ao ler vetores");
+            w.close();
+            QFile::remove(tmpPath);
+            return false;
+        }
+    }
+    in.close();
+    if (!w.finish(err)) { QFile::remove(tmpPath); return false; }
+    if (!replaceFile(tmpPath, binPath, err)) {
+        QFile::remove(tmpPath);
+        return false;
+    }
+    if (upgraded) *upgraded = true;
+    return true;
+}
+
+bool VectorIndex::replaceFile(const QString& from, const QString& to, QString* err) {
+    // QFile::rename refuses to overwrite, and removing the target first leaves a window where
+    // neither file exists; std::filesystem::rename replaces the target atomically
+    std::error_code ec;
+    std::filesystem::rename(std::filesystem::path(from.toStdU16String()), std::filesystem::path(to.toStdU16String()), ec);
+    if (!ec) return true;
+    if (err) *err = QObject::tr("Não foi possível mover %1 para %2: %3").arg(from, to, QString::fromStdString(ec.message()));
+    return false;
+}
+
+// ---- Writer ----
+
+bool VectorIndex::Writer::open(const QString& binPath, QString* err) {
+    file_.setFileName(binPath);
+    count_ = 0;
+    dim_ = 0;
+    norms_.clear();
+    if (!file_.open(QIODevice::WriteOnly)) {
+        if (err) *err = QObject::tr("Falha ao abrir binário '%1' para escrita: %2").arg(binPath, file_.errorString());
+        return false;
+    }
+    // Provisional header: magic + count(0) + dim(0) + flags(0), patched by finish()
+    const quint32 flags = 0;
+    file_.write("VEC2", 4);
+    file_.write(reinterpret_cast<const char*>(&count_), sizeof(qint32));
+    file_.write(reinterpret_cast<const char*>(&dim_), sizeof(qint32));
+    file_.write(reinterpret_cast<const char*>(&flags), sizeof(quint32));
+    return true;
+}
+
+bool VectorIndex::Writer::append(const float* v, int dim, QString* err) {
+    if (dim_ == 0) dim_ = dim;
+    if (dim != dim_) {
+        if (err) *err = QObject::tr("Dimensão inconsistente (%1 != %2)").arg(dim).arg(dim_);
+        return false;
+    }
+    const qint64 bytes = qint64(sizeof(float)) * dim;
+    if (file_.write(reinterpret_cast<const char*>(v), bytes) != bytes) {
+        if (err) *err = QObject::tr("Falha ao escrever vetor no arquivo binário '%1': %2").arg(file_.fileName(), file_.errorString());
+        return false;
+    }
+    norms_.append(std::sqrt(VectorKernels::squaredNorm(v, dim)));
+    ++count_;
+    return true;
+}
+
+bool VectorIndex::Writer::finish(QString* err) {
+    if (!file_.isOpen()) {
+        if (err) *err = QObject::tr("Arquivo binário '%1' fechou antes da atualização do cabeçalho.").arg(file_.fileName());
+        return false;
+    }
+    // Norms trailer right after the last row
+    const qint64 normBytes = qint64(norms_.size()) * qint64(sizeof(float));
+    if (normBytes > 0 && file_.write(reinterpret_cast<const char*>(norms_.constData()), normBytes) != normBytes) {
+        if (err) *err = QObject::tr("Falha ao escrever normas no arquivo '%1': %2").arg(file_.fileName(), file_.errorString());
+        file_.close();
+        return false;
+    }
+    const qint32 d = dim_ > 0 ? dim_ : 1; // readers reject dim=0
+    const quint32 flags = kFlagHasNorms;
+    file_.seek(4);
+    file_.write(reinterpret_cast<const char*>(&count_), sizeof(qint32));
+    file_.write(reinterpret_cast<const char*>(&d), sizeof(qint32));
+    file_.write(reinterpret_cast<const char*>(&flags), sizeof(quint32));
+    file_.close();
+    return true;
+}
+
+namespace {
+// Strict "better than" ordering: higher score first, lower row index on ties (deterministic)
+inline bool betterHit(const VectorIndex::Hit& a, const VectorIndex::Hit& b) {
+    return a.score > b.score || (a.score == b.score && a.index < b.index);
+}
+}
+
+void VectorIndex::scanRange(const float* q, float nq, int begin, int end, int k, Metric metric, float minScore,
+                            std::vector<Hit>* heap) const {
+    const int d = dim_;
+    // With betterHit as the heap ordering, heap->front() is the worst hit kept so far
+    for (int i = begin; i < end; ++i) {
+        const float* v = rowData(i);
+        float score = 0.0f;
+        if (metric == Metric::Cosine) {
+            // Row norms are precomputed, so cosine costs one dot product per row
+            const float nv = norms_[i];
+            const float dp = VectorKernels::dot(q, v, d);
+            score = (nq>0 && nv>0) ? (dp/(nq*nv)) : 0.0f;
+        } else if (metric == Metric::Dot) {
+            score = VectorKernels::dot(q, v, d);
+        } else { // L2: use negative distance so that higher is better
+            score = -std::sqrt(VectorKernels::squaredL2(q, v, d));
+        }
+        if (!(score >= minScore)) continue; // also drops NaN
+        const Hit h{i, score};
+        if (int(heap->size()) < k) {
+            heap->push_back(h);
+            std::push_heap(heap->begin(), heap->end(), betterHit);
+        } else if (betterHit(h, heap->front())) {
+            std::pop_heap(heap->begin(), heap->end(), betterHit);
+            heap->back() = h;
+            std::push_heap(heap->begin(), heap->end(), betterHit);
+        }
+    }
+}
+
+QList<VectorIndex::Hit> VectorIndex::topK(const QVector<float>& query, int k, Metric metric, float minScore) const {
+    QList<Hit> hits;
+    const int n = count_;
+    if (n == 0 || k <= 0) return hits;
+    const int d = dim_;
+    // A query of another size comes from another model: truncating it would give meaningless scores
+    if (query.size() != d) {
+        qWarning() << "[VectorIndex] query dimension" << query.size() << "does not match index dimension" << d;
+        return hits;
+    }
+    const float* q = query.constData();
+    // SIMD kernels (runtime-dispatched); scores match the double-precision scalar
+    // path within VectorKernels::kRelTolerance.
+    const float nq = std::sqrt(VectorKernels::squaredNorm(q, d));
+    const int keep = qMin(k, n);
+
+    // Shard the scan when there is enough work for more than one thread
+    const int budget = searchThreads_ > 0 ? searchThreads_ : qMax(1, QThread::idealThreadCount());
+    const qint64 work = qint64(n) * qMax(1, d);
+    const int shards = int(qBound<qint64>(1, work / kMinShardFloats, qMin<qint64>(budget, n)));
+
+    std::vector<Hit> heap;
+    if (shards <= 1) {
+        heap.reserve(size_t(keep));
+        scanRange(q, nq, 0, n, keep, metric, minScore, &heap);
+        std::sort_heap(heap.begin(), heap.end(), betterHit); // best first
+    } else {
+        std::vector<std::vector<Hit>> parts(static_cast<size_t>(shards));
+        const int per = (n + shards - 1) / shards;
+        QSemaphore done;
+        QThreadPool* pool = QThreadPool::globalInstance();
+        for (int sh = 1; sh < shards; ++sh) {
+            const int begin = qMin(n, sh * per);
+            const int end = qMin(n, begin + per);
+            std::vector<Hit>* part = &parts[size_t(sh)];
+            auto task = [this, q, nq, begin, end, keep, metric, minScore, part, &done]() {
+                part->reserve(size_t(keep));
+                scanRange(q, nq, begin, end, keep, metric, minScore, part);
+                done.release();
+            };
+            // Never block on a saturated pool: run the shard inline instead
+            if (!pool->tryStart(task)) task();
+        }
+        parts[0].reserve(size_t(keep));
+        scanRange(q, nq, 0, qMin(n, per), keep, metric, minScore, &parts[0]);
+        done.acquire(shards - 1);
+
+        // Deterministic merge: same total order as the single-threaded path
+        heap.reserve(size_t(keep) * size_t(shards));
+        for (const auto& part : parts) heap.insert(heap.end(), part.begin(), part.end());
+        const size_t top = qMin(heap.size(), size_t(keep));
+        std::partial_sort(heap.begin(), heap.begin() + std::ptrdiff_t(top), heap.end(), betterHit);
+        heap.resize(top);
+    }
+    hits.reserve(qsizetype(heap.size()));
+    for (const Hit& h : heap) hits.append(h);
+    return hits;
+}
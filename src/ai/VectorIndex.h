@@ -3,60 +3,188 @@
 #include <QVector>
 #include <QList>
 #include <QString>
+#include <QStringList>
 #include <QByteArray>
 #include <QFile>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QHash>
 #include <QtMath>
+#include <memory>
+#include <limits>
+#include <vector>
 
 // Minimal cosine-similarity index (linear scan). Stores vectors and metadata ids.
+//
+// Vectors are kept row-major in one contiguous float block (count x dim), either an
+// owned 64-byte aligned buffer or a read-only memory-mapped vector file. Rows are exposed
+// through RowView so callers never need per-row containers.
+//
+// File formats (little-endian):
+// - VEC2 (written): magic "VEC2" + count(int32) + dim(int32) + flags(uint32), then
+//   count*dim floats and, when flags has kFlagHasNorms, count floats with the L2 norm
+//   of each row. Stored norms turn Cosine into a single dot product per row.
+// - VEC1 (legacy, read-only): magic "VEC1" + count + dim + count*dim floats. Norms are
+//   computed once at load time; upgradeFile() rewrites such a file as VEC2.
+// - GIDX container (".gidx", replaces the .bin/.ids.json/.meta.json trio): a 32-byte header
+//   (magic "GIDX", version, count, dim, sectionCount, flags, 8 reserved bytes), a directory of
+//   sectionCount entries {tag[4], reserved(uint32), offset(int64), size(int64)} and 64-byte
+//   aligned sections:
+//     "VECS" count*dim floats, "NRMS" count floats (row norms),
+//     "ROWS" count*kRowColumns int32 (chunk id, page, chunk, then file/model/provider as
+//            indexes into STRS),
+//     "STRS" n(uint32) + (n+1) uint32 offsets + UTF-8 blob of deduplicated strings,
+//     "SPAN" (optional) count*3 int32: start offset into the text of the row's page, end page
+//            and end offset (exclusive) of the chunk, which may run onto later pages.
+//   Row metadata lookups (page(), chunk(), string()) are O(1) with no JSON on the query path.
+//   convertLegacy() builds a container from an existing trio.
+//
+// Loading modes:
+// - load(): copies the vectors into the owned buffer.
+// - loadMapped(): maps the VEC1/VEC2 file read-only and serves topK() straight from the
+//   mapped float block (zero-copy). Falls back to load() when mapping is unavailable.
+// - loadContainer(): maps a GIDX container (or reads it whole when mapping is unavailable).
 class VectorIndex {
 public:
     enum class Metric { Cosine, Dot, L2 };
-    void setVectors(const QList<QVector<float>>& vecs) { vecs_ = vecs; }
+    // Maps the emb/similarity_metric setting ("cosine", "dot", "l2") to Metric
+    static Metric metricFromString(const QString& s) {
+        if (s == QLatin1String("dot")) return Metric::Dot;
+        if (s == QLatin1String("l2")) return Metric::L2;
+        return Metric::Cosine;
+    }
+
+    // Non-owning view of one stored row (valid while the index is alive and unchanged)
+    struct RowView {
+        const float* data {nullptr};
+        int dim {0};
+        float operator[](int j) const { return data[j]; }
+        const float* begin() const { return data; }
+        const float* end() const { return data + dim; }
+        QVector<float> toVector() const { return QVector<float>(data, data + dim); }
+    };
+
+    VectorIndex() = default;
+    ~VectorIndex();
+    VectorIndex(const VectorIndex&) = delete;
+    VectorIndex& operator=(const VectorIndex&) = delete;
+
+    // Copies rows into the contiguous buffer (all rows must share the first row's dim)
+    void setVectors(const QList<QVector<float>>& vecs);
     void setIds(const QStringList& ids) { ids_ = ids; }
 
-    const QList<QVector<float>>& vectors() const { return vecs_; }
+    // Row-level API over the contiguous block
+    void clear();
+    void reserve(int rows, int dim);
+    // Appends one row; the first row fixes dim(). Returns false on dimension mismatch.
+    bool appendRow(const float* v, int dim);
+    bool appendRow(const QVector<float>& v) { return appendRow(v.constData(), int(v.size())); }
+    RowView row(int i) const { return RowView{ rowData(i), dim_ }; }
+    // L2 norm of row i (stored in the file or computed at load/append time)
+    float norm(int i) const { return norms_ ? norms_[i] : 0.0f; }
+    const float* data() const { return data_; } // count() * dim() floats, row-major
+
     const QStringList& ids() const { return ids_; }
 
+    // Row table (containers only). Columns of the ROWS section:
+    enum RowColumn { ColId = 0, ColPage, ColChunk, ColFile, ColModel, ColProvider, kRowColumns };
+    bool hasRowTable() const { return rows_ != nullptr; }
+    int rowValue(int i, RowColumn c) const { return rows_ ? rows_[qint64(i) * kRowColumns + c] : -1; }
+    int chunkId(int i) const { return rowValue(i, ColId); }
+    int page(int i) const { return rowValue(i, ColPage); }   // 1-based
+    int chunk(int i) const { return rowValue(i, ColChunk); } // index within the page
+    // Chunk extent (containers with a SPAN section; -1 otherwise). Offsets are character
+    // positions in the extracted text of page(i) and endPage(i).
+    bool hasSpans() const { return spans_ != nullptr; }
+    int startOffset(int i) const { return spans_ ? spans_[qint64(i) * kSpanColumns] : -1; }
+    int endPage(int i) const { return spans_ ? spans_[qint64(i) * kSpanColumns + 1] : -1; }
+    int endOffset(int i) const { return spans_ ? spans_[qint64(i) * kSpanColumns + 2] : -1; }
+    // Entry of the container string table (file/model/provider columns index into it)
+    QString string(int idx) const;
+
+    int count() const { return count_; }
+    int dim() const { return dim_; }
+    bool isEmpty() const { return count_ == 0; }
+    bool isMapped() const { return mapBase_ != nullptr; }
+    // True when rows live in a read-only file image (mapped, or a container read whole)
+    bool isReadOnlyView() const { return mapBase_ != nullptr || !containerBytes_.isEmpty(); }
+    // True when the loaded file was a legacy VEC1 (norms had to be computed on load)
+    bool isLegacyFormat() const { return legacy_; }
+    // Content hash of the rows: count, dim, norms, row table and the leading components of each
+    // row. Files derived from the index (.hnsw, .q8) record it to detect that it was rebuilt.
+    quint64 fingerprint() const;
+
     // Save vectors to a binary file and ids to JSON for simplicity
-    bool save(const QString& binPath, const QString& idsJsonPath, QString* err = nullptr) const {
-        QFile fb(binPath);
-        if (!fb.open(QIODevice::WriteOnly)) { if (err) *err = QObject::tr("Falha ao salvar binário de vetores"); return false; }
-        // header: magic, count, dim
-        if (vecs_.isEmpty()) { fb.close(); return true; }
-        const int count = vecs_.size();
-        const int dim = vecs_.first().size();
-        fb.write("VEC1", 4);
-        fb.write(reinterpret_cast<const char*>(&count), sizeof(int));
-        fb.write(reinterpret_cast<const char*>(&dim), sizeof(int));
-        for (const auto& v : vecs_) {
-            fb.write(reinterpret_cast<const char*>(v.data()), sizeof(float)*dim);
-        }
-        fb.close();
-
-        // ids
-        QJsonArray arr; for (const auto& id : ids_) arr.append(id);
-        QFile fj(idsJsonPath); if (!fj.open(QIODevice::WriteOnly)) { if (err) *err = QObject::tr("Falha ao salvar JSON de ids"); return false; }
-        fj.write(QJsonDocument(arr).toJson(QJsonDocument::Compact)); fj.close();
-        return true;
-    }
+    bool save(const QString& binPath, const QString& idsJsonPath, QString* err = nullptr) const;
 
-    bool load(const QString& binPath, const QString& idsJsonPath, QString* err = nullptr) {
-        vecs_.clear(); ids_.clear();
-        QFile fb(binPath);
-        if (!fb.open(QIODevice::ReadOnly)) { if (err) *err = QObject::tr("Falha ao abrir binário de vetores"); return false; }
-        char magic[4]; fb.read(magic, 4);
-        int count=0, dim=0; fb.read(reinterpret_cast<char*>(&count), sizeof(int)); fb.read(reinterpret_cast<char*>(&dim), sizeof(int));
-        if (strncmp(magic, "VEC1", 4) != 0 || count < 0 || dim <= 0) { if (err) *err = QObject::tr("Arquivo de vetores inválido"); fb.close(); return false; }
-        vecs_.reserve(count);
-        for (int i=0;i<count;++i){ QVector<float> v; v.resize(dim); fb.read(reinterpret_cast<char*>(v.data()), sizeof(float)*dim); vecs_.append(v);} fb.close();
-        QFile fj(idsJsonPath); if (!fj.open(QIODevice::ReadOnly)) { if (err) *err = QObject::tr("Falha ao abrir JSON de ids"); return false; }
-        const QJsonDocument doc = QJsonDocument::fromJson(fj.readAll()); fj.close();
-        for (const auto& x : doc.array()) ids_.append(x.toString());
-        return ids_.size() == vecs_.size();
-    }
+    bool load(const QString& binPath, const QString& idsJsonPath, QString* err = nullptr);
+
+    // Read-only zero-copy load: maps binPath and validates the VEC1/VEC2 header against the file size.
+    // When the platform/file system cannot map the file, transparently uses load().
+    bool loadMapped(const QString& binPath, const QString& idsJsonPath, QString* err = nullptr);
+
+    // Maps a GIDX container: vectors, norms and the row table are served from the mapping.
+    // ids() stays empty; use chunkId().
+    bool loadContainer(const QString& path, QString* err = nullptr);
+
+    // Builds a container from the legacy .bin (VEC1/VEC2) + .ids.json + .meta.json trio.
+    static bool convertLegacy(const QString& binPath, const QString& idsJsonPath, const QString& metaJsonPath,
+                              const QString& containerPath, QString* err = nullptr);
+
+    // Migration: rewrites a legacy VEC1 file as VEC2 (with stored norms) atomically.
+    // Returns true when the file is already VEC2 or was upgraded; *upgraded tells which.
+    static bool upgradeFile(const QString& binPath, bool* upgraded = nullptr, QString* err = nullptr);
+
+    // Streaming VEC2 writer used by the indexer: rows are appended as they are produced,
+    // their norms are accumulated and written as a trailer, and the header (count/dim/flags)
+    // is patched on finish().
+    class Writer {
+    public:
+        bool open(const QString& binPath, QString* err = nullptr);
+        bool append(const float* v, int dim, QString* err = nullptr);
+        bool finish(QString* err = nullptr);
+        bool isOpen() const { return file_.isOpen(); }
+        int count() const { return count_; }
+        int dim() const { return dim_; }
+        void close() { file_.close(); }
+    private:
+        QFile file_;
+        qint32 count_ {0};
+        qint32 dim_ {0};
+        QVector<float> norms_;
+    };
+
+    // Streaming GIDX writer: vectors go straight to "<path>.part", norms/row table/strings are
+    // accumulated and written by finish(), which then renames the file over path atomically.
+    class ContainerWriter {
+    public:
+        // startOffset < 0: no span recorded for the row
+        struct RowMeta {
+            int id {0}; int page {0}; int chunk {0}; QString file; QString model; QString provider;
+            int startOffset {-1}; int endPage {0}; int endOffset {0};
+        };
+        bool open(const QString& path, QString* err = nullptr);
+        bool append(const float* v, int dim, const RowMeta& meta, QString* err = nullptr);
+        bool finish(QString* err = nullptr);
+        void abort(); // closes and removes the partial file
+        bool isOpen() const { return file_.isOpen(); }
+        int count() const { return count_; }
+        int dim() const { return dim_; }
+    private:
+        qint32 intern(const QString& s);
+        bool pad(QString* err);
+        QString path_;
+        QFile file_;
+        qint32 count_ {0};
+        qint32 dim_ {0};
+        QVector<float> norms_;
+        QVector<qint32> rows_;
+        QVector<qint32> spans_;
+        bool hasSpans_ {false};
+        QStringList strings_;
+        QHash<QString, qint32> stringIds_;
+    };
 
     struct Hit { int index; float score; };
 
@@ -66,32 +194,81 @@ public:
     }
 
     QList<Hit> topK(const QVector<float>& query, int k, Metric metric) const {
-        QList<Hit> hits;
-        if (vecs_.isEmpty()) return hits;
-        const int dim = vecs_.first().size();
-        auto dot = [&](const QVector<float>& a, const QVector<float>& b){ double s=0; for(int i=0;i<dim;++i) s += double(a[i])*double(b[i]); return s; };
-        auto norm = [&](const QVector<float>& a){ double s=0; for(float v: a) s += double(v)*double(v); return std::sqrt(s); };
-        const double nq = norm(query);
-        for (int i=0;i<vecs_.size();++i){
-            double score = 0.0;
-            if (metric == Metric::Cosine) {
-                const double nv = norm(vecs_[i]);
-                const double d = dot(query, vecs_[i]);
-                score = (nq>0 && nv>0) ? (d/(nq*nv)) : 0.0;
-            } else if (metric == Metric::Dot) {
-                score = dot(query, vecs_[i]);
-            } else { // L2: use negative distance so that higher is better
-                double s=0; for (int j=0;j<dim;++j){ const double dv = double(query[j]) - double(vecs_[i][j]); s += dv*dv; }
-                score = -std::sqrt(s);
-            }
-            hits.append({i, float(score)});
-        }
-        std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b){ return a.score > b.score; });
-        if (k < hits.size()) hits = hits.mid(0, k);
-        return hits;
+        return topK(query, k, metric, -std::numeric_limits<float>::infinity());
     }
 
+    // Thread budget for topK(): 0 = auto (QThread::idealThreadCount()), 1 = single-threaded.
+    // Large indexes are split into contiguous row shards scanned on QThreadPool::globalInstance()
+    // (the calling thread scans the first shard); per-shard heaps are merged by the same
+    // (score desc, index asc) order, so results do not depend on the number of threads.
+    void setSearchThreads(int n) { searchThreads_ = qMax(0, n); }
+    int searchThreads() const { return searchThreads_; }
+
+    // Returns at most k hits ordered by score (desc), ties broken by row index (asc).
+    // Rows scoring below minScore are discarded during the scan (for L2 the score is the
+    // negative distance, so pass -maxDistance). Selection uses a bounded heap of size k:
+    // O(n log k) time and O(k) memory. A query whose size is not dim() returns no hits.
+    QList<Hit> topK(const QVector<float>& query, int k, Metric metric, float minScore) const;
+
 private:
-    QList<QVector<float>> vecs_;
+    static constexpr qint64 kHeaderSizeV1 = 12; // magic + count + dim
+    static constexpr qint64 kHeaderSizeV2 = 16; // magic + count + dim + flags
+    static constexpr quint32 kFlagHasNorms = 0x1;
+    static constexpr size_t kAlignment = 64; // cache line / AVX-512 friendly
+    // Minimum work per shard (floats): below this, thread hand-off costs more than the scan
+    static constexpr qint64 kMinShardFloats = qint64(1) << 18;
+    static constexpr quint32 kContainerVersion = 1;
+    static constexpr qint64 kContainerHeaderSize = 32;
+    static constexpr qint64 kSectionEntrySize = 24;
+    static constexpr int kContainerSections = 5; // VECS, NRMS, ROWS, STRS, SPAN (space reserved)
+    static constexpr int kSpanColumns = 3;
+    static constexpr int kFingerprintComponents = 8; // leading floats of each row hashed by fingerprint()
+    // Parses a GIDX image (mapped or read) and points the index at its sections
+    bool attachContainer(const uchar* p, qint64 size, QString* err);
+    struct Header { int count {0}; int dim {0}; quint32 flags {0}; qint64 size {0}; bool legacy {false}; };
+    // Parses and validates a VEC1/VEC2 header (avail bytes at p) against the file size
+    static bool parseHeader(const char* p, qint64 avail, qint64 fileSize, Header* h, QString* err);
+    static bool loadIds(const QString& idsJsonPath, QStringList* ids, QString* err);
+    // Renames from over to in one step (rename(2) / MoveFileEx with MOVEFILE_REPLACE_EXISTING):
+    // readers see the old file or the new one, never neither
+    static bool replaceFile(const QString& from, const QString& to, QString* err);
+
+    const float* rowData(int i) const { return data_ + qint64(i) * dim_; }
+    // Scans rows [begin, end) keeping the best k hits (above minScore) in a bounded heap
+    void scanRange(const float* q, float nq, int begin, int end, int k, Metric metric, float minScore,
+                   std::vector<Hit>* heap) const;
+    void unmap();
+    void releaseBuffer();
+    bool growTo(int rows);
+    void computeNorms(int from);
+
     QStringList ids_;
+
+    // Active row-major block: points into buf_ (owned) or into the mapped file
+    const float* data_ {nullptr};
+    int count_ {0};
+    int dim_ {0};
+
+    // Owned aligned storage
+    float* buf_ {nullptr};
+    qint64 capacity_ {0}; // in floats
+
+    // Per-row L2 norms: points into ownedNorms_ or into the mapped file trailer
+    const float* norms_ {nullptr};
+    QVector<float> ownedNorms_;
+    bool legacy_ {false};
+
+    // Container row table and string table (point into the mapping or containerBytes_)
+    const qint32* rows_ {nullptr};
+    const qint32* spans_ {nullptr};
+    const quint32* strOffsets_ {nullptr};
+    const char* strBlob_ {nullptr};
+    int strCount_ {0};
+    QByteArray containerBytes_; // container read into memory when mapping is unavailable
+
+    int searchThreads_ {0};
+
+    // Memory-mapped mode
+    std::unique_ptr<QFile> mapFile_;
+    uchar* mapBase_ {nullptr};
 };
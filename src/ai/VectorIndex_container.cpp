@@ -0,0 +1,314 @@
+// GIDX container support for VectorIndex (reader, streaming writer and legacy converter).
+#include "ai/VectorIndex.h"
+#include "ai/VectorKernels.h"
+
+#include <QObject>
+#include <QDebug>
+#include <QtGlobal>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr qint64 kSectionAlign = 64;
+
+struct SectionRef { qint64 offset {-1}; qint64 size {0}; };
+
+inline qint64 alignUp(qint64 v) { return (v + kSectionAlign - 1) / kSectionAlign * kSectionAlign; }
+
+template <typename T> T readAt(const uchar* p, qint64 off) {
+    T v;
+    std::memcpy(&v, p + off, sizeof(T));
+    return v;
+}
+}
+
+QString VectorIndex::string(int idx) const {
+    if (!strOffsets_ || idx < 0 || idx >= strCount_) return QString();
+    const quint32 b = strOffsets_[idx], e = strOffsets_[idx + 1];
+    return QString::fromUtf8(strBlob_ + b, int(e - b));
+}
+
+bool VectorIndex::attachContainer(const uchar* p, qint64 size, QString* err) {
+    auto invalid = [err](const QString& why) {
+        if (err) *err = QObject::tr("Contêiner de índice inválido: %1").arg(why);
+        return false;
+    };
+    if (size < kContainerHeaderSize || std::strncmp(reinterpret_cast<const char*>(p), "GIDX", 4) != 0)
+        return invalid(QObject::tr("cabeçalho"));
+    const quint32 version = readAt<quint32>(p, 4);
+    const qint32 count = readAt<qint32>(p, 8);
+    const qint32 dim = readAt<qint32>(p, 12);
+    const quint32 sections = readAt<quint32>(p, 16);
+    if (version != kContainerVersion) return invalid(QObject::tr("versão %1 não suportada").arg(version));
+    if (count < 0 || dim <= 0 || sections > 64) return invalid(QObject::tr("cabeçalho"));
+    if (kContainerHeaderSize + qint64(sections) * kSectionEntrySize > size) return invalid(QObject::tr("diretório"));
+
+    SectionRef vecs, nrms, rows, strs, spans;
+    for (quint32 s = 0; s < sections; ++s) {
+        const qint64 e = kContainerHeaderSize + qint64(s) * kSectionEntrySize;
+        SectionRef ref{ readAt<qint64>(p, e + 8), readAt<qint64>(p, e + 16) };
+        if (ref.offset < 0 || ref.size < 0 || ref.offset % 4 != 0 || ref.offset > size || ref.size > size - ref.offset)
+            return invalid(QObject::tr("seção fora do arquivo"));
+        const char* tag = reinterpret_cast<const char*>(p + e);
+        if (std::strncmp(tag, "VECS", 4) == 0) vecs = ref;
+        else if (std::strncmp(tag, "NRMS", 4) == 0) nrms = ref;
+        else if (std::strncmp(tag, "ROWS", 4) == 0) rows = ref;
+        else if (std::strncmp(tag, "STRS", 4) == 0) strs = ref;
+        else if (std::strncmp(tag, "SPAN", 4) == 0) spans = ref;
+        // Unknown sections are skipped: newer writers may add optional data
+    }
+    const qint64 fl = qint64(sizeof(float));
+    if (vecs.offset < 0 || vecs.size != qint64(count) * dim * fl) return invalid(QStringLiteral("VECS"));
+    if (nrms.offset < 0 || nrms.size != qint64(count) * fl) return invalid(QStringLiteral("NRMS"));
+    if (rows.offset < 0 || rows.size != qint64(count) * kRowColumns * qint64(sizeof(qint32))) return invalid(QStringLiteral("ROWS"));
+    if (strs.offset < 0 || strs.size < 8) return invalid(QStringLiteral("STRS"));
+    if (spans.offset >= 0 && spans.size != qint64(count) * kSpanColumns * qint64(sizeof(qint32))) return invalid(QStringLiteral("SPAN"));
+    const quint32 nStr = readAt<quint32>(p, strs.offset);
+    const qint64 tableBytes = (qint64(nStr) + 1) * qint64(sizeof(quint32));
+    if (4 + tableBytes > strs.size) return invalid(QStringLiteral("STRS"));
+    const quint32* offsets = reinterpret_cast<const quint32*>(p + strs.offset + 4);
+    const qint64 blobSize = strs.size - 4 - tableBytes;
+    if (offsets[0] != 0 || qint64(offsets[nStr]) != blobSize) return invalid(QStringLiteral("STRS"));
+    for (quint32 i = 0; i < nStr; ++i) if (offsets[i] > offsets[i + 1]) return invalid(QStringLiteral("STRS"));
+    // String references in the row table must resolve
+    const qint32* table = reinterpret_cast<const qint32*>(p + rows.offset);
+    for (qint64 i = 0; i < count; ++i) {
+        const qint32* r = table + i * kRowColumns;
+        for (int c = ColFile; c <= ColProvider; ++c) {
+            if (r[c] < -1 || r[c] >= qint64(nStr)) return invalid(QStringLiteral("ROWS"));
+        }
+    }
+
+    data_ = reinterpret_cast<const float*>(p + vecs.offset);
+    norms_ = reinterpret_cast<const float*>(p + nrms.offset);
+    rows_ = table;
+    spans_ = spans.offset >= 0 ? reinterpret_cast<const qint32*>(p + spans.offset) : nullptr;
+    strOffsets_ = offsets;
+    strBlob_ = reinterpret_cast<const char*>(p + strs.offset + 4 + tableBytes);
+    strCount_ = int(nStr);
+    count_ = count;
+    dim_ = dim;
+    legacy_ = false;
+    return true;
+}
+
+bool VectorIndex::loadContainer(const QString& path, QString* err) {
+    clear();
+    ids_.clear();
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        if (err) *err = QObject::tr("Falha ao abrir índice '%1': %2").arg(path, file->errorString());
+        return false;
+    }
+    const qint64 size = file->size();
+    uchar* base = size > 0 ? file->map(0, size) : nullptr;
+    if (!base) {
+        // mmap unavailable: keep one copy of the whole image and point into it
+        qInfo() << "[VectorIndex] mmap indisponível, lendo contêiner em memória:" << file->errorString();
+        containerBytes_ = file->readAll();
+        file->close();
+        if (containerBytes_.size() != size) {
+            clear();
+            if (err) *err = QObject::tr("Falha ao ler índice '%1'").arg(path);
+            return false;
+        }
+        if (!attachContainer(reinterpret_cast<const uchar*>(containerBytes_.constData()), size, err)) {
+            clear();
+            return false;
+        }
+        return true;
+    }
+    if (!attachContainer(base, size, err)) {
+        file->unmap(base);
+        clear();
+        return false;
+    }
+    mapFile_ = std::move(file);
+    mapBase_ = base;
+    return true;
+}
+
+bool VectorIndex::convertLegacy(const QString& binPath, const QString& idsJsonPath, const QString& metaJsonPath,
+                                const QString& containerPath, QString* err) {
+    VectorIndex legacy;
+    if (!legacy.loadMapped(binPath, idsJsonPath, err)) {
+        if (err && err->isEmpty()) *err = QObject::tr("Quantidade de ids difere da de vetores");
+        return false;
+    }
+    // The only full .meta.json parse left: once, at conversion time
+    QFile fm(metaJsonPath);
+    if (!fm.open(QIODevice::ReadOnly)) {
+        if (err) *err = QObject::tr("Falha ao abrir metadados '%1'").arg(metaJsonPath);
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(fm.readAll());
+    fm.close();
+    const QJsonArray meta = doc.array();
+    if (meta.size() != legacy.count()) {
+        if (err) *err = QObject::tr("Metadados (%1) não correspondem aos vetores (%2)").arg(meta.size()).arg(legacy.count());
+        return false;
+    }
+    ContainerWriter w;
+    if (!w.open(containerPath, err)) return false;
+    const QStringList& ids = legacy.ids();
+    for (int i = 0; i < legacy.count(); ++i) {
+        const QJsonObject o = meta.at(i).toObject();
+        ContainerWriter::RowMeta m;
+        bool ok = false;
+        m.id = ids.value(i).toInt(&ok);
+        if (!ok) m.id = i;
+        m.page = o.value("page").toInt();
+        m.chunk = o.value("chunk").toInt();
+        m.file = o.value("file").toString();
+        m.model = o.value("model").toString();
+        m.provider = o.value("provider").toString();
+        if (!w.append(legacy.row(i).data, legacy.dim(), m, err)) { w.abort(); return false; }
+    }
+    return w.finish(err);
+}
+
+// ---- ContainerWriter ----
+
+bool VectorIndex::ContainerWriter::open(const QString& path, QString* err) {
+    path_ = path;
+    count_ = 0;
+    dim_ = 0;
+    norms_.clear();
+    rows_.clear();
+    spans_.clear();
+    hasSpans_ = false;
+    strings_.clear();
+    stringIds_.clear();
+    file_.setFileName(path + QStringLiteral(".part"));
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (err) *err = QObject::tr("Falha ao abrir índice '%1' para escrita: %2").arg(file_.fileName(), file_.errorString());
+        return false;
+    }
+    // Header + directory are written by finish(); vectors start at the first aligned offset after them
+    const QByteArray zeros(int(alignUp(kContainerHeaderSize + kContainerSections * kSectionEntrySize)), '\0');
+    if (file_.write(zeros) != zeros.size()) {
+        if (err) *err = QObject::tr("Falha ao escrever índice '%1': %2").arg(file_.fileName(), file_.errorString());
+        file_.close();
+        return false;
+    }
+    return true;
+}
+
+qint32 VectorIndex::ContainerWriter::intern(const QString& s) {
+    if (s.isEmpty()) return -1;
+    const auto it = stringIds_.constFind(s);
+    if (it != stringIds_.constEnd()) return it.value();
+    const qint32 id = qint32(strings_.size());
+    strings_.append(s);
+    stringIds_.insert(s, id);
+    return id;
+}
+
+bool VectorIndex::ContainerWriter::append(const float* v, int dim, const RowMeta& meta, QString* err) {
+    if (dim_ == 0) dim_ = dim;
+    if (dim != dim_) {
+        if (err) *err = QObject::tr("Dimensão inconsistente (%1 != %2)").arg(dim).arg(dim_);
+        return false;
+    }
+    const qint64 bytes = qint64(sizeof(float)) * dim;
+    if (file_.write(reinterpret_cast<const char*>(v), bytes) != bytes) {
+        if (err) *err = QObject::tr("Falha ao escrever vetor no índice '%1': %2").arg(file_.fileName(), file_.errorString());
+        return false;
+    }
+    norms_.append(std::sqrt(VectorKernels::squaredNorm(v, dim)));
+    rows_ << meta.id << meta.page << meta.chunk << intern(meta.file) << intern(meta.model) << intern(meta.provider);
+    spans_ << meta.startOffset << meta.endPage << meta.endOffset;
+    hasSpans_ = hasSpans_ || meta.startOffset >= 0;
+    ++count_;
+    return true;
+}
+
+bool VectorIndex::ContainerWriter::pad(QString* err) {
+    const qint64 pos = file_.pos();
+    const qint64 n = alignUp(pos) - pos;
+    if (n == 0) return true;
+    const QByteArray zeros(int(n), '\0');
+    if (file_.write(zeros) == n) return true;
+    if (err) *err = QObject::tr("Falha ao escrever índice '%1': %2").arg(file_.fileName(), file_.errorString());
+    return false;
+}
+
+bool VectorIndex::ContainerWriter::finish(QString* err) {
+    if (!file_.isOpen()) {
+        if (err) *err = QObject::tr("Arquivo de índice '%1' fechou antes da finalização.").arg(file_.fileName());
+        return false;
+    }
+    auto fail = [this, err](const QString& m) {
+        if (err && err->isEmpty()) *err = m;
+        abort();
+        return false;
+    };
+    const QString writeErr = QObject::tr("Falha ao escrever índice '%1'").arg(file_.fileName());
+    struct Entry { const char* tag; qint64 offset; qint64 size; };
+    Entry dir[kContainerSections] = {
+        { "VECS", alignUp(kContainerHeaderSize + kContainerSections * kSectionEntrySize), qint64(count_) * dim_ * qint64(sizeof(float)) },
+        { "NRMS", 0, 0 }, { "ROWS", 0, 0 }, { "STRS", 0, 0 }, { "SPAN", 0, 0 }
+    };
+    // Rows from the legacy converter carry no spans; the section is left out then
+    const int sectionCount = hasSpans_ ? kContainerSections : kContainerSections - 1;
+    auto writeSection = [this, err](Entry* e, const char* data, qint64 bytes) {
+        if (!pad(err)) return false;
+        e->offset = file_.pos();
+        e->size = bytes;
+        return bytes == 0 || file_.write(data, bytes) == bytes;
+    };
+    if (!writeSection(&dir[1], reinterpret_cast<const char*>(norms_.constData()), qint64(norms_.size()) * qint64(sizeof(float))))
+        return fail(writeErr);
+    if (!writeSection(&dir[2], reinterpret_cast<const char*>(rows_.constData()), qint64(rows_.size()) * qint64(sizeof(qint32))))
+        return fail(writeErr);
+    // String table: count, offsets, blob
+    QByteArray strs;
+    QByteArray blob;
+    QVector<quint32> offs;
+    offs.reserve(strings_.size() + 1);
+    for (const QString& s : strings_) { offs.append(quint32(blob.size())); blob.append(s.toUtf8()); }
+    offs.append(quint32(blob.size()));
+    const quint32 n = quint32(strings_.size());
+    strs.append(reinterpret_cast<const char*>(&n), sizeof(n));
+    strs.append(reinterpret_cast<const char*>(offs.constData()), int(offs.size() * sizeof(quint32)));
+    strs.append(blob);
+    if (!writeSection(&dir[3], strs.constData(), strs.size())) return fail(writeErr);
+    if (hasSpans_ && !writeSection(&dir[4], reinterpret_cast<const char*>(spans_.constData()), qint64(spans_.size()) * qint64(sizeof(qint32))))
+        return fail(writeErr);
+
+    // Header and directory
+    const quint32 version = kContainerVersion;
+    const qint32 d = dim_ > 0 ? dim_ : 1; // readers reject dim=0
+    const quint32 sections = quint32(sectionCount);
+    const quint32 flags = 0;
+    QByteArray head;
+    head.append("GIDX", 4);
+    head.append(reinterpret_cast<const char*>(&version), 4);
+    head.append(reinterpret_cast<const char*>(&count_), 4);
+    head.append(reinterpret_cast<const char*>(&d), 4);
+    head.append(reinterpret_cast<const char*>(&sections), 4);
+    head.append(reinterpret_cast<const char*>(&flags), 4);
+    head.append(QByteArray(8, '\0'));
+    for (int s = 0; s < sectionCount; ++s) {
+        const Entry& e = dir[s];
+        const quint32 reserved = 0;
+        head.append(e.tag, 4);
+        head.append(reinterpret_cast<const char*>(&reserved), 4);
+        head.append(reinterpret_cast<const char*>(&e.offset), 8);
+        head.append(reinterpret_cast<const char*>(&e.size), 8);
+    }
+    if (!file_.seek(0) || file_.write(head) != head.size()) return fail(writeErr);
+    const QString partPath = file_.fileName();
+    file_.close();
+    // The previous container stays in place until the new one replaces it
+    if (!replaceFile(partPath, path_, err)) {
+        QFile::remove(partPath);
+        return false;
+    }
+    return true;
+}
+
+void VectorIndex::ContainerWriter::abort() {
+    if (file_.isOpen()) file_.close();
+    if (!file_.fileName().isEmpty()) QFile::remove(file_.fileName());
+}
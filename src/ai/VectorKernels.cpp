@@ -0,0 +1,296 @@
+#include "ai/VectorKernels.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GENAI_VK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace VectorKernels {
+
+// ---- Portable reference (double accumulation, same numerics as the original topK loops) ----
+
+double dotScalar(const float* a, const float* b, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; ++i) s += double(a[i]) * double(b[i]);
+    return s;
+}
+
+double squaredL2Scalar(const float* a, const float* b, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; ++i) { const double d = double(a[i]) - double(b[i]); s += d * d; }
+    return s;
+}
+
+namespace {
+
+float dotPortable(const float* a, const float* b, int n) { return float(dotScalar(a, b, n)); }
+float sqNormPortable(const float* a, int n) { return float(dotScalar(a, a, n)); }
+float sqL2Portable(const float* a, const float* b, int n) { return float(squaredL2Scalar(a, b, n)); }
+
+float dotU8Portable(const float* w, const unsigned char* c, int n) {
+    float s = 0.0f;
+    for (int i = 0; i < n; ++i) s += w[i] * float(c[i]);
+    return s;
+}
+
+float sqL2U8Portable(const float* r, const float* sc, const unsigned char* c, int n) {
+    float s = 0.0f;
+    for (int i = 0; i < n; ++i) { const float d = r[i] - sc[i] * float(c[i]); s += d * d; }
+    return s;
+}
+
+#ifdef GENAI_VK_X86
+
+// ---- SSE2 (4 lanes, 2 accumulators) ----
+
+__attribute__((target("sse2")))
+static inline float hsum128(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+__attribute__((target("sse2")))
+float dotSse2(const float* a, const float* b, int n) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float s = hsum128(_mm_add_ps(acc0, acc1));
+    for (; i < n; ++i) s += a[i] * b[i];
+    return s;
+}
+
+__attribute__((target("sse2")))
+float sqL2Sse2(const float* a, const float* b, int n) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        const __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+    }
+    float s = hsum128(_mm_add_ps(acc0, acc1));
+    for (; i < n; ++i) { const float d = a[i] - b[i]; s += d * d; }
+    return s;
+}
+
+float sqNormSse2(const float* a, int n) { return dotSse2(a, a, n); }
+
+// ---- AVX2 + FMA (8 lanes, 4 accumulators) ----
+
+__attribute__((target("avx2,fma")))
+static inline float hsum256(__m256 v) {
+    const __m128 lo = _mm256_castps256_ps128(v);
+    const __m128 hi = _mm256_extractf128_ps(v, 1);
+    __m128 s = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_movehdup_ps(s);
+    s = _mm_add_ps(s, shuf);
+    shuf = _mm_movehl_ps(shuf, s);
+    s = _mm_add_ss(s, shuf);
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2,fma")))
+float dotAvx2(const float* a, const float* b, int n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),      _mm256_loadu_ps(b + i),      acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),  _mm256_loadu_ps(b + i + 8),  acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    float s = hsum256(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < n; ++i) s += a[i] * b[i];
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+float sqL2Avx2(const float* a, const float* b, int n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i),      _mm256_loadu_ps(b + i));
+        const __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8),  _mm256_loadu_ps(b + i + 8));
+        const __m256 d2 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16));
+        const __m256 d3 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24));
+        acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+        acc2 = _mm256_fmadd_ps(d2, d2, acc2);
+        acc3 = _mm256_fmadd_ps(d3, d3, acc3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        acc0 = _mm256_fmadd_ps(d, d, acc0);
+    }
+    float s = hsum256(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < n; ++i) { const float d = a[i] - b[i]; s += d * d; }
+    return s;
+}
+
+float sqNormAvx2(const float* a, int n) { return dotAvx2(a, a, n); }
+
+// 8 codes -> 8 floats (zero-extend, convert)
+__attribute__((target("avx2,fma")))
+static inline __m256 loadU8x8(const unsigned char* c) {
+    const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(c));
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(b));
+}
+
+__attribute__((target("avx2,fma")))
+float dotU8Avx2(const float* w, const unsigned char* c, int n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i),     loadU8x8(c + i),     acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i + 8), loadU8x8(c + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i), loadU8x8(c + i), acc0);
+    }
+    float s = hsum256(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i) s += w[i] * float(c[i]);
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+float sqL2U8Avx2(const float* r, const float* sc, const unsigned char* c, int n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // d = r - s*c (fnmadd)
+        const __m256 d0 = _mm256_fnmadd_ps(_mm256_loadu_ps(sc + i),     loadU8x8(c + i),     _mm256_loadu_ps(r + i));
+        const __m256 d1 = _mm256_fnmadd_ps(_mm256_loadu_ps(sc + i + 8), loadU8x8(c + i + 8), _mm256_loadu_ps(r + i + 8));
+        acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        const __m256 d = _mm256_fnmadd_ps(_mm256_loadu_ps(sc + i), loadU8x8(c + i), _mm256_loadu_ps(r + i));
+        acc0 = _mm256_fmadd_ps(d, d, acc0);
+    }
+    float s = hsum256(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i) { const float d = r[i] - sc[i] * float(c[i]); s += d * d; }
+    return s;
+}
+
+// ---- AVX-512F (16 lanes, 2 accumulators, masked tail) ----
+
+__attribute__((target("avx512f")))
+static inline float hsum512(__m512 v) {
+    // Spill and add: avoids _mm512_reduce_add_ps, which trips -Wuninitialized in GCC 12 headers
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, v);
+    float s = 0.0f;
+    for (float x : lanes) s += x;
+    return s;
+}
+
+__attribute__((target("avx512f")))
+float dotAvx512(const float* a, const float* b, int n) {
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i),      _mm512_loadu_ps(b + i),      acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+    }
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    }
+    if (i < n) {
+        const __mmask16 m = static_cast<__mmask16>((1u << (n - i)) - 1u);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i), acc1);
+    }
+    return hsum512(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+float sqL2Avx512(const float* a, const float* b, int n) {
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i),      _mm512_loadu_ps(b + i));
+        const __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+        acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+    }
+    for (; i + 16 <= n; i += 16) {
+        const __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        acc0 = _mm512_fmadd_ps(d, d, acc0);
+    }
+    if (i < n) {
+        const __mmask16 m = static_cast<__mmask16>((1u << (n - i)) - 1u);
+        const __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i));
+        acc1 = _mm512_fmadd_ps(d, d, acc1);
+    }
+    return hsum512(_mm512_add_ps(acc0, acc1));
+}
+
+float sqNormAvx512(const float* a, int n) { return dotAvx512(a, a, n); }
+
+#endif // GENAI_VK_X86
+
+struct Dispatch {
+    float (*dot)(const float*, const float*, int);
+    float (*sqNorm)(const float*, int);
+    float (*sqL2)(const float*, const float*, int);
+    float (*dotU8)(const float*, const unsigned char*, int);
+    float (*sqL2U8)(const float*, const float*, const unsigned char*, int);
+    const char* name;
+};
+
+Dispatch resolve() {
+    const Dispatch portable { &dotPortable, &sqNormPortable, &sqL2Portable, &dotU8Portable, &sqL2U8Portable, "scalar" };
+#ifdef GENAI_VK_X86
+    // Optional downgrade for diagnostics: GENAI_SIMD=scalar|sse2|avx2|avx512
+    const char* forced = std::getenv("GENAI_SIMD");
+    auto allowed = [forced](const char* isa) {
+        if (!forced || !*forced) return true;
+        static const char* order[] = { "scalar", "sse2", "avx2", "avx512" };
+        int fi = -1, ii = -1;
+        for (int k = 0; k < 4; ++k) {
+            if (std::strcmp(forced, order[k]) == 0) fi = k;
+            if (std::strcmp(isa, order[k]) == 0) ii = k;
+        }
+        return fi < 0 || ii <= fi;
+    };
+    __builtin_cpu_init();
+    if (allowed("avx512") && __builtin_cpu_supports("avx512f"))
+        return { &dotAvx512, &sqNormAvx512, &sqL2Avx512, &dotU8Avx2, &sqL2U8Avx2, "avx512" }; // AVX-512F implies AVX2+FMA on all shipping CPUs
+    if (allowed("avx2") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return { &dotAvx2, &sqNormAvx2, &sqL2Avx2, &dotU8Avx2, &sqL2U8Avx2, "avx2" };
+    if (allowed("sse2") && __builtin_cpu_supports("sse2"))
+        return { &dotSse2, &sqNormSse2, &sqL2Sse2, &dotU8Portable, &sqL2U8Portable, "sse2" };
+#endif
+    return portable;
+}
+
+const Dispatch& dispatch() {
+    static const Dispatch d = resolve(); // thread-safe one-time init
+    return d;
+}
+
+} // namespace
+
+float dot(const float* a, const float* b, int n) { return dispatch().dot(a, b, n); }
+float squaredNorm(const float* a, int n) { return dispatch().sqNorm(a, n); }
+float squaredL2(const float* a, const float* b, int n) { return dispatch().sqL2(a, b, n); }
+float dotU8(const float* w, const unsigned char* codes, int n) { return dispatch().dotU8(w, codes, n); }
+float squaredL2U8(const float* r, const float* s, const unsigned char* codes, int n) { return dispatch().sqL2U8(r, s, codes, n); }
+const char* activeIsa() { return dispatch().name; }
+
+} // namespace VectorKernels
@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * \file VectorKernels.h
+ * \brief Kernels de similaridade (dot, norma, L2) vetorizados com despacho em tempo de execução.
+ *
+ * Na primeira chamada é escolhida a melhor implementação suportada pela CPU
+ * (AVX-512F, AVX2+FMA, SSE2) e, fora de x86 ou em compiladores sem suporte a
+ * atributos de alvo, uma versão escalar portável.
+ *
+ * Tolerância: as versões SIMD acumulam em \c float com várias faixas paralelas; em relação
+ * ao caminho escalar de referência (acumulação em \c double) o erro absoluto de \c dot()
+ * fica abaixo de \c kRelTolerance × |a|·|b| (e o de \c squaredL2() abaixo de
+ * \c kRelTolerance × (|a|²+|b|²)) para dimensões até 4096. Ou seja, scores de cosseno
+ * diferem no máximo ~1e-4 entre os caminhos.
+ * \ingroup ai
+ */
+
+namespace VectorKernels {
+
+/** \brief Tolerância relativa documentada entre os caminhos SIMD e o escalar em double. */
+constexpr double kRelTolerance = 1e-4;
+
+/** \brief Produto interno de \p a e \p b (\p n elementos). */
+float dot(const float* a, const float* b, int n);
+/** \brief Norma ao quadrado de \p a. */
+float squaredNorm(const float* a, int n);
+/** \brief Distância euclidiana ao quadrado entre \p a e \p b. */
+float squaredL2(const float* a, const float* b, int n);
+
+/**
+ * \brief Nome da implementação ativa ("avx512", "avx2", "sse2" ou "scalar").
+ *
+ * A variável de ambiente \c GENAI_SIMD pode forçar uma implementação menos capaz
+ * (ex.: \c GENAI_SIMD=scalar) para diagnóstico e comparação de resultados.
+ */
+const char* activeIsa();
+
+/**
+ * \brief Produto interno entre pesos \p w e códigos de 8 bits \p codes: Σ w[i]·codes[i].
+ *
+ * Usado pela quantização escalar (int8): com \c w = q ⊙ escala, o produto interno aproximado
+ * é \c dot(q, mínimo) + \c dotU8(w, códigos).
+ */
+float dotU8(const float* w, const unsigned char* codes, int n);
+/** \brief Σ (r[i] − s[i]·codes[i])²: distância L2 ao quadrado entre \p r = q − mínimo e um vetor quantizado. */
+float squaredL2U8(const float* r, const float* s, const unsigned char* codes, int n);
+
+/** \brief Referência escalar (acumulação em double), usada como fallback e para validação. */
+double dotScalar(const float* a, const float* b, int n);
+double squaredL2Scalar(const float* a, const float* b, int n);
+
+} // namespace VectorKernels
@@ -3,6 +3,7 @@
 #include <QVBoxLayout>
 #include <QFormLayout>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QLineEdit>
 #include <QLabel>
 #include <QDialogButtonBox>
@@ -11,6 +12,8 @@
 #include <QStandardPaths>
 #include <QSettings>
 #include <QIntValidator>
+#include <QDoubleValidator>
+#include <QLocale>
 
 namespace {
 // Default DB path: ~/.cache/br.tec.rapport.genai-reader/
@@ -23,7 +26,7 @@ static QString defaultDbPath() {
 EmbeddingSettingsDialog::EmbeddingSettingsDialog(QWidget* parent)
     : QDialog(parent) {
     setWindowTitle(tr("Configurações de Embeddings"));
-    resize(640, 360);
+    resize(640, 480);
 
     auto* root = new QVBoxLayout(this);
 
@@ -37,24 +40,101 @@ EmbeddingSettingsDialog::EmbeddingSettingsDialog(QWidget* parent)
     dbPathEdit_ = new QLineEdit(this);
     chunkSizeEdit_ = new QLineEdit(this);
     chunkOverlapEdit_ = new QLineEdit(this);
+    chunkStrategyCombo_ = new QComboBox(this);
+    chunkUnitCombo_ = new QComboBox(this);
+    chunkSpanPagesCheck_ = new QCheckBox(tr("Chunks podem continuar na página seguinte"), this);
     batchSizeEdit_ = new QLineEdit(this);
+    batchMaxCharsEdit_ = new QLineEdit(this);
+    cacheMaxMbEdit_ = new QLineEdit(this);
     pagesPerStageEdit_ = new QLineEdit(this);
     pauseMsBetweenBatchesEdit_ = new QLineEdit(this);
+    extractWorkersEdit_ = new QLineEdit(this);
+    ocrWorkersEdit_ = new QLineEdit(this);
+    maxInFlightEdit_ = new QLineEdit(this);
     similarityCombo_ = new QComboBox(this);
     topKEdit_ = new QLineEdit(this);
+    searchThreadsEdit_ = new QLineEdit(this);
+    indexTypeCombo_ = new QComboBox(this);
+    hnswMEdit_ = new QLineEdit(this);
+    hnswEfSearchEdit_ = new QLineEdit(this);
+    hnswEfConstructionEdit_ = new QLineEdit(this);
+    sq8RerankEdit_ = new QLineEdit(this);
+    hybridLexicalWeightEdit_ = new QLineEdit(this);
+    hybridVectorWeightEdit_ = new QLineEdit(this);
+    hybridRrfKEdit_ = new QLineEdit(this);
+    rerankProviderCombo_ = new QComboBox(this);
+    rerankBaseUrlEdit_ = new QLineEdit(this);
+    rerankModelEdit_ = new QLineEdit(this);
+    rerankApiKeyEdit_ = new QLineEdit(this);
+    rerankApiKeyEdit_->setEchoMode(QLineEdit::Password);
+    rerankCandidatesEdit_ = new QLineEdit(this);
+    rerankBudgetMsEdit_ = new QLineEdit(this);
     // validators
     chunkSizeEdit_->setValidator(new QIntValidator(1, 20000, chunkSizeEdit_));
     chunkOverlapEdit_->setValidator(new QIntValidator(0, 10000, chunkOverlapEdit_));
     batchSizeEdit_->setValidator(new QIntValidator(1, 512, batchSizeEdit_));
+    batchMaxCharsEdit_->setValidator(new QIntValidator(0, 10000000, batchMaxCharsEdit_));
+    cacheMaxMbEdit_->setValidator(new QIntValidator(0, 100000, cacheMaxMbEdit_));
     pagesPerStageEdit_->setValidator(new QIntValidator(1, 100000, pagesPerStageEdit_));
     pauseMsBetweenBatchesEdit_->setValidator(new QIntValidator(0, 60000, pauseMsBetweenBatchesEdit_));
+    extractWorkersEdit_->setValidator(new QIntValidator(0, 256, extractWorkersEdit_));
+    ocrWorkersEdit_->setValidator(new QIntValidator(0, 256, ocrWorkersEdit_));
+    maxInFlightEdit_->setValidator(new QIntValidator(1, 64, maxInFlightEdit_));
     topKEdit_->setValidator(new QIntValidator(1, 1000, topKEdit_));
+    searchThreadsEdit_->setValidator(new QIntValidator(0, 256, searchThreadsEdit_));
+    hnswMEdit_->setValidator(new QIntValidator(2, 128, hnswMEdit_));
+    hnswEfSearchEdit_->setValidator(new QIntValidator(1, 10000, hnswEfSearchEdit_));
+    hnswEfConstructionEdit_->setValidator(new QIntValidator(4, 10000, hnswEfConstructionEdit_));
+    sq8RerankEdit_->setValidator(new QIntValidator(1, 100, sq8RerankEdit_));
+    // Weights are stored with '.', whatever the UI locale
+    for (QLineEdit* e : {hybridLexicalWeightEdit_, hybridVectorWeightEdit_}) {
+        auto* v = new QDoubleValidator(0.0, 100.0, 3, e);
+        v->setNotation(QDoubleValidator::StandardNotation);
+        v->setLocale(QLocale::c());
+        e->setValidator(v);
+    }
+    hybridRrfKEdit_->setValidator(new QIntValidator(1, 1000, hybridRrfKEdit_));
+    rerankCandidatesEdit_->setValidator(new QIntValidator(2, 500, rerankCandidatesEdit_));
+    rerankBudgetMsEdit_->setValidator(new QIntValidator(50, 60000, rerankBudgetMsEdit_));
     chunkSizeEdit_->setPlaceholderText(tr("ex.: 1000"));
     chunkOverlapEdit_->setPlaceholderText(tr("ex.: 200"));
     batchSizeEdit_->setPlaceholderText(tr("ex.: 16"));
+    batchMaxCharsEdit_->setPlaceholderText(tr("0 = sem limite (apenas a quantidade de chunks)"));
+    cacheMaxMbEdit_->setPlaceholderText(tr("0 = desativado (compartilhado entre documentos e consultas)"));
     pagesPerStageEdit_->setPlaceholderText(tr("ex.: 25 (páginas por etapa)"));
     pauseMsBetweenBatchesEdit_->setPlaceholderText(tr("ex.: 150 (ms entre lotes)"));
+    extractWorkersEdit_->setPlaceholderText(tr("0 = automático (núcleos da CPU)"));
+    ocrWorkersEdit_->setPlaceholderText(tr("0 = automático (núcleos da CPU)"));
+    maxInFlightEdit_->setPlaceholderText(tr("ex.: 4 (reduzido automaticamente se o provedor responder HTTP 429)"));
     topKEdit_->setPlaceholderText(tr("ex.: 5"));
+    searchThreadsEdit_->setPlaceholderText(tr("0 = automático (núcleos da CPU)"));
+    hnswMEdit_->setPlaceholderText(tr("ex.: 16 (mais alto = mais recall e memória)"));
+    hnswEfSearchEdit_->setPlaceholderText(tr("ex.: 64 (mais alto = mais recall, consultas mais lentas)"));
+    hnswEfConstructionEdit_->setPlaceholderText(tr("ex.: 200 (qualidade da construção)"));
+    sq8RerankEdit_->setPlaceholderText(tr("ex.: 4 (candidatos reavaliados em float por resultado)"));
+    hybridLexicalWeightEdit_->setPlaceholderText(tr("ex.: 1.0 (0 = ignora a busca textual)"));
+    hybridVectorWeightEdit_->setPlaceholderText(tr("ex.: 1.0 (0 = ignora a busca semântica)"));
+    hybridRrfKEdit_->setPlaceholderText(tr("ex.: 60 (mais alto = ranking mais uniforme entre as listas)"));
+    rerankBaseUrlEdit_->setPlaceholderText(tr("ex.: http://localhost:8081/v1 (o caminho /rerank é acrescentado)"));
+    rerankModelEdit_->setPlaceholderText(tr("ex.: BAAI/bge-reranker-v2-m3"));
+    rerankCandidatesEdit_->setPlaceholderText(tr("ex.: 50 (trechos enviados ao reranker)"));
+    rerankBudgetMsEdit_->setPlaceholderText(tr("ex.: 1500 (acima disso, mantém a ordem da busca híbrida)"));
+
+    // Chunking: sentence/paragraph aware or the original fixed windows
+    chunkStrategyCombo_->addItem(tr("Estrutural (parágrafos, títulos e frases)"), QStringLiteral("structure"));
+    chunkStrategyCombo_->addItem(tr("Janela fixa de caracteres"), QStringLiteral("fixed"));
+    chunkUnitCombo_->addItem(tr("Caracteres"), QStringLiteral("chars"));
+    chunkUnitCombo_->addItem(tr("Tokens (estimados)"), QStringLiteral("tokens"));
+
+    // Search structure: exact scan or approximate HNSW graph
+    indexTypeCombo_->addItem(tr("Exato (varredura linear)"), QStringLiteral("flat"));
+    indexTypeCombo_->addItem(tr("Quantizado int8 + reranqueamento exato"), QStringLiteral("sq8"));
+    indexTypeCombo_->addItem(tr("Aproximado (HNSW)"), QStringLiteral("hnsw"));
+
+    // Reranker: off, Cohere-style /rerank (Cohere, Jina, vLLM, Infinity, llama.cpp) or TEI
+    rerankProviderCombo_->addItem(tr("Desativado"), QStringLiteral("none"));
+    rerankProviderCombo_->addItem(tr("API /rerank (Cohere, Jina, vLLM, llama.cpp)"), QStringLiteral("rerank"));
+    rerankProviderCombo_->addItem(tr("Text Embeddings Inference (TEI)"), QStringLiteral("tei"));
 
     // Similarity metric options
     similarityCombo_->addItem(tr("Cosseno"), QStringLiteral("cosine"));
@@ -68,13 +148,36 @@ EmbeddingSettingsDialog::EmbeddingSettingsDialog(QWidget* parent)
     form->addRow(tr("Base URL"), baseUrlEdit_);
     form->addRow(tr("API Key"), apiKeyEdit_);
     form->addRow(tr("Banco (ChromaDB)"), dbPathEdit_);
+    form->addRow(tr("Divisão em chunks"), chunkStrategyCombo_);
+    form->addRow(tr("Unidade do tamanho"), chunkUnitCombo_);
+    form->addRow(QString(), chunkSpanPagesCheck_);
     form->addRow(tr("Tamanho do chunk"), chunkSizeEdit_);
     form->addRow(tr("Sobreposição do chunk"), chunkOverlapEdit_);
     form->addRow(tr("Tamanho do lote (batch)"), batchSizeEdit_);
+    form->addRow(tr("Máx. caracteres por lote"), batchMaxCharsEdit_);
+    form->addRow(tr("Cache de embeddings (MB)"), cacheMaxMbEdit_);
     form->addRow(tr("Páginas por etapa"), pagesPerStageEdit_);
     form->addRow(tr("Pausa entre lotes (ms)"), pauseMsBetweenBatchesEdit_);
+    form->addRow(tr("Threads da extração de texto"), extractWorkersEdit_);
+    form->addRow(tr("Threads de OCR (páginas digitalizadas)"), ocrWorkersEdit_);
+    form->addRow(tr("Requisições de embeddings simultâneas"), maxInFlightEdit_);
     form->addRow(tr("Métrica de similaridade"), similarityCombo_);
     form->addRow(tr("Top-K (resultados)"), topKEdit_);
+    form->addRow(tr("Threads da busca"), searchThreadsEdit_);
+    form->addRow(tr("Tipo de índice"), indexTypeCombo_);
+    form->addRow(tr("HNSW: vizinhos por nó (M)"), hnswMEdit_);
+    form->addRow(tr("HNSW: efSearch"), hnswEfSearchEdit_);
+    form->addRow(tr("HNSW: efConstruction"), hnswEfConstructionEdit_);
+    form->addRow(tr("int8: fator de reranqueamento"), sq8RerankEdit_);
+    form->addRow(tr("Busca híbrida: peso textual"), hybridLexicalWeightEdit_);
+    form->addRow(tr("Busca híbrida: peso semântico"), hybridVectorWeightEdit_);
+    form->addRow(tr("Busca híbrida: constante k da fusão (RRF)"), hybridRrfKEdit_);
+    form->addRow(tr("Reranker (RAG)"), rerankProviderCombo_);
+    form->addRow(tr("Reranker: Base URL"), rerankBaseUrlEdit_);
+    form->addRow(tr("Reranker: modelo"), rerankModelEdit_);
+    form->addRow(tr("Reranker: API Key"), rerankApiKeyEdit_);
+    form->addRow(tr("Reranker: candidatos"), rerankCandidatesEdit_);
+    form->addRow(tr("Reranker: tempo máximo (ms)"), rerankBudgetMsEdit_);
 
     root->addLayout(form);
 
@@ -96,6 +199,9 @@ EmbeddingSettingsDialog::EmbeddingSettingsDialog(QWidget* parent)
     connect(buttons_, &QDialogButtonBox::rejected, this, &EmbeddingSettingsDialog::reject);
     connect(providerCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &EmbeddingSettingsDialog::onProviderChanged);
     connect(btnRebuild_, &QPushButton::clicked, this, &EmbeddingSettingsDialog::onRebuildClicked);
+    connect(indexTypeCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &EmbeddingSettingsDialog::onIndexTypeChanged);
+    connect(chunkStrategyCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &EmbeddingSettingsDialog::onChunkStrategyChanged);
+    connect(rerankProviderCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &EmbeddingSettingsDialog::onRerankProviderChanged);
 
     loadFromSettings();
 }
@@ -157,6 +263,32 @@ void EmbeddingSettingsDialog::onProviderChanged(int) {
     }
 }
 
+void EmbeddingSettingsDialog::onIndexTypeChanged(int) {
+    const bool hnsw = indexTypeCombo_->currentData().toString() == QLatin1String("hnsw");
+    hnswMEdit_->setEnabled(hnsw);
+    hnswEfSearchEdit_->setEnabled(hnsw);
+    hnswEfConstructionEdit_->setEnabled(hnsw);
+    sq8RerankEdit_->setEnabled(indexTypeCombo_->currentData().toString() == QLatin1String("sq8"));
+}
+
+void EmbeddingSettingsDialog::onChunkStrategyChanged(int) {
+    // The fixed windows are always in characters and never cross a page
+    const bool structure = chunkStrategyCombo_->currentData().toString() == QLatin1String("structure");
+    chunkUnitCombo_->setEnabled(structure);
+    chunkSpanPagesCheck_->setEnabled(structure);
+}
+
+void EmbeddingSettingsDialog::onRerankProviderChanged(int) {
+    const QString provider = rerankProviderCombo_->currentData().toString();
+    const bool enabled = provider != QLatin1String("none");
+    rerankBaseUrlEdit_->setEnabled(enabled);
+    rerankApiKeyEdit_->setEnabled(enabled);
+    rerankCandidatesEdit_->setEnabled(enabled);
+    rerankBudgetMsEdit_->setEnabled(enabled);
+    // TEI serves a single model, chosen when the server starts
+    rerankModelEdit_->setEnabled(provider == QLatin1String("rerank"));
+}
+
 void EmbeddingSettingsDialog::loadFromSettings() {
     QSettings s;
     const QString provider = s.value("emb/provider", "generativa").toString();
@@ -166,11 +298,34 @@ void EmbeddingSettingsDialog::loadFromSettings() {
     const QString dbPath = s.value("emb/db_path", defaultDbPath()).toString();
     const int chunkSize = s.value("emb/chunk_size", 1000).toInt();
     const int chunkOverlap = s.value("emb/chunk_overlap", 200).toInt();
+    const QString chunkStrategy = s.value("emb/chunk_strategy", "structure").toString();
+    const QString chunkUnit = s.value("emb/chunk_unit", "chars").toString();
+    const bool chunkSpanPages = s.value("emb/chunk_span_pages", true).toBool();
     const int batchSize = s.value("emb/batch_size", 16).toInt();
+    const int batchMaxChars = s.value("emb/batch_max_chars", 0).toInt();
+    const int cacheMaxMb = s.value("emb/cache_max_mb", 512).toInt();
     const int pagesPerStage = s.value("emb/pages_per_stage", -1).toInt();
     const int pauseMsBetweenBatches = s.value("emb/pause_ms_between_batches", 0).toInt();
+    const int extractWorkers = s.value("emb/extract_workers", 0).toInt();
+    const int ocrWorkers = s.value("emb/ocr_workers", 0).toInt();
+    const int maxInFlight = s.value("emb/max_inflight", 4).toInt();
     const QString similarity = s.value("emb/similarity_metric", "cosine").toString();
     const int topK = s.value("emb/top_k", 5).toInt();
+    const int searchThreads = s.value("emb/search_threads", 0).toInt();
+    const QString indexType = s.value("emb/index_type", "flat").toString();
+    const int hnswM = s.value("emb/hnsw_m", 16).toInt();
+    const int hnswEfSearch = s.value("emb/hnsw_ef_search", 64).toInt();
+    const int hnswEfConstruction = s.value("emb/hnsw_ef_construction", 200).toInt();
+    const int sq8Rerank = s.value("emb/sq8_rerank_factor", 4).toInt();
+    const double hybridLexicalWeight = s.value("emb/hybrid_lexical_weight", 1.0).toDouble();
+    const double hybridVectorWeight = s.value("emb/hybrid_vector_weight", 1.0).toDouble();
+    const int hybridRrfK = s.value("emb/hybrid_rrf_k", 60).toInt();
+    const QString rerankProvider = s.value("emb/rerank_provider", "none").toString();
+    const QString rerankBaseUrl = s.value("emb/rerank_base_url").toString();
+    const QString rerankModel = s.value("emb/rerank_model").toString();
+    const QString rerankApiKey = s.value("emb/rerank_api_key").toString();
+    const int rerankCandidates = s.value("emb/rerank_candidates", 50).toInt();
+    const int rerankBudgetMs = s.value("emb/rerank_budget_ms", 1500).toInt();
 
     int pidx = providerCombo_->findData(provider);
     if (pidx < 0) pidx = 0;
@@ -186,13 +341,47 @@ void EmbeddingSettingsDialog::loadFromSettings() {
     dbPathEdit_->setText(dbPath);
     chunkSizeEdit_->setText(QString::number(chunkSize));
     chunkOverlapEdit_->setText(QString::number(chunkOverlap));
+    int cidx = chunkStrategyCombo_->findData(chunkStrategy);
+    if (cidx < 0) cidx = 0;
+    chunkStrategyCombo_->setCurrentIndex(cidx);
+    int uidx = chunkUnitCombo_->findData(chunkUnit);
+    if (uidx < 0) uidx = 0;
+    chunkUnitCombo_->setCurrentIndex(uidx);
+    chunkSpanPagesCheck_->setChecked(chunkSpanPages);
+    onChunkStrategyChanged(cidx);
     batchSizeEdit_->setText(QString::number(batchSize));
+    batchMaxCharsEdit_->setText(QString::number(qMax(0, batchMaxChars)));
+    cacheMaxMbEdit_->setText(QString::number(qMax(0, cacheMaxMb)));
     if (pagesPerStage > 0) pagesPerStageEdit_->setText(QString::number(pagesPerStage)); else pagesPerStageEdit_->clear();
     pauseMsBetweenBatchesEdit_->setText(QString::number(pauseMsBetweenBatches));
+    extractWorkersEdit_->setText(QString::number(qMax(0, extractWorkers)));
+    ocrWorkersEdit_->setText(QString::number(qMax(0, ocrWorkers)));
+    maxInFlightEdit_->setText(QString::number(qMax(1, maxInFlight)));
     int sidx = similarityCombo_->findData(similarity);
     if (sidx < 0) sidx = 0;
     similarityCombo_->setCurrentIndex(sidx);
     topKEdit_->setText(QString::number(qMax(1, topK)));
+    searchThreadsEdit_->setText(QString::number(qMax(0, searchThreads)));
+    int tidx = indexTypeCombo_->findData(indexType);
+    if (tidx < 0) tidx = 0;
+    indexTypeCombo_->setCurrentIndex(tidx);
+    hnswMEdit_->setText(QString::number(hnswM));
+    hnswEfSearchEdit_->setText(QString::number(hnswEfSearch));
+    hnswEfConstructionEdit_->setText(QString::number(hnswEfConstruction));
+    sq8RerankEdit_->setText(QString::number(sq8Rerank));
+    hybridLexicalWeightEdit_->setText(QString::number(qMax(0.0, hybridLexicalWeight)));
+    hybridVectorWeightEdit_->setText(QString::number(qMax(0.0, hybridVectorWeight)));
+    hybridRrfKEdit_->setText(QString::number(qMax(1, hybridRrfK)));
+    int ridx = rerankProviderCombo_->findData(rerankProvider);
+    if (ridx < 0) ridx = 0;
+    rerankProviderCombo_->setCurrentIndex(ridx);
+    rerankBaseUrlEdit_->setText(rerankBaseUrl);
+    rerankModelEdit_->setText(rerankModel);
+    rerankApiKeyEdit_->setText(rerankApiKey);
+    rerankCandidatesEdit_->setText(QString::number(qMax(2, rerankCandidates)));
+    rerankBudgetMsEdit_->setText(QString::number(qMax(50, rerankBudgetMs)));
+    onRerankProviderChanged(ridx);
+    onIndexTypeChanged(tidx);
 }
 
 void EmbeddingSettingsDialog::saveToSettings() {
@@ -208,15 +397,56 @@ void EmbeddingSettingsDialog::saveToSettings() {
     const int batchSize = batchSizeEdit_->text().toInt(&ok3);
     s.setValue("emb/chunk_size", ok1 && chunkSize>0 ? chunkSize : 1000);
     s.setValue("emb/chunk_overlap", ok2 && chunkOverlap>=0 ? chunkOverlap : 200);
+    s.setValue("emb/chunk_strategy", chunkStrategyCombo_->currentData().toString());
+    s.setValue("emb/chunk_unit", chunkUnitCombo_->currentData().toString());
+    s.setValue("emb/chunk_span_pages", chunkSpanPagesCheck_->isChecked());
     s.setValue("emb/batch_size", ok3 && batchSize>0 ? batchSize : 16);
+    bool ok14=false; const int batchMaxChars = batchMaxCharsEdit_->text().toInt(&ok14);
+    s.setValue("emb/batch_max_chars", ok14 && batchMaxChars>=0 ? batchMaxChars : 0);
+    bool ok15=false; const int cacheMaxMb = cacheMaxMbEdit_->text().toInt(&ok15);
+    s.setValue("emb/cache_max_mb", ok15 && cacheMaxMb>=0 ? cacheMaxMb : 512);
     bool ok4=false, ok5=false;
     const int pagesPerStage = pagesPerStageEdit_->text().toInt(&ok4);
     const int pauseMsBetweenBatches = pauseMsBetweenBatchesEdit_->text().toInt(&ok5);
     s.setValue("emb/pages_per_stage", ok4 && pagesPerStage>0 ? pagesPerStage : -1);
     s.setValue("emb/pause_ms_between_batches", ok5 && pauseMsBetweenBatches>=0 ? pauseMsBetweenBatches : 0);
+    bool ok12=false; const int extractWorkers = extractWorkersEdit_->text().toInt(&ok12);
+    s.setValue("emb/extract_workers", ok12 && extractWorkers>=0 ? extractWorkers : 0);
+    bool ok16=false; const int ocrWorkers = ocrWorkersEdit_->text().toInt(&ok16);
+    s.setValue("emb/ocr_workers", ok16 && ocrWorkers>=0 ? ocrWorkers : 0);
+    bool ok13=false; const int maxInFlight = maxInFlightEdit_->text().toInt(&ok13);
+    s.setValue("emb/max_inflight", ok13 && maxInFlight>0 ? maxInFlight : 4);
     s.setValue("emb/similarity_metric", similarityCombo_->currentData().toString());
     bool ok6=false; const int topK = topKEdit_->text().toInt(&ok6);
     s.setValue("emb/top_k", ok6 && topK>0 ? topK : 5);
+    bool ok7=false; const int searchThreads = searchThreadsEdit_->text().toInt(&ok7);
+    s.setValue("emb/search_threads", ok7 && searchThreads>=0 ? searchThreads : 0);
+    s.setValue("emb/index_type", indexTypeCombo_->currentData().toString());
+    bool ok8=false, ok9=false, ok10=false;
+    const int hnswM = hnswMEdit_->text().toInt(&ok8);
+    const int hnswEfSearch = hnswEfSearchEdit_->text().toInt(&ok9);
+    const int hnswEfConstruction = hnswEfConstructionEdit_->text().toInt(&ok10);
+    s.setValue("emb/hnsw_m", ok8 && hnswM>=2 ? hnswM : 16);
+    s.setValue("emb/hnsw_ef_search", ok9 && hnswEfSearch>0 ? hnswEfSearch : 64);
+    s.setValue("emb/hnsw_ef_construction", ok10 && hnswEfConstruction>0 ? hnswEfConstruction : 200);
+    bool ok11=false; const int sq8Rerank = sq8RerankEdit_->text().toInt(&ok11);
+    s.setValue("emb/sq8_rerank_factor", ok11 && sq8Rerank>0 ? sq8Rerank : 4);
+    bool ok17=false, ok18=false, ok19=false;
+    const double hybridLexicalWeight = hybridLexicalWeightEdit_->text().toDouble(&ok17);
+    const double hybridVectorWeight = hybridVectorWeightEdit_->text().toDouble(&ok18);
+    const int hybridRrfK = hybridRrfKEdit_->text().toInt(&ok19);
+    s.setValue("emb/hybrid_lexical_weight", ok17 && hybridLexicalWeight>=0 ? hybridLexicalWeight : 1.0);
+    s.setValue("emb/hybrid_vector_weight", ok18 && hybridVectorWeight>=0 ? hybridVectorWeight : 1.0);
+    s.setValue("emb/hybrid_rrf_k", ok19 && hybridRrfK>0 ? hybridRrfK : 60);
+    s.setValue("emb/rerank_provider", rerankProviderCombo_->currentData().toString());
+    s.setValue("emb/rerank_base_url", rerankBaseUrlEdit_->text().trimmed());
+    s.setValue("emb/rerank_model", rerankModelEdit_->text().trimmed());
+    s.setValue("emb/rerank_api_key", rerankApiKeyEdit_->text());
+    bool ok20=false, ok21=false;
+    const int rerankCandidates = rerankCandidatesEdit_->text().toInt(&ok20);
+    const int rerankBudgetMs = rerankBudgetMsEdit_->text().toInt(&ok21);
+    s.setValue("emb/rerank_candidates", ok20 && rerankCandidates>=2 ? rerankCandidates : 50);
+    s.setValue("emb/rerank_budget_ms", ok21 && rerankBudgetMs>0 ? rerankBudgetMs : 1500);
 }
 
 void EmbeddingSettingsDialog::onRebuildClicked() {
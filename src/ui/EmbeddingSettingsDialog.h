@@ -3,6 +3,7 @@
 #include <QDialog>
 #include <QString>
 
+class QCheckBox;
 class QComboBox;
 class QLineEdit;
 class QLabel;
@@ -19,6 +20,9 @@ signals:
 
 private slots:
     void onProviderChanged(int index);
+    void onIndexTypeChanged(int index);
+    void onChunkStrategyChanged(int index);
+    void onRerankProviderChanged(int index);
     void onRebuildClicked();
     void accept() override;
 
@@ -35,12 +39,38 @@ private:
     QLineEdit* dbPathEdit_ {nullptr};
     QLineEdit* chunkSizeEdit_ {nullptr};
     QLineEdit* chunkOverlapEdit_ {nullptr};
+    QComboBox* chunkStrategyCombo_ {nullptr};
+    QComboBox* chunkUnitCombo_ {nullptr};
+    QCheckBox* chunkSpanPagesCheck_ {nullptr};
     QLineEdit* batchSizeEdit_ {nullptr};
+    QLineEdit* batchMaxCharsEdit_ {nullptr};
+    QLineEdit* cacheMaxMbEdit_ {nullptr};
     QLineEdit* pagesPerStageEdit_ {nullptr};
     QLineEdit* pauseMsBetweenBatchesEdit_ {nullptr};
+    QLineEdit* extractWorkersEdit_ {nullptr};
+    QLineEdit* ocrWorkersEdit_ {nullptr};
+    QLineEdit* maxInFlightEdit_ {nullptr};
     // Retrieval params
     QComboBox* similarityCombo_ {nullptr};
     QLineEdit* topKEdit_ {nullptr};
+    QLineEdit* searchThreadsEdit_ {nullptr};
+    // Approximate index (HNSW)
+    QComboBox* indexTypeCombo_ {nullptr};
+    QLineEdit* hnswMEdit_ {nullptr};
+    QLineEdit* hnswEfSearchEdit_ {nullptr};
+    QLineEdit* hnswEfConstructionEdit_ {nullptr};
+    QLineEdit* sq8RerankEdit_ {nullptr};
+    // Hybrid search (reciprocal-rank fusion)
+    QLineEdit* hybridLexicalWeightEdit_ {nullptr};
+    QLineEdit* hybridVectorWeightEdit_ {nullptr};
+    QLineEdit* hybridRrfKEdit_ {nullptr};
+    // Reranker (second stage of the RAG retrieval)
+    QComboBox* rerankProviderCombo_ {nullptr};
+    QLineEdit* rerankBaseUrlEdit_ {nullptr};
+    QLineEdit* rerankModelEdit_ {nullptr};
+    QLineEdit* rerankApiKeyEdit_ {nullptr};
+    QLineEdit* rerankCandidatesEdit_ {nullptr};
+    QLineEdit* rerankBudgetMsEdit_ {nullptr};
 
     QLabel* warningLabel_ {nullptr};
     QPushButton* btnRebuild_ {nullptr};
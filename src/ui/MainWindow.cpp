@@ -77,6 +77,7 @@
 #include <QIntValidator>
 #include <algorithm>
 #include <functional>
+#include <utility>
 #include <QModelIndex>
 #include <QVariant>
 #include <QPushButton>
@@ -93,7 +94,12 @@
 #include "app/App.h"
 #include "ai/EmbeddingIndexer.h"
 #include "ai/EmbeddingProvider.h"
+#include "ai/EmbeddingCache.h"
 #include "ai/VectorIndex.h"
+#include "ai/HnswIndex.h"
+#include "ai/QuantizedIndex.h"
+#include "ai/FullTextIndex.h"
+#include "ai/RagContextBuilder.h"
 #include "ui/BookProviders.h"
 #include "ui/OpfMergeDialog.h"
 
@@ -103,8 +109,46 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QSet>
+#include <QDateTime>
 
 namespace {
+// Line of text around [start, end) of a page, the matched text between « »
+QString hitSnippet(const QString& pageText, int start, int end) {
+    constexpr int kContext = 60;
+    if (start < 0 || end < start || end > pageText.size()) return QString();
+    const int from = qMax(0, start - kContext);
+    const int to = qMin(int(pageText.size()), end + kContext);
+    QString line = pageText.mid(from, start - from) + QStringLiteral("«") + pageText.mid(start, end - start)
+                   + QStringLiteral("»") + pageText.mid(end, to - end);
+    line.replace(QRegularExpression("\\s+"), " ");
+    return (from > 0 ? QStringLiteral("…") : QString()) + line.trimmed() + (to < pageText.size() ? QStringLiteral("…") : QString());
+}
+
+// HNSW knobs from settings (emb/hnsw_*); see EmbeddingSettingsDialog
+HnswIndex::Params hnswParamsFromSettings(const QSettings& s) {
+    HnswIndex::Params p;
+    p.M = s.value("emb/hnsw_m", p.M).toInt();
+    p.efConstruction = s.value("emb/hnsw_ef_construction", p.efConstruction).toInt();
+    p.efSearch = s.value("emb/hnsw_ef_search", p.efSearch).toInt();
+    return p;
+}
+
+// Copies the chunking, extraction, batching, request concurrency and ANN index settings into indexer params
+void applyIndexerSettings(const QSettings& s, EmbeddingIndexer::Params* p) {
+    p->chunkStrategy = TextChunker::strategyFromString(s.value("emb/chunk_strategy", "structure").toString());
+    p->chunkUnit = TextChunker::unitFromString(s.value("emb/chunk_unit", "chars").toString());
+    p->chunkSpanPages = s.value("emb/chunk_span_pages", true).toBool();
+    p->batchMaxChars = s.value("emb/batch_max_chars", 0).toInt();
+    p->extractWorkers = s.value("emb/extract_workers", 0).toInt();
+    p->ocrWorkers = s.value("emb/ocr_workers", 0).toInt();
+    p->maxInFlight = s.value("emb/max_inflight", 4).toInt();
+    p->cacheMaxBytes = s.value("emb/cache_max_mb", 512).toLongLong() << 20;
+    p->indexType = s.value("emb/index_type", "flat").toString();
+    p->metric = VectorIndex::metricFromString(s.value("emb/similarity_metric", "cosine").toString());
+    p->hnsw = hnswParamsFromSettings(s);
+    p->sq8RerankFactor = s.value("emb/sq8_rerank_factor", 4).toInt();
+}
+
 // Load recent entries as a list of QVariantMap with keys:
 // path, title, author, publisher, isbn, summary, keywords
 QVariantList loadRecentEntries(QSettings& settings) {
@@ -796,80 +840,82 @@ OpfData MainWindow::buildOpfFromPdfMeta(const QString& absPdfPath) const {
 
 void MainWindow::generateOpfWithLlmAsync(const QString& absPdfPath) {
     if (!llm_) return;
-    // Build initial data from PDF
-    OpfData data = buildOpfFromPdfMeta(absPdfPath);
-
-    // Build context from sampled pages (reuse logic similar to onRequestSummarizeDocument)
-    QString context;
-    if (auto* pv = qobject_cast<PdfViewerWidget*>(viewer_)) {
-        if (pv->document()) {
-            ensurePagesTextLoaded();
-            const int pageCount = pv->document()->pageCount();
-            if (pageCount > 0 && !pagesText_.isEmpty()) {
-                const int targetSamples = 12;
-                const int step = qMax(1, pageCount / targetSamples);
-                int taken = 0;
-                for (int p = 1; p <= pageCount && taken < targetSamples; p += step) {
-                    const int idx = p - 1;
-                    QString snippet;
-                    if (idx >= 0 && idx < pagesText_.size()) {
-                        snippet = pagesText_.at(idx);
-                        snippet.replace(QRegularExpression("\\s+"), " ");
-                        if (snippet.size() > 800) snippet = snippet.left(800);
-                    }
-                    if (!snippet.trimmed().isEmpty()) {
-                        context += tr("[Página %1]\n%2\n\n").arg(p).arg(snippet.trimmed());
-                        ++taken;
+    // The sampled pages come from the search thread, which may still be extracting them
+    whenPagesTextLoaded([this, absPdfPath]() {
+        // Build initial data from PDF
+        OpfData data = buildOpfFromPdfMeta(absPdfPath);
+
+        // Build context from sampled pages (reuse logic similar to onRequestSummarizeDocument)
+        QString context;
+        if (auto* pv = qobject_cast<PdfViewerWidget*>(viewer_)) {
+            if (pv->document()) {
+                const int pageCount = pv->document()->pageCount();
+                if (pageCount > 0 && !pagesText_.isEmpty()) {
+                    const int targetSamples = 12;
+                    const int step = qMax(1, pageCount / targetSamples);
+                    int taken = 0;
+                    for (int p = 1; p <= pageCount && taken < targetSamples; p += step) {
+                        const int idx = p - 1;
+                        QString snippet;
+                        if (idx >= 0 && idx < pagesText_.size()) {
+                            snippet = pagesText_.at(idx);
+                            snippet.replace(QRegularExpression("\\s+"), " ");
+                            if (snippet.size() > 800) snippet = snippet.left(800);
+                        }
+                        if (!snippet.trimmed().isEmpty()) {
+                            context += tr("[Página %1]\n%2\n\n").arg(p).arg(snippet.trimmed());
+                            ++taken;
+                        }
                     }
                 }
             }
         }
-    }
-    if (context.trimmed().isEmpty()) {
-        context = tr("Conteúdo não extraído.");
-    }
+        if (context.trimmed().isEmpty()) {
+            context = tr("Conteúdo não extraído.");
+        }
 
-    // Compose LLM prompt to produce description and summary
-    QList<QPair<QString,QString>> msgs;
-    const QString sys = tr("Você gera metadados de livros (OPF) em pt-BR a partir de trechos.\n"
-                           "Devolva duas seções separadas: \n"
-                           "[DESCRICAO]\n<texto>\n[RESUMO]\n<texto>\n"
-                           "Em 'DESCRICAO' faça um parágrafo corrido de apresentação.\n"
-                           "Em 'RESUMO' faça um resumo executivo com tópicos.");
-    msgs.append({QStringLiteral("system"), sys});
-    QString user = tr("Título: %1\nAutor: %2\nPalavras-chave: %3\n\nTrechos:\n%4")
-                       .arg(data.title.isEmpty()? tr("(desconhecido)") : data.title)
-                       .arg(data.author.isEmpty()? tr("(desconhecido)") : data.author)
-                       .arg(data.keywords)
-                       .arg(context);
-    msgs.append({QStringLiteral("user"), user});
-
-    statusBar()->showMessage(tr("Gerando metadados OPF via IA..."));
-    llm_->chatWithMessages(msgs, [this, absPdfPath, data](QString out, QString err){
-        QMetaObject::invokeMethod(this, [this, absPdfPath, data, out, err]() mutable {
-            if (!err.isEmpty()) { showLongAlert(tr("Erro na IA"), err); statusBar()->clearMessage(); return; }
-            // Parse simple tagged response
-            QString desc, sum;
-            QRegularExpression reDesc("\\[DESCRICAO\\](.*)\\[RESUMO\\]", QRegularExpression::DotMatchesEverythingOption);
-            auto m = reDesc.match(out);
-            if (m.hasMatch()) {
-                desc = m.captured(1).trimmed();
-                sum = out.mid(m.capturedEnd(0)).trimmed();
-            } else {
-                // Fallback: use entire text as description
-                desc = out.trimmed();
-            }
-            if (!desc.isEmpty()) data.description = desc;
-            if (!sum.isEmpty()) data.summary = sum;
+        // Compose LLM prompt to produce description and summary
+        QList<QPair<QString,QString>> msgs;
+        const QString sys = tr("Você gera metadados de livros (OPF) em pt-BR a partir de trechos.\n"
+                               "Devolva duas seções separadas: \n"
+                               "[DESCRICAO]\n<texto>\n[RESUMO]\n<texto>\n"
+                               "Em 'DESCRICAO' faça um parágrafo corrido de apresentação.\n"
+                               "Em 'RESUMO' faça um resumo executivo com tópicos.");
+        msgs.append({QStringLiteral("system"), sys});
+        QString user = tr("Título: %1\nAutor: %2\nPalavras-chave: %3\n\nTrechos:\n%4")
+                           .arg(data.title.isEmpty()? tr("(desconhecido)") : data.title)
+                           .arg(data.author.isEmpty()? tr("(desconhecido)") : data.author)
+                           .arg(data.keywords)
+                           .arg(context);
+        msgs.append({QStringLiteral("user"), user});
 
-            const QString opfPath = OpfStore::defaultOpfPathFor(absPdfPath);
-            QString werr; if (!OpfStore::write(opfPath, data, &werr)) {
-                showLongAlert(tr("Erro ao salvar OPF"), werr);
-            } else {
-                statusBar()->showMessage(tr("OPF criado em %1").arg(opfPath), 4000);
-                reloadOpfDialogFromDiskIfOpen(opfPath);
-            }
-            statusBar()->clearMessage();
+        statusBar()->showMessage(tr("Gerando metadados OPF via IA..."));
+        llm_->chatWithMessages(msgs, [this, absPdfPath, data](QString out, QString err){
+            QMetaObject::invokeMethod(this, [this, absPdfPath, data, out, err]() mutable {
+                if (!err.isEmpty()) { showLongAlert(tr("Erro na IA"), err); statusBar()->clearMessage(); return; }
+                // Parse simple tagged response
+                QString desc, sum;
+                QRegularExpression reDesc("\\[DESCRICAO\\](.*)\\[RESUMO\\]", QRegularExpression::DotMatchesEverythingOption);
+                auto m = reDesc.match(out);
+                if (m.hasMatch()) {
+                    desc = m.captured(1).trimmed();
+                    sum = out.mid(m.capturedEnd(0)).trimmed();
+                } else {
+                    // Fallback: use entire text as description
+                    desc = out.trimmed();
+                }
+                if (!desc.isEmpty()) data.description = desc;
+                if (!sum.isEmpty()) data.summary = sum;
+
+                const QString opfPath = OpfStore::defaultOpfPathFor(absPdfPath);
+                QString werr; if (!OpfStore::write(opfPath, data, &werr)) {
+                    showLongAlert(tr("Erro ao salvar OPF"), werr);
+                } else {
+                    statusBar()->showMessage(tr("OPF criado em %1").arg(opfPath), 4000);
+                    reloadOpfDialogFromDiskIfOpen(opfPath);
+                }
+                statusBar()->clearMessage();
+            });
         });
     });
 }
@@ -968,9 +1014,11 @@ bool MainWindow::migrateEmbeddingsForPathChange(const QString& oldPath, const QS
     if (!computeIndexPathsFor(oldPath, &oldIdx)) { if (errorMsg) *errorMsg = tr("Falha ao calcular índice antigo."); return false; }
     if (!computeIndexPathsFor(newPath, &newIdx)) { if (errorMsg) *errorMsg = tr("Falha ao calcular índice novo."); return false; }
     // If old files don't exist, nothing to do
-    const QStringList oldFiles{ oldIdx.binPath, oldIdx.idsPath, oldIdx.metaPath };
+    const QStringList oldFiles{ oldIdx.containerPath, oldIdx.binPath, oldIdx.idsPath, oldIdx.metaPath, oldIdx.hnswPath, oldIdx.q8Path, oldIdx.chunksPath };
     bool anyExist = std::any_of(oldFiles.begin(), oldFiles.end(), [](const QString& p){ return QFileInfo::exists(p); });
     if (!anyExist) return true;
+    // Unmap before moving the files (required on Windows)
+    invalidateSearchIndex();
     // Ensure target dir exists
     QDir().mkpath(QFileInfo(newIdx.base).absolutePath());
     auto moveFile = [&](const QString& src, const QString& dst)->bool{
@@ -978,9 +1026,13 @@ bool MainWindow::migrateEmbeddingsForPathChange(const QString& oldPath, const QS
         if (QFileInfo::exists(dst)) QFile::remove(dst);
         return QFile::rename(src, dst);
     };
+    if (!moveFile(oldIdx.containerPath, newIdx.containerPath)) { if (errorMsg) *errorMsg = tr("Não foi possível mover %1 para %2").arg(oldIdx.containerPath, newIdx.containerPath); return false; }
     if (!moveFile(oldIdx.binPath, newIdx.binPath)) { if (errorMsg) *errorMsg = tr("Não foi possível mover %1 para %2").arg(oldIdx.binPath, newIdx.binPath); return false; }
     if (!moveFile(oldIdx.idsPath, newIdx.idsPath)) { if (errorMsg) *errorMsg = tr("Não foi possível mover %1 para %2").arg(oldIdx.idsPath, newIdx.idsPath); return false; }
     if (!moveFile(oldIdx.metaPath, newIdx.metaPath)) { if (errorMsg) *errorMsg = tr("Não foi possível mover %1 para %2").arg(oldIdx.metaPath, newIdx.metaPath); return false; }
+    if (!moveFile(oldIdx.hnswPath, newIdx.hnswPath)) { if (errorMsg) *errorMsg = tr("Não foi possível mover %1 para %2").arg(oldIdx.hnswPath, newIdx.hnswPath); return false; }
+    if (!moveFile(oldIdx.q8Path, newIdx.q8Path)) { if (errorMsg) *errorMsg = tr("Não foi possível mover %1 para %2").arg(oldIdx.q8Path, newIdx.q8Path); return false; }
+    if (!moveFile(oldIdx.chunksPath, newIdx.chunksPath)) { if (errorMsg) *errorMsg = tr("Não foi possível mover %1 para %2").arg(oldIdx.chunksPath, newIdx.chunksPath); return false; }
     return true;
 }
 
@@ -1079,7 +1131,7 @@ QString MainWindow::sha1(const QString& s) const {
 
 bool MainWindow::getIndexPaths(IndexPaths* out) const {
     if (!out) return false;
-    out->base.clear(); out->binPath.clear(); out->idsPath.clear(); out->metaPath.clear();
+    out->base.clear(); out->containerPath.clear(); out->binPath.clear(); out->idsPath.clear(); out->metaPath.clear(); out->hnswPath.clear(); out->q8Path.clear(); out->chunksPath.clear();
     if (currentFilePath_.isEmpty()) return false;
     QSettings s;
     const QString dbPath = s.value("emb/db_path", QDir(QDir::home().filePath(".cache")).filePath("br.tec.rapport.genai-reader")).toString();
@@ -1089,15 +1141,20 @@ bool MainWindow::getIndexPaths(IndexPaths* out) const {
     fileBaseName.replace(':', '_');
     fileBaseName.replace('/', '_');
     out->base = QDir(dbPath).filePath(fileBaseName);
-    out->binPath = out->base + ".bin";
+    out->containerPath = out->base + ".gidx";
+    out->binPath = out->base + ".bin"; // legacy trio (.bin/.ids.json/.meta.json), converted on first search
     out->idsPath = out->base + ".ids.json";
     out->metaPath = out->base + ".meta.json";
-    return QFileInfo::exists(out->binPath) && QFileInfo::exists(out->idsPath) && QFileInfo::exists(out->metaPath);
+    out->hnswPath = out->base + ".hnsw"; // optional ANN graph (emb/index_type=hnsw)
+    out->q8Path = out->base + ".q8";     // optional int8 codes (emb/index_type=sq8)
+    out->chunksPath = out->base + ".chunks"; // embedded-chunk journal (resume and incremental re-indexing)
+    return QFileInfo::exists(out->containerPath)
+        || (QFileInfo::exists(out->binPath) && QFileInfo::exists(out->idsPath) && QFileInfo::exists(out->metaPath));
 }
 
 bool MainWindow::computeIndexPathsFor(const QString& filePath, IndexPaths* out) const {
     if (!out) return false;
-    out->base.clear(); out->binPath.clear(); out->idsPath.clear(); out->metaPath.clear();
+    out->base.clear(); out->containerPath.clear(); out->binPath.clear(); out->idsPath.clear(); out->metaPath.clear(); out->hnswPath.clear(); out->q8Path.clear(); out->chunksPath.clear();
     if (filePath.isEmpty()) return false;
     QSettings s;
     const QString dbPath = s.value("emb/db_path", QDir(QDir::home().filePath(".cache")).filePath("br.tec.rapport.genai-reader")).toString();
@@ -1107,118 +1164,62 @@ bool MainWindow::computeIndexPathsFor(const QString& filePath, IndexPaths* out)
     fileBaseName.replace(':', '_');
     fileBaseName.replace('/', '_');
     out->base = QDir(dbPath).filePath(fileBaseName);
-    out->binPath = out->base + ".bin";
+    out->containerPath = out->base + ".gidx";
+    out->binPath = out->base + ".bin"; // legacy trio (.bin/.ids.json/.meta.json), converted on first search
     out->idsPath = out->base + ".ids.json";
     out->metaPath = out->base + ".meta.json";
+    out->hnswPath = out->base + ".hnsw"; // optional ANN graph (emb/index_type=hnsw)
+    out->q8Path = out->base + ".q8";     // optional int8 codes (emb/index_type=sq8)
+    out->chunksPath = out->base + ".chunks"; // embedded-chunk journal (resume and incremental re-indexing)
     return true;
 }
 
-bool MainWindow::ensurePagesTextLoaded() {
-    if (pagesTextLoaded_) return true;
-    pagesText_.clear();
+void MainWindow::whenPagesTextLoaded(std::function<void()> then) {
     // Only for PDFs in this build
     auto pv = qobject_cast<PdfViewerWidget*>(viewer_);
-    if (!pv || !pv->document()) return false;
-    QPdfDocument* doc = pv->document();
-    const int pageCount = doc->pageCount();
-    if (pageCount <= 0) return false;
-    const bool hasPdfToText = !QStandardPaths::findExecutable("pdftotext").isEmpty();
-    for (int i = 1; i <= pageCount; ++i) {
-        QString pageText;
-        if (hasPdfToText) {
-            QProcess proc;
-            QStringList args; args << "-q" << "-layout" << "-eol" << "unix" << "-f" << QString::number(i) << "-l" << QString::number(i) << currentFilePath_ << "-";
-            proc.start("pdftotext", args);
-            if (proc.waitForStarted(2000)) {
-                proc.waitForFinished(20000);
-                pageText = QString::fromUtf8(proc.readAllStandardOutput());
-            }
+    if (pagesTextLoaded_ || !pv || !pv->document()) { then(); return; }
+    // The search thread reads the cache or extracts the text (resuming the preload); never here
+    pagesTextWaiters_ << std::move(then);
+    if (pagesTextRequest_) return;
+    const QString pdfPath = currentFilePath_;
+    pagesTextRequest_ = searchService_->submit(searchRequest(SearchService::Lane::PageText, QString()), this,
+                                               [this, pdfPath](const SearchService::Result& res) {
+        pagesTextRequest_ = 0;
+        if (pdfPath != currentFilePath_) return;
+        if (!pagesTextLoaded_) {
+            pagesText_ = res.pageTexts;
+            pagesTextLoaded_ = !pagesText_.isEmpty();
         }
-        pagesText_ << pageText;
-    }
-    pagesTextLoaded_ = !pagesText_.isEmpty();
-    return pagesTextLoaded_;
+        runPagesTextWaiters();
+    });
 }
 
-QList<int> MainWindow::plainTextSearchPages(const QString& needle, int maxResults) {
-    QList<int> pages;
-    if (!ensurePagesTextLoaded()) return pages;
-    const QString n = needle.trimmed(); if (n.isEmpty()) return pages;
-    for (int i = 0; i < pagesText_.size(); ++i) {
-        if (pagesText_[i].contains(n, Qt::CaseInsensitive)) {
-            pages.append(i + 1);
-            if (pages.size() >= maxResults) break;
-        }
-    }
-    return pages;
+void MainWindow::runPagesTextWaiters() {
+    // A continuation may ask for the text again: it finds it loaded (or the list already taken)
+    const QList<std::function<void()>> waiters = std::exchange(pagesTextWaiters_, {});
+    for (const auto& then : waiters) then();
 }
 
-QList<int> MainWindow::semanticSearchPages(const QString& query, int k) {
-    QList<int> pages;
-    IndexPaths paths; if (!getIndexPaths(&paths)) return pages;
-    // Load index
-    VectorIndex index;
-    QString err;
-    if (!index.load(paths.binPath, paths.idsPath, &err)) {
-        qWarning() << "[Search] Falha ao carregar índice:" << err;
-        return pages;
-    }
-    // Build embedding for query
-    QSettings s;
-    EmbeddingProvider::Config cfg;
-    cfg.provider = s.value("emb/provider", "generativa").toString();
-    cfg.model = s.value("emb/model", "nomic-embed-text:latest").toString();
-    cfg.baseUrl = s.value("emb/base_url").toString();
-    cfg.apiKey = s.value("emb/api_key").toString();
-    EmbeddingProvider prov(cfg);
-    // Minimal normalization (match indexer behavior): collapse whitespace and trim
-    QString qnorm = query;
-    qnorm.replace(QRegularExpression("\\s+"), " ");
-    qnorm = qnorm.trimmed();
-    QList<QVector<float>> qv;
-    try { qv = prov.embedBatch(QStringList{qnorm}); }
-    catch (const std::exception& ex) {
-        qWarning() << "[Search] embed query failed:" << ex.what();
-        return pages;
-    }
-    if (qv.isEmpty()) return pages;
-    // Resolve Top-K and metric from settings
-    const int topK = s.value("emb/top_k", qMax(1, k)).toInt();
-    const QString metricStr = s.value("emb/similarity_metric", "cosine").toString();
-    VectorIndex::Metric metric = VectorIndex::Metric::Cosine;
-    if (metricStr == QLatin1String("dot")) metric = VectorIndex::Metric::Dot;
-    else if (metricStr == QLatin1String("l2")) metric = VectorIndex::Metric::L2;
-    const auto hitsAll = index.topK(qv.first(), qMax(1, topK), metric);
-    // Apply thresholds
-    const double simThreshold = s.value("emb/sim_threshold", 0.35).toDouble();
-    const double l2Max = s.value("emb/l2_max_distance", 1.5).toDouble();
-    QList<VectorIndex::Hit> hits;
-    hits.reserve(hitsAll.size());
-    for (const auto& h : hitsAll) {
-        bool keep = true;
-        if (metric == VectorIndex::Metric::L2) {
-            // score = -distance; keep if distance <= l2Max => score >= -l2Max
-            keep = (double(h.score) >= -l2Max);
-        } else {
-            // cosine/dot similarity: keep if score >= simThreshold
-            keep = (double(h.score) >= simThreshold);
-        }
-        if (keep) hits.append(h);
+SearchService::Request MainWindow::searchRequest(SearchService::Lane lane, const QString& query) const {
+    SearchService::Request r;
+    r.lane = lane;
+    r.pdfPath = currentFilePath_;
+    r.dbDir = settings_.value("emb/db_path", QDir(QDir::home().filePath(".cache")).filePath("br.tec.rapport.genai-reader")).toString();
+    r.query = query;
+    IndexPaths paths;
+    if (getIndexPaths(&paths)) {
+        r.index.containerPath = paths.containerPath;
+        r.index.binPath = paths.binPath;
+        r.index.idsPath = paths.idsPath;
+        r.index.metaPath = paths.metaPath;
+        r.index.hnswPath = paths.hnswPath;
+        r.index.q8Path = paths.q8Path;
     }
-    if (hits.isEmpty()) return pages;
-    QFile f(paths.metaPath);
-    if (!f.open(QIODevice::ReadOnly)) return pages;
-    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll()); f.close();
-    if (!doc.isArray()) return pages;
-    const QJsonArray arr = doc.array();
-    QSet<int> seen;
-    for (const auto& h : hits) {
-        if (h.index < 0 || h.index >= arr.size()) continue;
-        const int page = arr.at(h.index).toObject().value("page").toInt();
-        if (page > 0 && !seen.contains(page)) { pages.append(page); seen.insert(page); }
-        if (pages.size() >= k) break;
-    }
-    return pages;
+    return r;
+}
+
+void MainWindow::invalidateSearchIndex() {
+    if (searchService_) searchService_->invalidateIndex();
 }
 
 void MainWindow::onSearchTriggered() {
@@ -1226,11 +1227,41 @@ void MainWindow::onSearchTriggered() {
     const QString q = searchEdit_->text().trimmed();
     if (q.isEmpty()) return;
     beginSearchProgress(tr("Pesquisando..."), tr("[consulta] %1").arg(q));
-    // 1) Plain text search across pages
-    QList<int> pages = plainTextSearchPages(q);
-    // 2) Semantic search (RAG) if no plain hits
+    // 1) Hybrid search on the search thread: text (BM25) and embeddings, when the document has
+    //    an index, fused into one ranking; text hits are shown while the query is embedded
+    SearchService::Request r = searchRequest(SearchService::Lane::Search, q);
+    r.mode = SearchService::Mode::Hybrid;
+    r.k = 20;
+    searchResultsPages_.clear();
+    searchResultIdx_ = -1;
+    searchRequest_ = searchService_->submit(r, this, [this, q](const SearchService::Result& res) {
+        searchRequest_ = 0;
+        if (!res.error.isEmpty()) logSearchProgress(tr("[erro] %1").arg(res.error));
+        // Best hits first, with the passage that matched (or the chunk) when the page text is at hand
+        constexpr int kLoggedHits = 5;
+        constexpr int kChunkPreview = 120;
+        for (int i = 0; i < qMin(kLoggedHits, int(res.chunks.size())); ++i) {
+            const SearchService::ChunkHit& h = res.chunks.at(i);
+            const bool match = h.matchStart >= 0;
+            const int page = match ? h.matchPage : h.page;
+            const QString kind = !h.vectorRank ? tr("texto") : (h.lexicalRank ? tr("texto+semântica") : tr("semântica"));
+            QString snippet;
+            if (pagesTextLoaded_) {
+                const QString text = pagesText_.value(page - 1);
+                const int chunkEnd = h.endPage == h.page ? h.endOffset : int(text.size());
+                snippet = match ? hitSnippet(text, h.matchStart, h.matchEnd)
+                                : hitSnippet(text, h.startOffset, qMin(chunkEnd, h.startOffset + kChunkPreview));
+            }
+            logSearchProgress(snippet.isEmpty() ? tr("[%1] p. %2").arg(kind).arg(page) : tr("[%1] p. %2: %3").arg(kind).arg(page).arg(snippet));
+        }
+        showPlainSearchResults(q, res.pages, res.semantic);
+    });
+}
+
+void MainWindow::showPlainSearchResults(const QString& q, const QList<int>& pages, bool semantic) {
+    // 2) Semantic search (RAG: translated query, index created on demand) if nothing was found
     if (pages.isEmpty()) {
-        logSearchProgress(tr("[info] Nenhum resultado por texto simples. Iniciando busca semântica (RAG)..."));
+        logSearchProgress(tr("[info] Nenhum resultado na busca híbrida. Iniciando busca semântica (RAG)..."));
         startRagSearch(q);
         return;
     }
@@ -1242,7 +1273,8 @@ void MainWindow::onSearchTriggered() {
         if (auto vw = qobject_cast<ViewerWidget*>(viewer_)) { vw->setCurrentPage(static_cast<unsigned int>(page)); }
         updateStatus();
         statusBar()->showMessage(tr("%1 resultado(s)").arg(searchResultsPages_.size()), 2000);
-        logSearchProgress(tr("[ok] %1 resultado(s) por texto simples. Página atual: %2").arg(searchResultsPages_.size()).arg(page));
+        logSearchProgress((semantic ? tr("[ok] %1 resultado(s) por busca híbrida (texto + semântica). Página atual: %2")
+                                    : tr("[ok] %1 resultado(s) por texto simples. Página atual: %2")).arg(searchResultsPages_.size()).arg(page));
         endSearchProgress();
 
         // Agentic mode: if query is longer, show constructed RAG prompt in chat dock and use LLM (LlmClient)
@@ -1268,42 +1300,44 @@ void MainWindow::onSearchTriggered() {
                 chatDock_->setAgenticPrompt(prompt);
                 chatDock_->showAgenticPrompt(true);
 
-                // Build RAG context from retrieved pages (use cached plain text if available)
-                ensurePagesTextLoaded();
-                QString ctx;
-                int take = qMin(5, pages.size());
-                for (int i = 0; i < take; ++i) {
-                    const int pg = pages.at(i);
-                    QString snippet;
-                    if (pg-1 >= 0 && pg-1 < pagesText_.size()) {
-                        snippet = pagesText_.at(pg-1).left(1000);
+                // The page text may still be on its way from the search thread
+                whenPagesTextLoaded([this, q, pages]() {
+                    // Build RAG context from retrieved pages
+                    QString ctx;
+                    int take = qMin(5, pages.size());
+                    for (int i = 0; i < take; ++i) {
+                        const int pg = pages.at(i);
+                        QString snippet;
+                        if (pg-1 >= 0 && pg-1 < pagesText_.size()) {
+                            snippet = pagesText_.at(pg-1).left(1000);
+                        }
+                        ctx += tr("[Página %1]\n%2\n\n").arg(pg).arg(snippet);
                     }
-                    ctx += tr("[Página %1]\n%2\n\n").arg(pg).arg(snippet);
-                }
 
-                // Send to chat using LlmClient settings (ai/*)
-                if (chatDock_) chatDock_->appendUser(q);
-                if (llm_) {
-                    QList<QPair<QString,QString>> msgs;
-                    const QString sys = tr("Você é um assistente que responde com base no conteúdo do documento fornecido.\n"
-                                           "Use apenas as informações relevantes do contexto, cite páginas quando útil, não invente.");
-                    msgs.append({QStringLiteral("system"), sys});
-                    const QString user = tr("Pergunta:\n%1\n\nContexto (trechos do PDF):\n%2").arg(q, ctx);
-                    msgs.append({QStringLiteral("user"), user});
-                    statusBar()->showMessage(tr("Consultando IA com contexto RAG..."));
-                    llm_->chatWithMessages(msgs, [this](QString out, QString err){
-                        QMetaObject::invokeMethod(this, [this, out, err](){
-                            if (!err.isEmpty()) {
-                                showLongAlert(tr("Erro na IA"), err);
+                    // Send to chat using LlmClient settings (ai/*)
+                    if (chatDock_) chatDock_->appendUser(q);
+                    if (llm_) {
+                        QList<QPair<QString,QString>> msgs;
+                        const QString sys = tr("Você é um assistente que responde com base no conteúdo do documento fornecido.\n"
+                                               "Use apenas as informações relevantes do contexto, cite páginas quando útil, não invente.");
+                        msgs.append({QStringLiteral("system"), sys});
+                        const QString user = tr("Pergunta:\n%1\n\nContexto (trechos do PDF):\n%2").arg(q, ctx);
+                        msgs.append({QStringLiteral("user"), user});
+                        statusBar()->showMessage(tr("Consultando IA com contexto RAG..."));
+                        llm_->chatWithMessages(msgs, [this](QString out, QString err){
+                            QMetaObject::invokeMethod(this, [this, out, err](){
+                                if (!err.isEmpty()) {
+                                    showLongAlert(tr("Erro na IA"), err);
+                                    statusBar()->clearMessage();
+                                    return;
+                                }
+                                if (chatDock_) chatDock_->appendAssistant(out);
                                 statusBar()->clearMessage();
-                                return;
-                            }
-                            if (chatDock_) chatDock_->appendAssistant(out);
-                            statusBar()->clearMessage();
-                            saveChatForCurrentFile();
+                                saveChatForCurrentFile();
+                            });
                         });
-                    });
-                }
+                    }
+                });
             }
         }
     } else {
@@ -1512,6 +1546,9 @@ void MainWindow::onRequestRebuildEmbeddings() {
     const int pauseMsBetweenBatches = s.value("emb/pause_ms_between_batches", 0).toInt();
     QDir().mkpath(dbPath);
 
+    // Release the resident index: the rebuild replaces its files
+    invalidateSearchIndex();
+
     // Configure worker
     EmbeddingIndexer::Params params;
     params.pdfPath = currentFilePath_;
@@ -1525,6 +1562,7 @@ void MainWindow::onRequestRebuildEmbeddings() {
     params.batchSize = batchSize;
     params.pagesPerStage = pagesPerStage;
     params.pauseMsBetweenBatches = pauseMsBetweenBatches;
+    applyIndexerSettings(s, &params);
 
     auto* worker = new EmbeddingIndexer(params);
     auto* thread = new QThread(&dlg);
@@ -1546,6 +1584,9 @@ void MainWindow::onRequestRebuildEmbeddings() {
     if (thread->isRunning()) { thread->requestInterruption(); thread->quit(); thread->wait(1000); }
 
     if (bar->value() == 100) {
+        // Reread the page text and the full-text index, now with OCR text
+        pagesTextLoaded_ = false;
+        invalidateSearchIndex();
         statusBar()->showMessage(tr("Embeddings recriados."), 3000);
     }
 }
@@ -1854,6 +1895,14 @@ void MainWindow::createActions() {
     connect(simThresholdSpin_, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double v){ QSettings s; s.setValue("emb/sim_threshold", v); });
     connect(l2MaxDistSpin_, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double v){ QSettings s; s.setValue("emb/l2_max_distance", v); });
     connect(searchEdit_, &QLineEdit::returnPressed, this, &MainWindow::onSearchTriggered);
+    // Editing the query abandons the search still running for the previous one
+    connect(searchEdit_, &QLineEdit::textEdited, this, [this](const QString&) {
+        if (!searchRequest_) return;
+        searchService_->cancel(SearchService::Lane::Search);
+        searchRequest_ = 0;
+        logSearchProgress(tr("[cancelado] Consulta alterada."));
+        endSearchProgress();
+    });
     connect(searchButton_, &QPushButton::clicked, this, &MainWindow::onSearchTriggered);
     connect(searchPrevButton_, &QPushButton::clicked, this, &MainWindow::onSearchPrev);
     connect(searchNextButton_, &QPushButton::clicked, this, &MainWindow::onSearchNext);
@@ -1945,6 +1994,29 @@ bool entryMatches(const QVariantMap& e, const QString& needle) {
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent), settings_() {
+    // Search runs on its own thread; created first since loadSettings() may reopen the last file
+    searchService_ = new SearchService(this);
+    connect(searchService_, &SearchService::progress, this, [this](qint64 id, const QString& line) {
+        if (id == searchRequest_) logSearchProgress(line);
+    });
+    connect(searchService_, &SearchService::partialResults, this, [this](qint64 id, const QList<int>& pages) {
+        if (id != searchRequest_ || pages.isEmpty()) return;
+        const bool first = searchResultsPages_.isEmpty();
+        searchResultsPages_ = pages;
+        if (first) {
+            searchResultIdx_ = 0;
+            if (auto pv = qobject_cast<PdfViewerWidget*>(viewer_)) { pv->setCurrentPage(static_cast<unsigned int>(pages.first())); pv->flashHighlight(); }
+            if (auto vw = qobject_cast<ViewerWidget*>(viewer_)) { vw->setCurrentPage(static_cast<unsigned int>(pages.first())); }
+            updateStatus();
+        }
+        logSearchProgress(tr("[parcial] %1 resultado(s) até agora (página %2)").arg(pages.size()).arg(pages.last()));
+    });
+    connect(searchService_, &SearchService::pagesTextReady, this, [this](const QString& pdfPath, const QStringList& pages) {
+        if (pdfPath != currentFilePath_ || pagesTextLoaded_) return;
+        pagesText_ = pages;
+        pagesTextLoaded_ = !pagesText_.isEmpty();
+        if (pagesTextLoaded_) runPagesTextWaiters();
+    });
     buildUi();
     createActions();
     loadSettings();
@@ -2091,28 +2163,31 @@ QString MainWindow::detectDocumentLanguageSample() const {
 }
 
 void MainWindow::detectDocumentLanguageAsync(std::function<void(QString)> onLang) {
-    const QString sample = detectDocumentLanguageSample();
-    if (!llm_ || sample.trimmed().isEmpty()) { if (onLang) onLang(QStringLiteral("pt")); return; }
-    showChatPanel();
-    if (chatDock_) {
-        chatDock_->appendAssistant(tr("[LLM] Detectando idioma do documento a partir de amostra..."));
-    }
-    QList<QPair<QString,QString>> msgs;
-    msgs.append({QStringLiteral("system"), tr("Responda apenas com o código ISO 639-1 do idioma predominante do texto do usuário.")});
-    msgs.append({QStringLiteral("user"), sample});
-    llm_->chatWithMessages(msgs, [this, onLang](QString out, QString err){
-        QMetaObject::invokeMethod(this, [this, onLang, out, err]{
-            QString lang = QStringLiteral("pt");
-            if (err.isEmpty()) {
-                lang = out.trimmed().toLower();
-                if (lang.size()>2) lang = lang.left(2);
-                if (lang.isEmpty()) lang = QStringLiteral("pt");
-            }
-            if (auto cd = this->chatDock_) {
-                if (!err.isEmpty()) cd->appendAssistant(tr("[LLM] Erro ao detectar idioma: %1").arg(err));
-                else cd->appendAssistant(tr("[LLM] Idioma detectado: %1").arg(lang));
-            }
-            if (onLang) onLang(lang);
+    // The sample is cut from the page text, which the search thread may still be loading
+    whenPagesTextLoaded([this, onLang]() {
+        const QString sample = detectDocumentLanguageSample();
+        if (!llm_ || sample.trimmed().isEmpty()) { if (onLang) onLang(QStringLiteral("pt")); return; }
+        showChatPanel();
+        if (chatDock_) {
+            chatDock_->appendAssistant(tr("[LLM] Detectando idioma do documento a partir de amostra..."));
+        }
+        QList<QPair<QString,QString>> msgs;
+        msgs.append({QStringLiteral("system"), tr("Responda apenas com o código ISO 639-1 do idioma predominante do texto do usuário.")});
+        msgs.append({QStringLiteral("user"), sample});
+        llm_->chatWithMessages(msgs, [this, onLang](QString out, QString err){
+            QMetaObject::invokeMethod(this, [this, onLang, out, err]{
+                QString lang = QStringLiteral("pt");
+                if (err.isEmpty()) {
+                    lang = out.trimmed().toLower();
+                    if (lang.size()>2) lang = lang.left(2);
+                    if (lang.isEmpty()) lang = QStringLiteral("pt");
+                }
+                if (auto cd = this->chatDock_) {
+                    if (!err.isEmpty()) cd->appendAssistant(tr("[LLM] Erro ao detectar idioma: %1").arg(err));
+                    else cd->appendAssistant(tr("[LLM] Idioma detectado: %1").arg(lang));
+                }
+                if (onLang) onLang(lang);
+            });
         });
     });
 }
@@ -2139,7 +2214,6 @@ void MainWindow::translateQueryIfNeededAsync(const QString& query, const QString
 
 void MainWindow::startRagSearch(const QString& userQuery) {
     pendingRagQuery_ = userQuery;
-    ensurePagesTextLoaded();
     // Mirror the user's search query into chat
     showChatPanel();
     if (chatDock_) chatDock_->appendUser(tr("/buscar: %1").arg(userQuery));
@@ -2176,6 +2250,8 @@ void MainWindow::ensureIndexAvailableThen(const QString& translatedQuery) {
     p.batchSize = s.value("emb/batch_size", 16).toInt();
     p.pagesPerStage = s.value("emb/pages_per_stage", -1).toInt();
     p.pauseMsBetweenBatches = s.value("emb/pause_ms_between_batches", 0).toInt();
+    applyIndexerSettings(s, &p);
+    invalidateSearchIndex();
 
     auto* thread = new QThread(this);
     auto* indexer = new EmbeddingIndexer(p);
@@ -2192,58 +2268,76 @@ void MainWindow::ensureIndexAvailableThen(const QString& translatedQuery) {
         thread->deleteLater();
         if (!ok) { statusBar()->showMessage(tr("Falha ao criar o índice."), 3000); logSearchProgress(tr("[erro] Falha ao criar o índice.")); endSearchProgress(); return; }
         logSearchProgress(tr("[ok] Índice criado."));
+        // Reread the page text and the full-text index, now with OCR text
+        pagesTextLoaded_ = false;
+        invalidateSearchIndex();
         continueRagAfterEnsureIndex(translatedQuery);
     });
     thread->start();
 }
 
 void MainWindow::continueRagAfterEnsureIndex(const QString& translatedQuery) {
-    QList<int> pages = semanticSearchPages(translatedQuery);
-    if (!pages.isEmpty()) {
-        searchResultsPages_ = pages;
-        searchResultIdx_ = 0;
-        const int page = searchResultsPages_.at(searchResultIdx_);
-        if (auto pv = qobject_cast<PdfViewerWidget*>(viewer_)) { pv->setCurrentPage(static_cast<unsigned int>(page)); pv->flashHighlight(); }
-        if (auto vw = qobject_cast<ViewerWidget*>(viewer_)) { vw->setCurrentPage(static_cast<unsigned int>(page)); }
-        updateStatus();
-        statusBar()->showMessage(tr("%1 resultado(s)").arg(searchResultsPages_.size()), 2000);
-        logSearchProgress(tr("[ok] %1 resultado(s) por RAG. Página atual: %2").arg(searchResultsPages_.size()).arg(page));
-        endSearchProgress();
-    } else {
-        statusBar()->showMessage(tr("Nenhum resultado encontrado."), 2000);
-        logSearchProgress(tr("[info] Nenhum resultado encontrado."));
-        endSearchProgress();
-    }
+    SearchService::Request r = searchRequest(SearchService::Lane::Search, translatedQuery);
+    r.mode = SearchService::Mode::Hybrid;
+    r.k = 5;
+    searchRequest_ = searchService_->submit(r, this, [this](const SearchService::Result& res) {
+        searchRequest_ = 0;
+        if (!res.error.isEmpty()) logSearchProgress(tr("[erro] %1").arg(res.error));
+        const QList<int>& pages = res.pages;
+        if (!pages.isEmpty()) {
+            searchResultsPages_ = pages;
+            searchResultIdx_ = 0;
+            const int page = searchResultsPages_.at(searchResultIdx_);
+            if (auto pv = qobject_cast<PdfViewerWidget*>(viewer_)) { pv->setCurrentPage(static_cast<unsigned int>(page)); pv->flashHighlight(); }
+            if (auto vw = qobject_cast<ViewerWidget*>(viewer_)) { vw->setCurrentPage(static_cast<unsigned int>(page)); }
+            updateStatus();
+            statusBar()->showMessage(tr("%1 resultado(s)").arg(searchResultsPages_.size()), 2000);
+            logSearchProgress(tr("[ok] %1 resultado(s) por RAG. Página atual: %2").arg(searchResultsPages_.size()).arg(page));
+            endSearchProgress();
+        } else {
+            statusBar()->showMessage(tr("Nenhum resultado encontrado."), 2000);
+            logSearchProgress(tr("[info] Nenhum resultado encontrado."));
+            endSearchProgress();
+        }
+    });
 }
 
 // ---- RAG-driven Q&A helpers (chat) ----
 
-QString MainWindow::buildRagContextFromPages(const QList<int>& pages, int maxChars) {
-    if (!ensurePagesTextLoaded()) return QString();
-    QString ctx;
-    int remaining = qMax(1000, maxChars);
-    for (int i = 0; i < pages.size(); ++i) {
-        const int p = pages.at(i);
-        const int idx = p - 1;
-        if (idx < 0 || idx >= pagesText_.size()) continue;
-        QString t = pagesText_.at(idx);
-        t.replace(QRegularExpression("\\s+"), " ");
-        if (t.size() > remaining - 80) {
-            t = t.left(qMax(0, remaining - 80));
-        }
-        const QString header = tr("[Página %1]\n").arg(p);
-        const int chunkLen = header.size() + t.size() + 2;
-        if (chunkLen <= remaining) {
-            ctx += header;
-            ctx += t.trimmed();
-            ctx += "\n\n";
-            remaining -= chunkLen;
-            if (remaining <= 0) break;
+QString MainWindow::buildRagContext(const SearchService::Result& res, int maxTokens) {
+    if (!pagesTextLoaded_) return QString(); // callers wait with whenPagesTextLoaded()
+    // Retrieved passages, best first: chunk spans, else the page around its text match (or the
+    // top of the page, for a vector hit of an index without spans)
+    QList<RagContextBuilder::Passage> passages;
+    for (const SearchService::ChunkHit& h : res.chunks) {
+        RagContextBuilder::Passage p;
+        if (h.chunk >= 0 && h.startOffset >= 0) {
+            p.page = h.page;
+            p.start = h.startOffset;
+            p.endPage = h.endPage;
+            p.end = h.endOffset;
         } else {
-            break;
+            p.page = h.matchPage > 0 ? h.matchPage : h.page;
+            p.matchStart = h.matchPage > 0 ? h.matchStart : -1;
+            p.matchEnd = h.matchEnd;
+        }
+        passages << p;
+    }
+    // Plain-text search (no index): the page matches
+    if (passages.isEmpty()) {
+        for (const FullTextIndex::Hit& h : res.textHits) {
+            RagContextBuilder::Passage p;
+            p.page = h.page;
+            if (!h.spans.isEmpty()) { p.matchStart = h.spans.first().start; p.matchEnd = h.spans.first().end; }
+            passages << p;
         }
     }
-    return ctx.trimmed();
+    RagContextBuilder::Params params;
+    params.maxTokens = maxTokens;
+    params.neighbourChars = settings_.value("rag/context_neighbour_chars", params.neighbourChars).toInt();
+    const RagContextBuilder::Context ctx = RagContextBuilder(params).build(pagesText_, passages);
+    qInfo() << "[RAG] contexto:" << ctx.blocks.size() << "trechos de" << passages.size() << "," << ctx.tokens << "tokens (estimados), páginas" << ctx.pages;
+    return ctx.text;
 }
 
 void MainWindow::answerQuestionWithRag(const QString& userQuery) {
@@ -2268,16 +2362,17 @@ void MainWindow::ensureIndexAvailableThenForAnswer(const QString& translatedQuer
         QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
     if (ret != QMessageBox::Yes) {
         // Fallback: try plain-text search for a quick best-effort answer
-        QList<int> pages = plainTextSearchPages(translatedQuery, 3);
-        if (!pages.isEmpty()) {
-            if (auto pv = qobject_cast<PdfViewerWidget*>(viewer_)) { pv->setCurrentPage(static_cast<unsigned int>(pages.first())); pv->flashHighlight(); }
-            if (auto vw = qobject_cast<ViewerWidget*>(viewer_)) { vw->setCurrentPage(static_cast<unsigned int>(pages.first())); }
-            continueRagAnswer(translatedQuery);
-        } else {
-            if (chatDock_) chatDock_->appendAssistant(tr("Não há índice de embeddings e não foi possível encontrar contexto. Gere os embeddings para habilitar respostas fundamentadas."));
-            statusBar()->clearMessage();
-            ragAnswerInProgress_ = false;
-        }
+        SearchService::Request r = searchRequest(SearchService::Lane::Answer, translatedQuery);
+        r.k = 3;
+        searchService_->submit(r, this, [this, translatedQuery](const SearchService::Result& res) {
+            if (!res.pages.isEmpty()) {
+                whenPagesTextLoaded([this, translatedQuery, res]() { finishRagAnswer(translatedQuery, res); });
+            } else {
+                if (chatDock_) chatDock_->appendAssistant(tr("Não há índice de embeddings e não foi possível encontrar contexto. Gere os embeddings para habilitar respostas fundamentadas."));
+                statusBar()->clearMessage();
+                ragAnswerInProgress_ = false;
+            }
+        });
         return;
     }
     // Build and run indexer
@@ -2296,6 +2391,8 @@ void MainWindow::ensureIndexAvailableThenForAnswer(const QString& translatedQuer
     ip.chunkOverlap = s.value("emb/chunk_overlap", 100).toInt();
     ip.batchSize = s.value("emb/batch_size", 16).toInt();
     ip.pauseMsBetweenBatches = s.value("emb/pause_ms", 0).toInt();
+    applyIndexerSettings(s, &ip);
+    invalidateSearchIndex();
 
     auto* thread = new QThread(this);
     auto* indexer = new EmbeddingIndexer(ip);
@@ -2307,16 +2404,29 @@ void MainWindow::ensureIndexAvailableThenForAnswer(const QString& translatedQuer
             if (chatDock_) chatDock_->appendAssistant(tr("Falha ao criar o índice. Não foi possível responder com base no livro."));
             statusBar()->clearMessage(); ragAnswerInProgress_ = false; return;
         }
+        // Reread the page text and the full-text index, now with OCR text
+        pagesTextLoaded_ = false;
+        invalidateSearchIndex();
         continueRagAnswer(translatedQuery);
     });
     thread->start();
 }
 
 void MainWindow::continueRagAnswer(const QString& translatedQuery) {
-    // Retrieve top-k pages using vector index when available; else plain text
-    QList<int> semPages = semanticSearchPages(translatedQuery, qMax(1, settings_.value("emb/top_k", 5).toInt()));
-    QList<int> pages = semPages;
-    if (pages.isEmpty()) pages = plainTextSearchPages(translatedQuery, 3);
+    // Retrieve top-k pages: text (BM25) and vector hits fused in one pass; text only without an
+    // index. The best fused hits are then reordered by the reranker, when one is configured.
+    SearchService::Request r = searchRequest(SearchService::Lane::Answer, translatedQuery);
+    r.mode = SearchService::Mode::Hybrid;
+    r.rerank = true;
+    r.k = qMax(1, settings_.value("emb/top_k", 5).toInt());
+    searchService_->submit(r, this, [this, translatedQuery](const SearchService::Result& res) {
+        // The context is cut from the page text: wait for it if the search thread is still loading it
+        whenPagesTextLoaded([this, translatedQuery, res]() { finishRagAnswer(translatedQuery, res); });
+    });
+}
+
+void MainWindow::finishRagAnswer(const QString& translatedQuery, const SearchService::Result& res) {
+    const QList<int>& pages = res.pages;
     if (!pages.isEmpty()) {
         const int best = pages.first();
         if (auto pv = qobject_cast<PdfViewerWidget*>(viewer_)) { pv->setCurrentPage(static_cast<unsigned int>(best)); pv->flashHighlight(); }
@@ -2328,12 +2438,14 @@ void MainWindow::continueRagAnswer(const QString& translatedQuery) {
             if (!ps.isEmpty()) chatDock_->appendAssistant(tr("[RAG] Resultados: páginas %1").arg(ps.join(", ")));
         }
     }
-    // Build grounded context from the top pages (configurable max chars)
+    // Build grounded context from the retrieved passages within a token budget (configurable;
+    // defaults to the former character budget at ~4 characters per token)
     const int ctxChars = qBound(1500,
                                 settings_.value("ai/rag_context_chars",
                                                 settings_.value("rag/context_max_chars", 4000).toInt()).toInt(),
                                 8000);
-    const QString context = buildRagContextFromPages(pages.mid(0, 3), ctxChars);
+    const int ctxTokens = qBound(300, settings_.value("rag/context_max_tokens", ctxChars / 4).toInt(), 8000);
+    const QString context = buildRagContext(res, ctxTokens);
 
     QList<QPair<QString,QString>> msgs;
     // Guardrails and format: Section A (grounded) + Section B (beyond-the-book)
@@ -2864,7 +2976,7 @@ void MainWindow::openDictionarySettings() {
 void MainWindow::openEmbeddingSettings() {
     EmbeddingSettingsDialog dlg(this);
     connect(&dlg, &EmbeddingSettingsDialog::rebuildRequested, this, &MainWindow::onRequestRebuildEmbeddings);
-    dlg.exec();
+    if (dlg.exec() == QDialog::Accepted) invalidateSearchIndex(); // emb/model or index type may have changed
 }
 
 void MainWindow::saveSettings() {
@@ -3249,6 +3361,14 @@ bool MainWindow::openPath(const QString& file) {
         settings_.setValue("session/lastDir", fi.absolutePath());
         settings_.setValue("session/lastFile", fi.absoluteFilePath());
         currentFilePath_ = fi.absoluteFilePath();
+        invalidateSearchIndex(); // previous document's index is no longer needed
+        searchService_->cancelAll();
+        searchRequest_ = 0;
+        pagesText_.clear();
+        pagesTextLoaded_ = false;
+        pagesTextRequest_ = 0; // cancelled above; its waiters belonged to the previous document
+        pagesTextWaiters_.clear();
+        searchService_->preloadPagesText(currentFilePath_, settings_.value("emb/db_path", QDir(QDir::home().filePath(".cache")).filePath("br.tec.rapport.genai-reader")).toString());
 
         // Track in recent files
         addRecentFile(currentFilePath_);
@@ -25,6 +25,7 @@
 #include <QJsonObject>
 #include <QPixmap>
 #include <QLabel>
+#include <memory>
 
 // Forward declarations for UI types used as pointers in this header
 class QToolButton;
@@ -54,6 +55,7 @@ class OpfGenAiDialog;
 class SearchProgressDialog;
 
 #include "ui/OpfStore.h"
+#include "ai/SearchService.h"
 
 #include "reader/Reader.h"
 
@@ -219,13 +221,18 @@ private:
 
 private:
     // Search helpers
-    bool ensurePagesTextLoaded();
-    QList<int> plainTextSearchPages(const QString& needle, int maxResults = 20);
-    QList<int> semanticSearchPages(const QString& query, int k = 5);
+    // Runs then once pagesText_ holds the current PDF's text (or it could not be read), at once
+    // when it is already loaded; the text comes from the search thread
+    void whenPagesTextLoaded(std::function<void()> then);
+    void runPagesTextWaiters();
     QString sha1(const QString& s) const;
-    struct IndexPaths { QString base; QString binPath; QString idsPath; QString metaPath; };
+    struct IndexPaths { QString base; QString containerPath; QString binPath; QString idsPath; QString metaPath; QString hnswPath; QString q8Path; QString chunksPath; };
     bool getIndexPaths(IndexPaths* out) const;
     bool computeIndexPathsFor(const QString& filePath, IndexPaths* out) const;
+    // Request on the current document for searchService_ (page text, index files, db dir)
+    SearchService::Request searchRequest(SearchService::Lane lane, const QString& query) const;
+    void showPlainSearchResults(const QString& q, const QList<int>& pages, bool semantic);
+    void invalidateSearchIndex();
     void loadSearchOptionsFromSettings();
     void saveSearchOptionsToSettings(const QString& metricKey, int topK);
     // RAG pipeline helpers
@@ -248,7 +255,10 @@ private:
     void answerQuestionWithRag(const QString& userQuery);
     void ensureIndexAvailableThenForAnswer(const QString& translatedQuery);
     void continueRagAnswer(const QString& translatedQuery);
-    QString buildRagContextFromPages(const QList<int>& pages, int maxChars = 4000);
+    void finishRagAnswer(const QString& translatedQuery, const SearchService::Result& res);
+    // Book context of an answer: the retrieved passages packed into maxTokens (RagContextBuilder).
+    // Needs the page text loaded (see whenPagesTextLoaded)
+    QString buildRagContext(const SearchService::Result& res, int maxTokens);
 
     // Build a system message including the current e-book metadata (title, author, description, summary)
     // to be prepended to chat conversations with the LLM.
@@ -360,6 +370,13 @@ private:
     // Cache for plain text pages of current PDF
     QStringList pagesText_;
     bool pagesTextLoaded_ {false};
+    QList<std::function<void()>> pagesTextWaiters_; // whenPagesTextLoaded() continuations
+    qint64 pagesTextRequest_ {0};                   // PageText request in flight (0: none)
+
+    // Plain-text and semantic search on a worker thread; keeps the document's page text and
+    // vector index (+ HNSW graph / int8 codes) resident between searches
+    SearchService* searchService_ {nullptr};
+    qint64 searchRequest_ {0}; // search-bar request in flight (0: none)
 
     // When true, indicates the user explicitly started a brand-new chat session
     // and we must NOT auto-load any previously persisted chat upon showing the chat panel.
@@ -54,64 +54,65 @@ void MainWindow::onRequestSummarizeDocument() {
 
     statusBar()->showMessage(tr("Gerando resumo do e-book via IA..."));
 
-    // 2) Construir um contexto enxuto, amostrando páginas de todo o documento
-    QString context;
-    auto* pv = qobject_cast<PdfViewerWidget*>(viewer_);
-    if (pv && pv->document()) {
-        // Carregar cache de texto de páginas (usa pdftotext/OCR quando disponível)
-        ensurePagesTextLoaded();
-        const int pageCount = pv->document()->pageCount();
-        if (pageCount > 0 && !pagesText_.isEmpty()) {
-            const int targetSamples = 12; // amostrar ~12 trechos distribuídos
-            const int step = qMax(1, pageCount / targetSamples);
-            int taken = 0;
-            for (int p = 1; p <= pageCount && taken < targetSamples; p += step) {
-                const int idx = p - 1;
-                QString snippet;
-                if (idx >= 0 && idx < pagesText_.size()) {
-                    snippet = pagesText_.at(idx);
-                    // Normalização: colapsar espaços e limitar tamanho por trecho
-                    snippet.replace(QRegularExpression("\\s+"), " ");
-                    if (snippet.size() > 800) snippet = snippet.left(800);
-                }
-                if (!snippet.trimmed().isEmpty()) {
-                    context += tr("[Página %1]\n%2\n\n").arg(p).arg(snippet.trimmed());
-                    ++taken;
+    // O texto das páginas vem da thread de busca (cache ou extração em segundo plano)
+    whenPagesTextLoaded([this]() {
+        // 2) Construir um contexto enxuto, amostrando páginas de todo o documento
+        QString context;
+        auto* pv = qobject_cast<PdfViewerWidget*>(viewer_);
+        if (pv && pv->document()) {
+            const int pageCount = pv->document()->pageCount();
+            if (pageCount > 0 && !pagesText_.isEmpty()) {
+                const int targetSamples = 12; // amostrar ~12 trechos distribuídos
+                const int step = qMax(1, pageCount / targetSamples);
+                int taken = 0;
+                for (int p = 1; p <= pageCount && taken < targetSamples; p += step) {
+                    const int idx = p - 1;
+                    QString snippet;
+                    if (idx >= 0 && idx < pagesText_.size()) {
+                        snippet = pagesText_.at(idx);
+                        // Normalização: colapsar espaços e limitar tamanho por trecho
+                        snippet.replace(QRegularExpression("\\s+"), " ");
+                        if (snippet.size() > 800) snippet = snippet.left(800);
+                    }
+                    if (!snippet.trimmed().isEmpty()) {
+                        context += tr("[Página %1]\n%2\n\n").arg(p).arg(snippet.trimmed());
+                        ++taken;
+                    }
                 }
             }
         }
-    }
-    if (context.trimmed().isEmpty()) {
-        // Fallback simples
-        context = tr("Conteúdo não extraído. Forneça um resumo geral do e-book considerando que o texto completo não está disponível.");
-    }
+        if (context.trimmed().isEmpty()) {
+            // Fallback simples
+            context = tr("Conteúdo não extraído. Forneça um resumo geral do e-book considerando que o texto completo não está disponível.");
+        }
 
-    // 3) Enviar para a IA montar um resumo executivo do e-book
-    QList<QPair<QString,QString>> msgs;
-    const QString respLang = QSettings().value("ai/response_language", QStringLiteral("pt-BR")).toString();
-    const QString sys = tr("Você é um assistente que cria um resumo executivo e estruturado de um e-book em %1.\n"
-                           "Quando possível, cite páginas indicativas (entre colchetes) a partir dos trechos fornecidos.\n"
-                           "Não invente fatos não suportados.").arg(respLang);
-    msgs.append({QStringLiteral("system"), sys});
-    const QString user = tr("Gere um resumo do e-book atual com tópicos principais, objetivos, público, conceitos-chave e conclusões.\n\nTrechos amostrados do documento:\n%1").arg(context);
-    msgs.append({QStringLiteral("user"), user});
+        // 3) Enviar para a IA montar um resumo executivo do e-book
+        QList<QPair<QString,QString>> msgs;
+        const QString respLang = QSettings().value("ai/response_language", QStringLiteral("pt-BR")).toString();
+        const QString sys = tr("Você é um assistente que cria um resumo executivo e estruturado de um e-book em %1.\n"
+                               "Quando possível, cite páginas indicativas (entre colchetes) a partir dos trechos fornecidos.\n"
+                               "Não invente fatos não suportados.").arg(respLang);
+        msgs.append({QStringLiteral("system"), sys});
+        const QString user = tr("Gere um resumo do e-book atual com tópicos principais, objetivos, público, conceitos-chave e conclusões.\n\nTrechos amostrados do documento:\n%1").arg(context);
+        msgs.append({QStringLiteral("user"), user});
 
-    llm_->chatWithMessages(msgs, [this](QString out, QString err){
-        QMetaObject::invokeMethod(this, [this, out, err](){
-            if (!err.isEmpty()) {
-                showLongAlert(tr("Erro na IA"), err);
+        llm_->chatWithMessages(msgs, [this](QString out, QString err){
+            QMetaObject::invokeMethod(this, [this, out, err](){
+                if (!err.isEmpty()) {
+                    showLongAlert(tr("Erro na IA"), err);
+                    statusBar()->clearMessage();
+                    return;
+                }
+                if (summaryDlg_) {
+                    summaryDlg_->setWindowTitle(tr("Resumo do e-book"));
+                    summaryDlg_->setText(out);
+                    summaryDlg_->show();
+                    summaryDlg_->raise();
+                    summaryDlg_->activateWindow();
+                }
                 statusBar()->clearMessage();
-                return;
-            }
-            if (summaryDlg_) {
-                summaryDlg_->setWindowTitle(tr("Resumo do e-book"));
-                summaryDlg_->setText(out);
-                summaryDlg_->show();
-                summaryDlg_->raise();
-                summaryDlg_->activateWindow();
-            }
-            statusBar()->clearMessage();
-            saveChatForCurrentFile();
+                saveChatForCurrentFile();
+            });
         });
     });
 }
@@ -139,25 +140,27 @@ void MainWindow::handleLlmToolCalls(const QJsonArray& toolCalls) {
             const int page = args.value("page").toInt();
             toolGotoPage(page);
         } else if (name == QLatin1String("retrieve_passages")) {
-            // Return additional snippets for requested pages to the chat
-            QJsonArray arr = args.value("pages").toArray();
+            // Return additional snippets for requested pages to the chat (once the search thread
+            // has delivered the page text; at once when it is already loaded)
+            const QJsonArray arr = args.value("pages").toArray();
             if (arr.isEmpty()) continue;
-            if (!ensurePagesTextLoaded()) continue;
-            QStringList blocks;
-            for (const auto& v : arr) {
-                const int p = v.toInt();
-                if (p <= 0) continue;
-                const int idx = p - 1;
-                if (idx < 0 || idx >= pagesText_.size()) continue;
-                QString t = pagesText_.at(idx);
-                t.replace(QRegularExpression("\\s+"), " ");
-                if (t.size() > 1000) t = t.left(1000);
-                const QString block = tr("[Página %1]\n%2").arg(p).arg(t.trimmed());
-                blocks << block;
-            }
-            if (!blocks.isEmpty() && chatDock_) {
-                chatDock_->appendAssistant(blocks.join("\n\n"));
-            }
+            whenPagesTextLoaded([this, arr]() {
+                QStringList blocks;
+                for (const auto& v : arr) {
+                    const int p = v.toInt();
+                    if (p <= 0) continue;
+                    const int idx = p - 1;
+                    if (idx < 0 || idx >= pagesText_.size()) continue;
+                    QString t = pagesText_.at(idx);
+                    t.replace(QRegularExpression("\\s+"), " ");
+                    if (t.size() > 1000) t = t.left(1000);
+                    const QString block = tr("[Página %1]\n%2").arg(p).arg(t.trimmed());
+                    blocks << block;
+                }
+                if (!blocks.isEmpty() && chatDock_) {
+                    chatDock_->appendAssistant(blocks.join("\n\n"));
+                }
+            });
         } else if (name == QLatin1String("suggest_references")) {
             // The model may produce references itself; we can surface the topic intent in chat
             const QString topic = args.value("topic").toString();